@@ -17,7 +17,7 @@
 #define AUTON_TIME 15
 
 /**
- * Number of seconds the programming skills challenge lasts.
+ * Number of seconds the programming skills challenge lasts, which is how long a programming skills recording runs.
  */
 #define PROGSKILL_TIME 60
 
@@ -31,7 +31,7 @@
 /**
  * Maximum number of autonomous routines to be stored.
  */
-#define MAX_AUTON_SLOTS 10
+#define MAX_AUTON_SLOTS 20
 
 /**
  * Maximum file name length of autonomous routine files.
@@ -58,6 +58,19 @@
  */
 #define AUTON_POT_HIGH 440 //4095
 
+/**
+ * Boots without waiting for a routine to be picked on the LCD: the boot routine is chosen by getBootAutonSlot() and
+ * loaded in the background while the rest of the robot starts, so field control restarts come back quickly.
+ * Comment this out to pick the routine with selectAuton() every time the robot boots.
+ */
+#define AUTON_FAST_BOOT
+
+/**
+ * Chooses the boot routine with the AUTON_POT potentiometer instead of reloading the routine that was loaded last.
+ * The potentiometer's range from AUTON_POT_LOW to AUTON_POT_HIGH is split evenly between the choices of selectAuton().
+ */
+//#define AUTON_POT_SELECT
+
 /**
  * @brief Representation of the operator controller's instructions at a point in time.
  *
@@ -88,12 +101,434 @@ typedef struct joyState {
     signed char lift;
 } joyState;
 
+/**
+ * Size in bytes of a state in a file without a header, which stores spd, horizontal, turn, sht and lift in that order.
+ */
+#define AUTON_LEGACY_STATE_SIZE 5
+
+/**
+ * Magic number identifying an autonomous recorder file ("AREC" in little-endian byte order).
+ */
+#define AUTON_FILE_MAGIC 0x43455241
+
+/**
+ * Version of the autonomous file format that stores the states packed one after another.
+ */
+#define AUTON_FILE_VERSION_RAW 1
+
+/**
+ * Version of the autonomous file format that stores the states as autonRun structs.
+ * saveAuton() uses this format unless it would make the file larger than AUTON_FILE_VERSION_RAW.
+ */
+#define AUTON_FILE_VERSION_RLE 2
+
+/**
+ * Version of the autonomous file format that stores timestamped autonEvent structs instead of fixed-rate states.
+ */
+#define AUTON_FILE_VERSION_EVENTS 3
+
+/**
+ * Frequency in hertz at which the joystick is sampled while recording events.
+ */
+#define AUTON_EVENT_SAMPLE_FREQ 200
+
+/**
+ * Frequency in hertz at which recorded events are played back.
+ * Playback holds the most recent event at each tick, so this can be set independently of the sample rate.
+ */
+#define AUTON_EVENT_PLAYBACK_FREQ 200
+
+/**
+ * Frequency in hertz of the control loop when states are played back faster than they were recorded.
+ * Playback interpolates between the recorded states, so the motors follow the routine more smoothly than at JOY_POLL_FREQ.
+ */
+#define AUTON_FAST_PLAYBACK_FREQ 100
+
+/**
+ * Fastest playback speed in percent of the recorded speed.
+ */
+#define AUTON_MAX_PLAYBACK_SPEED 200
+
+/**
+ * Maximum number of events in an event recording.
+ * The joystick only updates at JOY_POLL_FREQ, so this holds a full AUTON_TIME of continuous stick movement and the end
+ * marker.
+ */
+#define AUTON_MAX_EVENTS (AUTON_TIME * JOY_POLL_FREQ + 1)
+
+/**
+ * Version of the autonomous file format that stores the drive sensor trace of a recording as autonSensorFrame structs.
+ * Sensor traces are saved in a separate file ("s" followed by the slot number) next to the states file.
+ */
+#define AUTON_FILE_VERSION_SENSORS 4
+
+/**
+ * Version of the file format that holds a routine of any length, such as a programming skills run, as chunks of
+ * AUTON_CHUNK_STATES states. Every chunk is run-length encoded on its own, and the autonChunkIndex stored before the
+ * trailer gives where each chunk starts, so playback can seek to any chunk without decoding the ones before it.
+ * The checksum in the header covers the index, and each index entry holds the checksum of its chunk.
+ */
+#define AUTON_FILE_VERSION_CHUNKED 5
+
+/**
+ * Set in the version of files whose header ends with the batteryLevel and reserved fields.
+ * Files written before the battery level was recorded have a header without them and are still accepted when loading.
+ */
+#define AUTON_FILE_FLAG_BATTERY 0x100
+
+/**
+ * Flag added to the version of a file streamed to flash while it was being recorded. The number of states, checksum and
+ * battery level are only known once recording ends, so they are left 0 in the header and a copy of the finished header
+ * follows the states.
+ */
+#define AUTON_FILE_FLAG_TRAILER 0x200
+
+/**
+ * Scales the motor outputs during playback by the ratio of the battery voltage a routine was recorded at to the
+ * current voltage, so routines run at the same speed regardless of charge.
+ * Comment this out to play routines back with the recorded motor power.
+ */
+#define AUTON_BATTERY_COMPENSATION
+
+/**
+ * Lowest battery voltage in millivolts, recorded or current, that compensation trusts; below it (for example when the
+ * Cortex is powered over USB) the recorded power is played back unchanged.
+ */
+#define AUTON_BATTERY_MIN_LEVEL 5000
+
+/**
+ * Largest factor in percent by which compensation raises motor power, on a battery flatter than at recording.
+ */
+#define AUTON_BATTERY_MAX_GAIN 130
+
+/**
+ * Smallest factor in percent to which compensation lowers motor power, on a battery fuller than at recording.
+ */
+#define AUTON_BATTERY_MIN_GAIN 70
+
+/**
+ * Number of playback ticks over which the current battery voltage is averaged, smoothing out the sag of single ticks.
+ */
+#define AUTON_BATTERY_FILTER 8
+
+/**
+ * Keeps the files of recently loaded routines in RAM, so that switching back to one of them does not read the flash.
+ * The cache takes AUTON_CACHE_SIZE bytes of the Cortex's 64 KB, so it is off by default; uncomment this to turn it on.
+ */
+//#define AUTON_CACHE
+
+/**
+ * Bytes of RAM that hold cached routine files; a full raw routine takes about 3.8 KB and a run-length encoded one much less.
+ */
+#define AUTON_CACHE_SIZE 8192
+
+/**
+ * Most routine files held in the cache at once. The least recently loaded one is dropped to make room for another.
+ */
+#define AUTON_CACHE_ENTRIES 6
+
+/**
+ * Records the drive sensors alongside each state and uses the trace to correct playback.
+ * The trace takes 6 bytes per state, 4.5 KB for a routine, so it is off by default; uncomment this to turn it on.
+ */
+//#define AUTON_SENSORS
+
+/**
+ * Proportional gain of the playback position correction, as a fraction of AUTON_SENSOR_KP_DEN.
+ * The correction in motor power is the position error in IME ticks times this gain.
+ */
+#define AUTON_SENSOR_KP_NUM 1
+
+/**
+ * Denominator of the playback position correction gain.
+ */
+#define AUTON_SENSOR_KP_DEN 2
+
+/**
+ * Largest correction in motor power that playback will add to a recorded command.
+ */
+#define AUTON_SENSOR_MAX_CORRECTION 40
+
+/**
+ * Longest run of identical states that a single autonRun can hold.
+ */
+#define AUTON_MAX_RUN_LENGTH 255
+
+/**
+ * Number of states in a full 15 second autonomous file.
+ */
+#define AUTON_NUM_STATES (AUTON_TIME * JOY_POLL_FREQ)
+
+/**
+ * Number of states in each chunk of an AUTON_FILE_VERSION_CHUNKED file, so that a chunk fills one playback buffer.
+ */
+#define AUTON_CHUNK_STATES AUTON_NUM_STATES
+
+/**
+ * Most chunks an AUTON_FILE_VERSION_CHUNKED file can hold, which limits a routine to 4 minutes.
+ */
+#define AUTON_MAX_CHUNKS 16
+
+/**
+ * Slot number of the programming skills file in the slot directory and for transfers.
+ */
+#define AUTON_SKILLS_SLOT -1
+
+/**
+ * @brief Header stored at the beginning of every autonomous file in flash memory.
+ *
+ * The header is immediately followed by numStates packed joyState structs, or by the autonRun structs that encode them.
+ * Files written before the header was introduced contain only the packed states and are still accepted when loading.
+ */
+typedef struct autonHeader {
+    /**
+     * Always AUTON_FILE_MAGIC.
+     */
+    uint32_t magic;
+    /**
+     * Format version of the file (one of the AUTON_FILE_VERSION_* values, combined with AUTON_FILE_FLAG_BATTERY on flash).
+     */
+    uint16_t version;
+    /**
+     * Number of joyState structs that follow the header.
+     */
+    uint16_t numStates;
+    /**
+     * Rate in hertz at which the states were recorded.
+     */
+    uint16_t pollFreq;
+    /**
+     * Fletcher-16 checksum of the packed states (after decoding).
+     */
+    uint16_t checksum;
+    /**
+     * Average main battery voltage in millivolts while the routine was recorded, or 0 if it is not known.
+     * Only present in files whose version has AUTON_FILE_FLAG_BATTERY set.
+     */
+    uint16_t batteryLevel;
+    /**
+     * Always zero; pads the header to a multiple of 4 bytes.
+     */
+    uint16_t reserved;
+} autonHeader;
+
+/**
+ * @brief Where one chunk of an AUTON_FILE_VERSION_CHUNKED file is stored.
+ */
+typedef struct autonChunk {
+    /**
+     * Offset of the chunk's first autonRun from the start of the file.
+     */
+    uint32_t offset;
+    /**
+     * Number of states in the chunk; every chunk but the last holds AUTON_CHUNK_STATES.
+     */
+    uint16_t numStates;
+    /**
+     * Fletcher-16 checksum of the packed states of the chunk (after decoding).
+     */
+    uint16_t checksum;
+} autonChunk;
+
+/**
+ * @brief Index of the chunks of an AUTON_FILE_VERSION_CHUNKED file, stored just before the trailer.
+ *
+ * The index always has room for AUTON_MAX_CHUNKS chunks, so it is found at a fixed distance from the end of the file.
+ */
+typedef struct autonChunkIndex {
+    /**
+     * Number of chunks in the file.
+     */
+    uint16_t numChunks;
+    /**
+     * Always zero; pads the index to a multiple of 4 bytes.
+     */
+    uint16_t reserved;
+    /**
+     * The chunks in playback order; entries past numChunks are zero.
+     */
+    autonChunk chunks[AUTON_MAX_CHUNKS];
+} autonChunkIndex;
+
+/**
+ * @brief A run of identical consecutive states in a run-length encoded autonomous file.
+ *
+ * Drivers usually hold a stick or button for many frames at a time, so most of a recording collapses into a few runs.
+ */
+typedef struct autonRun {
+    /**
+     * Number of consecutive frames (1 - AUTON_MAX_RUN_LENGTH) that hold this state.
+     */
+    unsigned char count;
+    /**
+     * The state held for the run.
+     */
+    joyState state;
+} autonRun;
+
+/**
+ * @brief Position of the drive at a recorded state, relative to where the recording started.
+ *
+ * The axes match drivePose and are stored as 16-bit values to keep the trace small.
+ */
+typedef struct autonSensorFrame {
+    /**
+     * Forward distance travelled in IME ticks.
+     */
+    int16_t forward;
+    /**
+     * Horizontal distance travelled in IME ticks.
+     */
+    int16_t horizontal;
+    /**
+     * Clockwise rotation, in degrees if a gyro is present or in IME ticks otherwise.
+     */
+    int16_t turn;
+} autonSensorFrame;
+
+/**
+ * @brief A change in the operator controller's instructions, stamped with the time it happened.
+ *
+ * Event recordings only store a state when it differs from the previous one, so holding a stick costs nothing.
+ * The final event of a recording marks its end and holds the stopped state.
+ */
+typedef struct autonEvent {
+    /**
+     * Milliseconds since the start of the recording at which this state took effect.
+     */
+    uint16_t time;
+    /**
+     * The state that took effect.
+     */
+    joyState state;
+    /**
+     * Always zero; pads the event to 8 bytes so that it contains no uninitialized padding.
+     */
+    unsigned char reserved;
+} autonEvent;
+
+/**
+ * @brief Adjustments applied to a routine when it is loaded, so that one recording can be played back in several variants.
+ *
+ * The transform is applied once to the loaded states (or events) by loadAuton() and the programming skills chunk loader,
+ * together with the mirroring chosen by autonFlipped, so playback does no extra work per tick.
+ */
+typedef struct autonTransform {
+    /**
+     * Gain of the forward/backward speed in percent.
+     */
+    int spdGain;
+    /**
+     * Gain of the turning speed in percent.
+     */
+    int turnGain;
+    /**
+     * Gain of the horizontal motion in percent.
+     */
+    int horizontalGain;
+    /**
+     * Gain of the dumper speed in percent.
+     */
+    int shtGain;
+    /**
+     * Length of the playback as a percentage of the recorded length, so 50 plays the routine twice as fast.
+     * Slowed down routines are cut off at the end of the autonomous period.
+     */
+    int timeScale;
+} autonTransform;
+
+/**
+ * Initializer for an autonTransform that leaves a routine unchanged.
+ */
+#define AUTON_TRANSFORM_IDENTITY { 100, 100, 100, 100, 100 }
+
+/**
+ * Largest gain in percent of an autonTransform; gains outside 0 to this are clamped when a routine is loaded.
+ */
+#define AUTON_TRANSFORM_MAX_GAIN 200
+
+/**
+ * Shortest and longest playback length in percent of the recorded length that an autonTransform may ask for.
+ */
+#define AUTON_TRANSFORM_MIN_TIME_SCALE 25
+#define AUTON_TRANSFORM_MAX_TIME_SCALE 400
+
+/**
+ * Number of entries in the slot directory: every autonomous slot followed by the programming skills file.
+ */
+#define AUTON_DIRECTORY_SIZE (MAX_AUTON_SLOTS + 1)
+
+/**
+ * Most characters in the label of a slot directory entry, which fits on one line of the LCD.
+ */
+#define AUTON_LABEL_LENGTH 16
+
+/**
+ * @brief What the slot directory knows about the file of an autonomous slot or of programming skills.
+ *
+ * The directory is read from the file headers once by initAutonRecorder() and kept up to date whenever a file is saved or
+ * downloaded, so that browsing the slots never touches flash.
+ */
+typedef struct autonSlotInfo {
+    /**
+     * Whether the file exists.
+     */
+    bool present;
+    /**
+     * Whether the file has a supported format and can be loaded.
+     */
+    bool valid;
+    /**
+     * Format version of the file, or 0 for a file without a header.
+     */
+    uint16_t version;
+    /**
+     * Number of states (or events, for an event recording) in the file.
+     */
+    uint16_t numStates;
+    /**
+     * Checksum stored in the file header, or 0 for a file without a header.
+     */
+    uint16_t checksum;
+    /**
+     * Text describing the entry for the slot selector.
+     */
+    char label[AUTON_LABEL_LENGTH + 1];
+} autonSlotInfo;
+
 /**
  * Stores the joystick state variables for moving the robot.
  * Used for recording and playing back autonomous routines.
  */
 extern joyState states[AUTON_TIME*JOY_POLL_FREQ];
 
+/**
+ * Stores the timestamped events of an event recording.
+ */
+extern autonEvent events[AUTON_MAX_EVENTS];
+
+/**
+ * Number of valid events in the events array.
+ */
+extern int numEvents;
+
+/**
+ * Whether the recorded or loaded autonomous routine is stored in the events array (true) or the states array (false).
+ */
+extern bool autonEventMode;
+
+#ifdef AUTON_SENSORS
+/**
+ * Stores the drive position at each state of the states array.
+ */
+extern autonSensorFrame sensorTrace[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether the sensorTrace array holds the trace of the recorded or loaded routine.
+ */
+extern bool sensorTraceLoaded;
+#endif
+
 /**
  * Slot number of currently loaded autonomous routine.
  */
@@ -101,47 +536,96 @@ extern int autonLoaded;
 
 /**
  * Whether or not the auton should be flipped (-1 if so, 1 if not)
+ * Flipping mirrors the routine for the opposite starting tile by negating the turn and horizontal motion. It takes effect
+ * the next time a routine is loaded.
  */
 extern int autonFlipped;
 
 /**
- * Section number (0-3) of currently loaded programming skills routine.
- * Since programming skills lasts for 60 seconds, it can be represented by 4 standard autonomous recordings.
+ * Transform applied to routines as they are loaded. It takes effect the next time a routine is loaded.
+ */
+extern autonTransform autonPlaybackTransform;
+
+/**
+ * Speed in percent of the recorded speed at which playbackAuton() plays routines, from 100 to AUTON_MAX_PLAYBACK_SPEED.
+ * The drive and pincer power are raised by the same factor so that the robot covers the recorded path in the shorter
+ * time; the lift already runs at full power and is only retimed. A routine that drives near full power leaves no room
+ * for that, so it is played back no faster than its peak command allows. It takes effect the next time a routine is
+ * played back.
+ */
+extern int autonPlaybackSpeed;
+
+/**
+ * Time in milliseconds into the loaded state recording at which playbackAuton() starts. Programming skills seek
+ * straight to the chunk holding this time through the chunk index. It takes effect the next time a routine is played
+ * back.
  */
-extern int progSkills;
+extern int autonPlaybackStart;
 
 /**
- * Initializes autonomous recorder by setting joystick states array to zero.
+ * Initializes autonomous recorder by setting joystick states array to zero and reading the slot directory.
  */
 void initAutonRecorder();
 
+/**
+ * Gets the slot directory entry of an autonomous slot or of programming skills.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return the entry, or NULL if the slot is not valid
+ */
+const autonSlotInfo* getAutonSlotInfo(int slot);
+
 /**
  * Records driver joystick values into states array for saving.
  */
 void recordAuton();
 
 /**
- * Downloads a 15 second autonomous portion from the computer through the serial monitor
+ * Records driver joystick changes into the events array for saving, sampling at AUTON_EVENT_SAMPLE_FREQ.
+ */
+void recordAutonEvents();
+
+/**
+ * Asks for a slot, then records driver joystick values while streaming them to its file, so the routine is saved as
+ * soon as recording ends. Programming skills are recorded for PROGSKILL_TIME in one continuous capture.
+ */
+void recordAndSaveAuton();
+
+/**
+ * Downloads an autonomous file from the computer over the serial link and writes it straight to flash, one block per frame.
+ * The transfer is started by running "autonlink put" on the computer; the file is only kept if its CRC matches and it loads.
  *
- * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
  */
 void downloadAutonFromComputer(int slot);
 
 /**
- * Uploads a 15 second autonomous portion to the computer through the serial monitor
+ * Uploads an autonomous file to the computer over the serial link, sending the file as it is stored in flash one block per frame.
+ * The computer receives it by running "autonlink get".
  *
- * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
  */
 void uploadAutonToComputer(int slot);
 
 /**
  * Gets the autonomous selection from the LCD buttons
  * 
- * @param allowProgSkillSection Allows the user to select a specific programming skills section slot if this is true
+ * @param allowSkillsFile Reports programming skills as the AUTON_SKILLS_SLOT file if this is true
+ *
+ * @return the autonomous selected (slot number), where MAX_AUTON_SLOTS + 1 is programming skills, or AUTON_SKILLS_SLOT if allowSkillsFile is true and programming skills is selected
+ */
+int selectAuton(int allowSkillsFile);
+
+/**
+ * Computes the Fletcher-16 checksum of a block of autonomous data.
+ *
+ * @param data the packed states or events to checksum
+ * @param size the size of data in bytes
  *
- * @return the autonomous selected (slot number), or if allowProgSkillSection is true and a programming skills is selected, the negative of the programming skill section number from -1 to -4
+ * @return the checksum of the data
  */
-int selectAuton(int allowProgSkillSection);
+uint16_t autonChecksum(const void* data, int size);
 
 /**
  * Saves contents of the states array to a file in flash memory for later playback.
@@ -149,14 +633,34 @@ int selectAuton(int allowProgSkillSection);
 void saveAuton();
 
 /**
- * Loads autonomous file contents into states array for playback.
+ * Loads autonomous file contents into states array for playback, mirrored by autonFlipped and adjusted by autonPlaybackTransform.
+ * A slot that is already loaded is only read again if the mirroring or the transform has changed since.
  */
 void loadAuton(int autonFile);
 
 /**
- * Replays autonomous based on loaded values in states array.
+ * Chooses the routine to load at boot without using the LCD, and restores the mirroring it was last loaded with.
+ *
+ * @return the slot that the AUTON_POT potentiometer points at if AUTON_POT_SELECT is defined, or otherwise the slot
+ * loaded last, in the same form as the result of selectAuton()
+ */
+int getBootAutonSlot();
+
+/**
+ * Starts loading a routine in a background task, so that the caller does not wait for flash.
  *
- * @param flipped -1 if the autonomous should be flipped over the y axis (for the opposite starting tile), 1 otherwise
+ * @param autonSlot the slot to load, as passed to loadAuton()
+ */
+void startAutonPreload(int autonSlot);
+
+/**
+ * Waits for a routine started with startAutonPreload() to finish loading; returns immediately if it already has.
+ */
+void waitAutonPreload();
+
+/**
+ * Replays autonomous based on loaded values in states array.
+ * Mirroring and the playback transform have already been applied by loadAuton().
  */
 void playbackAuton();
 
@@ -0,0 +1,227 @@
+/** @file deadline.h
+ * @brief File for the control loop deadline watchdog
+ *
+ * Watches the ticks of the loops that drive the robot, the operator control loop and autonomous playback, and counts
+ * every tick that runs past its deadline. When the loop keeps using most of its budget, work that does not drive the
+ * robot is shed one item at a time in a fixed order, first redrawing the LCD menu, then logging below warnings, then
+ * telemetry, and brought back in the reverse order once the loop has been comfortably within budget for a while.
+ *
+ * Overruns and every change in what is shed are kept in a small event log, which deadlineReportEvents() prints along
+ * with the stage profile so that the reason the robot lagged in a match can be read off afterwards.
+ */
+
+#ifndef DEADLINE_H
+
+// This prevents multiple inclusion
+#define DEADLINE_H
+
+#include <API.h>
+#include "loopTimer.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Percentage of the period that a tick's work has to reach to count as close to the budget
+ */
+#define DEADLINE_NEAR_PERCENT 80
+
+/**
+ * Percentage of the period that a tick's work has to stay under to count as comfortably within the budget
+ */
+#define DEADLINE_QUIET_PERCENT 50
+
+/**
+ * Number of ticks in a row close to the budget before the next item is shed
+ */
+#define DEADLINE_SHED_TICKS 5
+
+/**
+ * Number of ticks in a row comfortably within the budget before the last item shed is brought back
+ */
+#define DEADLINE_RESTORE_TICKS 100
+
+/**
+ * Time in milliseconds without a watched tick after which nothing is shed, so that a loop that was stopped, such as
+ * by a change of competition mode, does not leave the LCD and logging off
+ */
+#define DEADLINE_STALE_TIME 500
+
+/**
+ * Number of events kept in the event log; older events are overwritten
+ */
+#define DEADLINE_NUM_EVENTS 32
+
+/**
+ * The work that can be shed, in the order that it is shed
+ */
+typedef enum deadlineShed {
+	/**
+	 * Nothing is shed
+	 */
+	DEADLINE_SHED_NONE,
+	/**
+	 * Redrawing the LCD menu
+	 */
+	DEADLINE_SHED_LCD,
+	/**
+	 * Log messages below LOG_LEVEL_WARN
+	 */
+	DEADLINE_SHED_LOG,
+	/**
+	 * Telemetry output
+	 */
+	DEADLINE_SHED_TELEMETRY,
+	/**
+	 * Number of levels
+	 */
+	DEADLINE_NUM_LEVELS
+} deadlineShed;
+
+/**
+ * The kinds of entries in the event log
+ */
+typedef enum deadlineEventType {
+	/**
+	 * The first tick of a run of ticks that ran past their deadlines
+	 */
+	DEADLINE_EVENT_OVERRUN,
+	/**
+	 * One more item was shed
+	 */
+	DEADLINE_EVENT_SHED,
+	/**
+	 * The last item shed was brought back
+	 */
+	DEADLINE_EVENT_RESTORE
+} deadlineEventType;
+
+/**
+ * An entry in the event log
+ */
+typedef struct deadlineEvent {
+	/**
+	 * The time of the event in milliseconds
+	 */
+	unsigned long time;
+
+	/**
+	 * The name of the loop whose tick caused the event
+	 */
+	const char* loop;
+
+	/**
+	 * The time in microseconds that the work of the tick took
+	 */
+	unsigned long work;
+
+	/**
+	 * The DEADLINE_EVENT_* kind of the event
+	 */
+	unsigned char type;
+
+	/**
+	 * What is shed after the event
+	 */
+	unsigned char level;
+} deadlineEvent;
+
+/**
+ * A struct that holds the schedule and the deadline statistics of a watched loop
+ */
+typedef struct deadlineMonitor {
+	/**
+	 * The schedule of the loop
+	 */
+	loopTimer timer;
+
+	/**
+	 * The name of the loop, used in the event log and the report
+	 */
+	const char* name;
+
+	/**
+	 * Whether ticks that were missed are released late to catch up, instead of being skipped
+	 */
+	bool catchUp;
+
+	/**
+	 * The time in microseconds at which the current tick was released
+	 */
+	unsigned long released;
+
+	/**
+	 * The longest time in microseconds that the work of a tick has taken
+	 */
+	unsigned long maxWork;
+
+	/**
+	 * The number of ticks in a row that were close to the budget
+	 */
+	unsigned int nearTicks;
+
+	/**
+	 * The number of ticks in a row that were comfortably within the budget
+	 */
+	unsigned int quietTicks;
+
+	/**
+	 * Whether the previous tick ran past its deadline
+	 */
+	bool overran;
+} deadlineMonitor;
+
+/**
+ * Starts watching a fixed-period loop, releasing the first tick immediately
+ *
+ * @param monitor the monitor to start
+ * @param name the name of the loop, which must stay valid while the event log is kept
+ * @param period the period of the loop in milliseconds
+ * @param catchUp true to release missed ticks late, for loops that must run every tick such as playback; false to skip
+ *        them, for loops that only need their latest inputs such as the operator control loop
+ */
+void deadlineStart(deadlineMonitor* monitor, const char* name, unsigned long period, bool catchUp);
+
+/**
+ * Ends the work of the current tick, updating what is shed from how long it took and sending its telemetry, and
+ * waits for the next tick
+ *
+ * @param monitor the monitor of the loop
+ */
+void deadlineWait(deadlineMonitor* monitor);
+
+/**
+ * Gets whether a kind of work is being shed; the code that does the work checks this before doing it
+ *
+ * @param item the DEADLINE_SHED_* kind of work
+ *
+ * @return true if the work should be skipped
+ */
+bool deadlineShedding(deadlineShed item);
+
+/**
+ * Gets what is being shed
+ *
+ * @return the DEADLINE_SHED_* level, below which everything is shed as well
+ */
+deadlineShed deadlineShedLevel();
+
+/**
+ * Prints the timing and deadline statistics of a watched loop over the debug terminal
+ *
+ * @param monitor the monitor of the loop
+ */
+void deadlineReport(const deadlineMonitor* monitor);
+
+/**
+ * Prints the event log over the debug terminal, oldest event first
+ */
+void deadlineReportEvents();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+/** @file driveKinematics.h
+ * @brief File for the holonomic drive mixer
+ *
+ * Mixes the forward, horizontal and turning axes into the four X-drive wheels. When a wheel would need more than full
+ * power, all four wheels are scaled down together so that the robot still moves in the commanded direction, instead
+ * of each wheel being clipped on its own. The drive can also be driven field centric, where forward on the stick
+ * always moves away from the driver whichever way the robot faces, using the heading of the drive gyro.
+ *
+ * All of the math is integer; angles use a sine table with DRIVE_TRIG_ONE as 1.
+ */
+
+#ifndef DRIVE_KINEMATICS_H
+
+// This prevents multiple inclusion
+#define DRIVE_KINEMATICS_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Fixed point value of 1 in the sine table
+ */
+#define DRIVE_TRIG_ONE 1024
+
+/**
+ * Sets the drive motors for the X-drive, scaling all four wheels together if any would need more than full power
+ *
+ * @param forward the forward power
+ * @param horizontal the power to the right
+ * @param turn the clockwise turning power
+ */
+void setDriveMotors(int forward, int horizontal, int turn);
+
+/**
+ * Rotates a stick direction given relative to the field into the direction relative to the robot, using the gyro
+ * heading since resetDriveHeading(). The result is scaled down if either axis would need more than full power.
+ *
+ * @param forward the forward stick axis; replaced with the forward power relative to the robot
+ * @param horizontal the horizontal stick axis; replaced with the horizontal power relative to the robot
+ */
+void driveFieldToRobot(int* forward, int* horizontal);
+
+/**
+ * Makes the current heading of the robot the field's forward direction; until this is called, it is the heading the
+ * robot had when the sensors were initialized
+ */
+void resetDriveHeading();
+
+/**
+ * Turns field centric driving on or off; it stays off if there is no gyro
+ *
+ * @param enabled true to drive field centric, false to drive relative to the robot
+ */
+void driveSetFieldCentric(bool enabled);
+
+/**
+ * Gets whether the driver is driving field centric
+ *
+ * @return true if the sticks are relative to the field
+ */
+bool driveIsFieldCentric();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
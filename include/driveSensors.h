@@ -0,0 +1,91 @@
+/** @file driveSensors.h
+ * @brief File for drive sensor functions and constants
+ *
+ * Reads the drive integrated motor encoders (IMEs) and gyro and converts them into the same forward, horizontal and
+ * turning axes that setDriveMotors() uses, so that the autonomous recorder can compare where the robot is with where
+ * it was when a routine was recorded.
+ */
+
+#ifndef DRIVE_SENSORS_H
+
+// This prevents multiple inclusion
+#define DRIVE_SENSORS_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * IME address of the front left drive motor (IMEs are numbered in the order they are chained)
+ */
+#define FRONT_LEFT_IME 0
+/**
+ * IME address of the front right drive motor
+ */
+#define FRONT_RIGHT_IME 1
+/**
+ * IME address of the back left drive motor
+ */
+#define BACK_LEFT_IME 2
+/**
+ * IME address of the back right drive motor
+ */
+#define BACK_RIGHT_IME 3
+
+/**
+ * Analog port of the drive gyro, or 0 if there is no gyro and the IMEs should be used for heading
+ */
+#define DRIVE_GYRO_PORT 0
+
+/**
+ * A struct that holds the position of the drive relative to where it was last reset
+ */
+typedef struct drivePose {
+	/**
+	 * Forward distance travelled in IME ticks
+	 */
+	int forward;
+
+	/**
+	 * Horizontal distance travelled in IME ticks
+	 */
+	int horizontal;
+
+	/**
+	 * Clockwise rotation, in degrees if a gyro is present or in IME ticks otherwise
+	 */
+	int turn;
+} drivePose;
+
+/**
+ * Initializes the drive IMEs and gyro. Must be called from initialize() after initSensors().
+ */
+void initDriveSensors();
+
+/**
+ * Gets whether all four drive IMEs were found when the sensors were initialized
+ *
+ * @return true if the drive position can be measured, false otherwise
+ */
+bool driveSensorsPresent();
+
+/**
+ * Resets the drive position to zero
+ */
+void resetDriveSensors();
+
+/**
+ * Reads the position of the drive since it was last reset
+ *
+ * @param pose filled in with the position of the drive
+ */
+void readDriveSensors(drivePose* pose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/** @file driverInput.h
+ * @brief File for the once per tick snapshot of the joysticks
+ *
+ * The control task reads both joysticks once at the start of each tick with driverInputPoll(). The buttons of both
+ * joysticks go into one bitmask and the sticks into one array, and everything else in the tick reads that snapshot,
+ * so every consumer sees the same inputs and the joysticks are only read once.
+ *
+ * The buttons are not read directly but through actions. Each action is bound to a set of buttons on either joystick
+ * and is held while any of them is held, which is how the second joystick is ORed with the first. The bindings start
+ * out as the default layout and can be changed with driverBind().
+ */
+
+#ifndef DRIVER_INPUT_H
+
+// This prevents multiple inclusion
+#define DRIVER_INPUT_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The bit of a button in the button bitmask; each joystick takes 16 bits, four for each of button groups 5 to 8
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param group the button group (5 to 8)
+ * @param button one of JOY_UP, JOY_DOWN, JOY_LEFT, or JOY_RIGHT
+ */
+#define DRIVER_BUTTON(joystick, group, button) \
+	((unsigned long) (button) << (((joystick) - 1) * 16 + ((group) - 5) * 4))
+
+/**
+ * A button on both joysticks
+ *
+ * @param group the button group (5 to 8)
+ * @param button one of JOY_UP, JOY_DOWN, JOY_LEFT, or JOY_RIGHT
+ */
+#define DRIVER_BOTH(group, button) (DRIVER_BUTTON(1, group, button) | DRIVER_BUTTON(2, group, button))
+
+/**
+ * The actions that buttons are bound to
+ */
+typedef enum driverAction {
+	/**
+	 * Runs the pincer at full power
+	 */
+	DRIVER_PINCER_FORWARD,
+	/**
+	 * Runs the pincer at full power in reverse
+	 */
+	DRIVER_PINCER_BACK,
+	/**
+	 * Runs the pincer slowly
+	 */
+	DRIVER_PINCER_FORWARD_SLOW,
+	/**
+	 * Runs the pincer slowly in reverse
+	 */
+	DRIVER_PINCER_BACK_SLOW,
+	/**
+	 * Raises the lift by hand
+	 */
+	DRIVER_LIFT_UP,
+	/**
+	 * Lowers the lift by hand
+	 */
+	DRIVER_LIFT_DOWN,
+	/**
+	 * Sends the lift to the next preset up, once per press
+	 */
+	DRIVER_LIFT_PRESET_UP,
+	/**
+	 * Sends the lift to the next preset down, once per press
+	 */
+	DRIVER_LIFT_PRESET_DOWN,
+	/**
+	 * Records and saves an autonomous routine
+	 */
+	DRIVER_RECORD,
+	/**
+	 * Chooses and plays back an autonomous routine
+	 */
+	DRIVER_PLAYBACK,
+	/**
+	 * Cancels a recording or playback
+	 */
+	DRIVER_CANCEL,
+	/**
+	 * Number of actions
+	 */
+	DRIVER_NUM_ACTIONS
+} driverAction;
+
+/**
+ * A struct that holds one snapshot of both joysticks
+ */
+typedef struct driverInput {
+	/**
+	 * The DRIVER_BUTTON() bits of the buttons held in this snapshot
+	 */
+	unsigned long held;
+
+	/**
+	 * The DRIVER_BUTTON() bits of the buttons held in the previous snapshot
+	 */
+	unsigned long previous;
+
+	/**
+	 * The value of each stick axis from -128 to 127, indexed by joystick - 1 and axis - 1
+	 */
+	signed char analog[2][4];
+} driverInput;
+
+/**
+ * Sets every action back to the buttons of the default layout
+ */
+void driverResetBindings();
+
+/**
+ * Binds an action to a new set of buttons, replacing the buttons it was bound to
+ *
+ * @param action the action to bind
+ * @param buttons the DRIVER_BUTTON() bits of the buttons, or 0 to leave the action unbound
+ */
+void driverBind(driverAction action, unsigned long buttons);
+
+/**
+ * Gets the buttons an action is bound to
+ *
+ * @param action the action
+ *
+ * @return the DRIVER_BUTTON() bits of the buttons
+ */
+unsigned long driverBinding(driverAction action);
+
+/**
+ * Reads both joysticks into the snapshot, moving the last snapshot's buttons to previous. Called by the control task
+ * once at the start of each tick.
+ */
+void driverInputPoll();
+
+/**
+ * Gets the snapshot taken by the last driverInputPoll()
+ *
+ * @return the snapshot
+ */
+const driverInput* driverInputSnapshot();
+
+/**
+ * Gets a stick axis from the snapshot
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param axis the axis (1 to 4)
+ *
+ * @return the value of the axis from -128 to 127
+ */
+int driverAnalog(unsigned char joystick, unsigned char axis);
+
+/**
+ * Gets whether an action is held in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if any of its buttons is held
+ */
+bool driverHeld(driverAction action);
+
+/**
+ * Gets whether an action started in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if any of its buttons is held now and none was held in the previous snapshot
+ */
+bool driverPressed(driverAction action);
+
+/**
+ * Gets whether an action ended in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if none of its buttons is held now and one was held in the previous snapshot
+ */
+bool driverReleased(driverAction action);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
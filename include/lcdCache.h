@@ -0,0 +1,87 @@
+/** @file lcdCache.h
+ * @brief File for the cached LCD output and button input layer
+ *
+ * Keeps a shadow copy of both lines of the LCD so that text is only sent over the UART when it changes, and reads the
+ * LCD buttons once per tick into a snapshot with edge detection.
+ */
+
+#ifndef LCD_CACHE_H
+
+// This prevents multiple inclusion
+#define LCD_CACHE_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A snapshot of the LCD buttons, taken once per tick by lcdPollButtons()
+ */
+typedef struct lcdButtons {
+	/**
+	 * The LCD_BTN_* bits of the buttons held down in this snapshot
+	 */
+	unsigned int held;
+
+	/**
+	 * The LCD_BTN_* bits of the buttons held down in the previous snapshot
+	 */
+	unsigned int previous;
+} lcdButtons;
+
+/**
+ * Whether a button went down between the previous and current snapshot
+ */
+#define LCD_BUTTON_PRESSED(BUTTONS, BTN) ((((BUTTONS).held & ~(BUTTONS).previous) & (BTN)) != 0)
+
+/**
+ * Whether a button came up between the previous and current snapshot
+ */
+#define LCD_BUTTON_RELEASED(BUTTONS, BTN) (((~(BUTTONS).held & (BUTTONS).previous) & (BTN)) != 0)
+
+/**
+ * Whether a button is held down in the current snapshot
+ */
+#define LCD_BUTTON_HELD(BUTTONS, BTN) (((BUTTONS).held & (BTN)) != 0)
+
+/**
+ * Initializes the LCD and clears the shadow copy of its lines
+ */
+void lcdCacheInit();
+
+/**
+ * Reads the LCD buttons once and moves the last snapshot to previous
+ *
+ * @param buttons the snapshot to update
+ */
+void lcdPollButtons(lcdButtons* buttons);
+
+/**
+ * Sets a line of the LCD, only sending it over the UART if it differs from what is already displayed
+ *
+ * @param line the line to set (1 or 2)
+ * @param text the text to display, truncated to LCD_MESSAGE_MAX_LENGTH characters
+ */
+void lcdWriteLine(unsigned char line, const char* text);
+
+/**
+ * Formats and sets a line of the LCD, only sending it over the UART if it differs from what is already displayed
+ *
+ * @param line the line to set (1 or 2)
+ * @param formatString the printf() format string of the text
+ */
+void lcdPrintLine(unsigned char line, const char* formatString, ...);
+
+/**
+ * Clears both lines of the LCD
+ */
+void lcdClearLines();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -24,8 +24,19 @@ extern "C" {
  */
 #define LCD_MESSAGE_MAX_LENGTH 16
 
+/**
+ * The number of milliseconds between updates of the LCD menu by the LCD task
+ */
+#define LCD_MENU_PERIOD 20
+
+/**
+ * Number of items in a constant menu array
+ */
+#define MENU_COUNT(items) ((int) (sizeof(items) / sizeof((items)[0])))
+
 /**
  * A struct that defines an item in the LCD navigation menu
+ * The menu tree is a set of constant arrays of these, so it is laid out in flash instead of taking RAM.
  */
 typedef struct menu_item {
 	/**
@@ -36,12 +47,12 @@ typedef struct menu_item {
 	/**
 	 * The name of the LCD menu item
 	 */
-	char* name;
+	const char* name;
 
 	/**
 	 * A short description of the LCD menu item
 	 */
-	char* description;
+	const char* description;
 
 	/**
 	 * The number of children
@@ -61,12 +72,17 @@ typedef struct menu_item {
 	/**
 	 * The children menus of the current menu item
 	 */
-	struct menu_item* children;
+	const struct menu_item* children;
 
 	/**
 	 * A reference to the parent menu
 	 */
-	struct menu_item* parent;
+	const struct menu_item* parent;
+
+	/**
+	 * If true, runFunction moves the robot or changes the loaded autonomous, so it is handed to the operator control task through runLCDMenuActions() instead of running on the LCD task
+	 */
+	int isControlAction;
 
 	/**
 	 * A function that will run when the button is pressed
@@ -86,6 +102,28 @@ void initLCDMenu();
  */
 void updateLCDMenu(int dt);
 
+/**
+ * Starts the low priority task that updates the LCD menu every LCD_MENU_PERIOD milliseconds
+ */
+void startLCDMenuTask();
+
+/**
+ * Stops the LCD task from drawing so that the calling task can use the LCD and its buttons.
+ * Waits for the LCD task to finish its current update. Every call must be matched by a call to unlockLCDMenu().
+ */
+void lockLCDMenu();
+
+/**
+ * Lets the LCD task draw the menu again after a call to lockLCDMenu()
+ */
+void unlockLCDMenu();
+
+/**
+ * Runs the menu action that the LCD task handed to the operator control task, if there is one.
+ * Called once per operator control loop iteration; returns immediately if no action is pending.
+ */
+void runLCDMenuActions();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,147 @@
+/** @file liftControl.h
+ * @brief File for the lift position controller
+ *
+ * Moves the lift to preset heights measured by the lift encoder. A task of its own runs at LIFT_CONTROL_FREQ, plans a
+ * trapezoidal motion profile to the preset and follows it with a PID loop plus velocity and gravity feedforward, so
+ * the lift neither slams into the preset at full power nor sags when it is let go.
+ *
+ * The lift is commanded with the same lift value that recordJoyInfo() produces and the recorder stores: -1, 0 and 1
+ * drive the lift by hand as before (0 holds it where it was let go), and LIFT_PRESET_COMMAND(n) sends it to preset n.
+ * A recording therefore replays the setpoints the driver chose rather than the power that reached them. Without a
+ * lift encoder, presets are ignored and the lift runs open loop.
+ */
+
+#ifndef LIFT_CONTROL_H
+
+// This prevents multiple inclusion
+#define LIFT_CONTROL_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rate at which the lift controller runs in Hz
+ */
+#define LIFT_CONTROL_FREQ 100
+
+/**
+ * Number of preset heights
+ */
+#define LIFT_NUM_PRESETS 6
+
+/**
+ * Lift command of the first preset; the other presets follow it
+ */
+#define LIFT_COMMAND_PRESET 16
+
+/**
+ * Lift command that sends the lift to a preset
+ *
+ * @param n the number of the preset, from 0 to LIFT_NUM_PRESETS - 1
+ */
+#define LIFT_PRESET_COMMAND(n) (LIFT_COMMAND_PRESET + (n))
+
+/**
+ * Fastest speed the motion profile plans, in encoder ticks per second
+ */
+#define LIFT_MAX_VELOCITY 900
+
+/**
+ * Acceleration and deceleration of the motion profile, in encoder ticks per second squared
+ */
+#define LIFT_MAX_ACCEL 4000
+
+/**
+ * Gains are fixed point with this value as 1
+ */
+#define LIFT_GAIN_ONE 1000
+
+/**
+ * Proportional gain, in motor power per encoder tick of error
+ */
+#define LIFT_KP 700
+
+/**
+ * Integral gain, in motor power per encoder tick second of error
+ */
+#define LIFT_KI 1500
+
+/**
+ * Derivative gain, in motor power per encoder tick per second that the lift is slower than planned
+ */
+#define LIFT_KD 25
+
+/**
+ * Velocity feedforward, in motor power per encoder tick per second of planned speed
+ */
+#define LIFT_KV 100
+
+/**
+ * Largest motor power the integral term can contribute, which stops it winding up while the lift is stalled
+ */
+#define LIFT_MAX_INTEGRAL_POWER 30
+
+/**
+ * Motor power that holds the lift against gravity
+ */
+#define LIFT_GRAVITY_POWER 14
+
+/**
+ * Height in encoder ticks below which the lift rests on its hard stop, so it is not held up or fed gravity power
+ */
+#define LIFT_REST_HEIGHT 15
+
+/**
+ * Initializes the lift controller and starts its task if there is a lift encoder. Must be called from initialize()
+ * after initSensors().
+ */
+void initLiftControl();
+
+/**
+ * Gets whether a lift command sends the lift to a preset
+ *
+ * @param command the lift command
+ *
+ * @return true for LIFT_PRESET_COMMAND() values, false for commands that drive the lift by hand
+ */
+bool liftIsPresetCommand(int command);
+
+/**
+ * Gets the preset that the lift is going to or holding
+ *
+ * @return the number of the preset, or -1 if the lift was last driven by hand
+ */
+int liftGetPreset();
+
+/**
+ * Finds the next preset above or below the lift, for stepping through the presets one button press at a time
+ *
+ * @param direction 1 for the next preset up or -1 for the next preset down
+ *
+ * @return the number of the preset
+ */
+int liftNextPreset(int direction);
+
+/**
+ * Commands the lift; called by the task that drives the robot every control tick
+ *
+ * @param command -1 or 1 to drive the lift by hand, 0 to hold it, or LIFT_PRESET_COMMAND(n) to send it to preset n
+ */
+void liftCommand(int command);
+
+/**
+ * Gets the power the lift motors should be given, in the direction setLiftMotors() uses
+ *
+ * @return the motor power from -127 to 127
+ */
+int liftControlPower();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
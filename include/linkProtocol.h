@@ -0,0 +1,330 @@
+/** @file linkProtocol.h
+ * @brief File for the framed binary serial link protocol
+ *
+ * Frames the data sent between the robot and a computer over a serial port so that corrupt or lost data is detected
+ * and retried instead of being stored. Every frame is laid out as
+ *
+ *     LINK_SOF | type | seq | length | payload (length bytes) | CRC-16 (low byte first)
+ *
+ * where the CRC-16/CCITT covers everything from type to the end of the payload. Multi-byte payload fields are little
+ * endian. This file only depends on <stdint.h> so the host tools can share it with the robot code.
+ */
+
+#ifndef LINK_PROTOCOL_H
+
+// This prevents multiple inclusion
+#define LINK_PROTOCOL_H
+
+#include <stdint.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Byte that starts every frame
+ */
+#define LINK_SOF 0xA5
+
+/**
+ * Most payload bytes in one frame
+ */
+#define LINK_MAX_PAYLOAD 240
+
+/**
+ * Bytes a frame adds around its payload (start, type, seq, length and CRC)
+ */
+#define LINK_FRAME_OVERHEAD 6
+
+/**
+ * Size of the largest frame in bytes
+ */
+#define LINK_MAX_FRAME (LINK_MAX_PAYLOAD + LINK_FRAME_OVERHEAD)
+
+/**
+ * Milliseconds to wait for a reply before sending a frame again
+ */
+#define LINK_TIMEOUT 100
+
+/**
+ * Number of times a frame is sent before the transfer is abandoned
+ */
+#define LINK_MAX_RETRIES 8
+
+/**
+ * Largest file that a transfer carries in bytes: a programming skills file of 16 chunks of 750 states that do not
+ * compress at all, stored as 6 byte runs between a 16 byte header and chunk index of 132 bytes and a 16 byte trailer.
+ * autonrecorder.c checks at compile time that this still matches its file format.
+ */
+#define LINK_MAX_FILE_SIZE (16 + 132 + 16 * 750 * 6 + 16)
+
+/**
+ * Starts a file transfer; the payload is the size of the file as a 32-bit integer
+ */
+#define LINK_FRAME_BEGIN 1
+
+/**
+ * A block of the file being transferred, numbered by seq starting from 1
+ */
+#define LINK_FRAME_DATA 2
+
+/**
+ * Ends a file transfer; the payload is the CRC-16 of the whole file as a 16-bit integer
+ */
+#define LINK_FRAME_END 3
+
+/**
+ * Acknowledges the frame numbered seq; the payload is one LINK_STATUS_* byte
+ */
+#define LINK_FRAME_ACK 4
+
+/**
+ * Reports a corrupt frame; seq is the number of the frame the receiver expects next
+ */
+#define LINK_FRAME_NAK 5
+
+/**
+ * One tick of telemetry, streamed by the robot without being acknowledged; seq counts the ticks so that the computer
+ * can tell how many frames were lost
+ */
+#define LINK_FRAME_TELEMETRY 6
+
+/**
+ * Offset in a telemetry payload of the time of the tick in milliseconds (32 bits)
+ */
+#define TELEMETRY_TIME 0
+
+/**
+ * Offset of the command the tick moved the robot with: forward, horizontal, turn, pincer and lift (signed, 8 bits
+ * each)
+ */
+#define TELEMETRY_STATE 4
+
+/**
+ * Number of fields in the command
+ */
+#define TELEMETRY_STATE_FIELDS 5
+
+/**
+ * Offset of the power committed to each motor port from 1 to 10 (signed, 8 bits each)
+ */
+#define TELEMETRY_MOTORS 9
+
+/**
+ * Number of motor ports in a telemetry payload
+ */
+#define TELEMETRY_NUM_MOTORS 10
+
+/**
+ * Offset of the main battery voltage in millivolts (16 bits)
+ */
+#define TELEMETRY_BATTERY 19
+
+/**
+ * Offset of the gyro heading in degrees (signed, 16 bits)
+ */
+#define TELEMETRY_GYRO 21
+
+/**
+ * Offset of the lift encoder count (signed, 32 bits)
+ */
+#define TELEMETRY_ENCODER 23
+
+/**
+ * Offset of the ultrasonic distance in centimeters (16 bits)
+ */
+#define TELEMETRY_ULTRASONIC 27
+
+/**
+ * Offset of the count of each of the four IMEs (signed, 32 bits each)
+ */
+#define TELEMETRY_IMES 29
+
+/**
+ * Number of IMEs in a telemetry payload
+ */
+#define TELEMETRY_NUM_IMES 4
+
+/**
+ * Offset of the time the work of the tick took in microseconds (16 bits, saturating)
+ */
+#define TELEMETRY_WORK 45
+
+/**
+ * Offset of the period of the loop in milliseconds (8 bits)
+ */
+#define TELEMETRY_PERIOD 47
+
+/**
+ * Offset of what the deadline watchdog was shedding (8 bits)
+ */
+#define TELEMETRY_SHED 48
+
+/**
+ * Offset of the number of ticks of the loop that have overrun so far (16 bits, wrapping)
+ */
+#define TELEMETRY_OVERRUNS 49
+
+/**
+ * Number of bytes in a telemetry payload
+ */
+#define TELEMETRY_PAYLOAD 51
+
+/**
+ * The frame was accepted
+ */
+#define LINK_STATUS_OK 0
+
+/**
+ * The transfer was refused, because the file is too large or could not be opened or written
+ */
+#define LINK_STATUS_REJECTED 1
+
+/**
+ * The whole file arrived but failed its CRC or could not be decoded, and was discarded
+ */
+#define LINK_STATUS_CORRUPT 2
+
+/**
+ * @brief A frame of the serial link protocol
+ */
+typedef struct linkFrame {
+	/**
+	 * The LINK_FRAME_* type of the frame
+	 */
+	uint8_t type;
+	/**
+	 * The sequence number of the frame
+	 */
+	uint8_t seq;
+	/**
+	 * The number of payload bytes
+	 */
+	uint8_t length;
+	/**
+	 * The payload
+	 */
+	uint8_t payload[LINK_MAX_PAYLOAD];
+} linkFrame;
+
+/**
+ * @brief Decoder that assembles frames from a stream of received bytes
+ *
+ * Bytes before a LINK_SOF are skipped, so the decoder resynchronises on its own after noise or a corrupt frame.
+ */
+typedef struct linkDecoder {
+	/**
+	 * The frame being assembled
+	 */
+	linkFrame frame;
+	/**
+	 * Number of bytes of the current frame received so far, or 0 while waiting for LINK_SOF
+	 */
+	int received;
+	/**
+	 * The CRC received at the end of the frame
+	 */
+	uint16_t crc;
+	/**
+	 * Number of corrupt frames seen
+	 */
+	unsigned long errors;
+} linkDecoder;
+
+/**
+ * Result of linkDecode() when more bytes are needed
+ */
+#define LINK_DECODE_PENDING 0
+
+/**
+ * Result of linkDecode() when a valid frame has been assembled
+ */
+#define LINK_DECODE_FRAME 1
+
+/**
+ * Result of linkDecode() when a frame failed its CRC or had an invalid length
+ */
+#define LINK_DECODE_CORRUPT -1
+
+/**
+ * Computes the CRC-16/CCITT of a block of data
+ *
+ * @param crc the CRC of the data before this block, or 0xFFFF to start a new CRC
+ * @param data the data to add to the CRC
+ * @param size the size of data in bytes
+ *
+ * @return the CRC including the block
+ */
+uint16_t linkCrc16(uint16_t crc, const void* data, int size);
+
+/**
+ * Encodes a frame into a buffer ready to be written to the serial port
+ *
+ * @param buffer the buffer to encode into, at least LINK_MAX_FRAME bytes long
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ *
+ * @return the size of the encoded frame in bytes
+ */
+int linkEncode(uint8_t* buffer, uint8_t type, uint8_t seq, const void* payload, int length);
+
+/**
+ * Resets a decoder to wait for the start of a frame
+ *
+ * @param decoder the decoder to reset
+ */
+void linkDecoderReset(linkDecoder* decoder);
+
+/**
+ * Feeds one received byte to a decoder
+ *
+ * @param decoder the decoder
+ * @param byte the byte received
+ *
+ * @return LINK_DECODE_FRAME when decoder->frame holds a new valid frame, LINK_DECODE_CORRUPT when a corrupt frame was
+ * dropped, or LINK_DECODE_PENDING otherwise
+ */
+int linkDecode(linkDecoder* decoder, uint8_t byte);
+
+/**
+ * Stores a 16-bit integer in a payload
+ *
+ * @param payload where to store the integer
+ * @param value the integer
+ */
+void linkPut16(uint8_t* payload, uint16_t value);
+
+/**
+ * Stores a 32-bit integer in a payload
+ *
+ * @param payload where to store the integer
+ * @param value the integer
+ */
+void linkPut32(uint8_t* payload, uint32_t value);
+
+/**
+ * Reads a 16-bit integer from a payload
+ *
+ * @param payload where the integer is stored
+ *
+ * @return the integer
+ */
+uint16_t linkGet16(const uint8_t* payload);
+
+/**
+ * Reads a 32-bit integer from a payload
+ *
+ * @param payload where the integer is stored
+ *
+ * @return the integer
+ */
+uint32_t linkGet32(const uint8_t* payload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
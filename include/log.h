@@ -0,0 +1,125 @@
+/** @file log.h
+ * @brief File for the asynchronous logging subsystem
+ *
+ * Log calls on the control path push fixed-size binary records into a lock-free ring buffer instead of writing to
+ * the serial link. A low priority task formats the records and prints them over the debug terminal, so the motor
+ * loop never waits on serial output.
+ *
+ * Each level can be removed at compile time by defining LOG_LEVEL above it, in which case its log calls (and the
+ * evaluation of their arguments) are compiled out entirely.
+ */
+
+#ifndef LOG_H
+
+// This prevents multiple inclusion
+#define LOG_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Level for per-tick tracing, such as every recorded or played back state
+ */
+#define LOG_LEVEL_DEBUG 0
+/**
+ * Level for normal progress messages
+ */
+#define LOG_LEVEL_INFO 1
+/**
+ * Level for recoverable problems
+ */
+#define LOG_LEVEL_WARN 2
+/**
+ * Level for failed operations
+ */
+#define LOG_LEVEL_ERROR 3
+/**
+ * Level that disables all logging
+ */
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+/**
+ * Lowest level that is compiled in; log calls below this level are removed by the preprocessor
+ */
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+/**
+ * Maximum number of integer arguments that a single log call can carry
+ */
+#define LOG_MAX_ARGS 6
+
+/**
+ * Number of records in the ring buffer (must be a power of two)
+ */
+#define LOG_BUFFER_SIZE 32
+
+/**
+ * Number of milliseconds the drain task sleeps once the ring buffer is empty
+ */
+#define LOG_DRAIN_PERIOD 20
+
+/**
+ * Pushes a record into the ring buffer without blocking. Use the LOG_* macros instead of calling this directly.
+ *
+ * The format string must be a string literal (or otherwise live for the rest of the program), since it is only
+ * read once the record is drained. Only integer arguments are supported for the same reason.
+ *
+ * @param level the level of the message
+ * @param format the printf() format string of the message
+ */
+void logPush(unsigned char level, const char* format, int arg0, int arg1, int arg2, int arg3, int arg4, int arg5);
+
+/**
+ * Pads a log call out to LOG_MAX_ARGS arguments
+ */
+#define LOG_PUSH_(level, format, arg0, arg1, arg2, arg3, arg4, arg5, ...) \
+	logPush(level, format, arg0, arg1, arg2, arg3, arg4, arg5)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_PUSH_(LOG_LEVEL_DEBUG, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_DEBUG(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_PUSH_(LOG_LEVEL_INFO, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_INFO(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_PUSH_(LOG_LEVEL_WARN, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_WARN(...) ((void) 0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_PUSH_(LOG_LEVEL_ERROR, __VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)
+#else
+#define LOG_ERROR(...) ((void) 0)
+#endif
+
+/**
+ * Initializes the ring buffer and starts the drain task. Must be called before any log call.
+ */
+void logInit();
+
+/**
+ * Stops the drain task from printing so that the debug terminal can be used for a raw data transfer.
+ * Records pushed while paused are kept until the buffer fills, after which they are dropped and counted.
+ *
+ * @param paused true to stop printing, false to resume
+ */
+void logSetPaused(bool paused);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+/** @file loopTimer.h
+ * @brief File for the fixed-period loop scheduler
+ *
+ * Provides an absolute-deadline scheduler for loops that must run at a fixed rate, such as the autonomous recorder
+ * and playback loops. Each tick is released at start + n * period regardless of how long the loop body took, so
+ * variable work inside the loop does not accumulate into drift.
+ */
+
+#ifndef LOOP_TIMER_H
+
+// This prevents multiple inclusion
+#define LOOP_TIMER_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A struct that holds the schedule and timing statistics of a fixed-period loop
+ */
+typedef struct loopTimer {
+	/**
+	 * The period of the loop in milliseconds
+	 */
+	unsigned long period;
+
+	/**
+	 * The time in milliseconds at which the current tick was released, used with taskDelayUntil()
+	 */
+	unsigned long wakeTime;
+
+	/**
+	 * The time in microseconds at which the first tick was released
+	 */
+	unsigned long startMicros;
+
+	/**
+	 * The number of ticks that have been released since the timer was started
+	 */
+	unsigned int ticks;
+
+	/**
+	 * The number of ticks that were dropped with loopTimerSkipMissed() instead of being released
+	 */
+	unsigned int skipped;
+
+	/**
+	 * The number of ticks whose body ran past the next deadline
+	 */
+	unsigned int overruns;
+
+	/**
+	 * The longest amount of time in microseconds that a tick body ran past its deadline
+	 */
+	unsigned long maxOverrun;
+
+	/**
+	 * The longest amount of time in microseconds that a tick was released after its ideal release time
+	 */
+	unsigned long maxJitter;
+
+	/**
+	 * The sum of the release jitter of every tick in microseconds, used to compute the mean
+	 */
+	unsigned long totalJitter;
+} loopTimer;
+
+/**
+ * Starts a loop timer, releasing the first tick immediately
+ *
+ * @param timer the timer to start
+ * @param period the period of the loop in milliseconds
+ */
+void loopTimerStart(loopTimer* timer, unsigned long period);
+
+/**
+ * Waits until the deadline of the next tick, recording overrun and jitter statistics for the current tick
+ *
+ * If the current tick overran, the next tick is released immediately and later ticks stay on the original frame
+ * boundaries, so a late tick is caught up instead of shifting the rest of the loop.
+ *
+ * @param timer the timer to wait on
+ */
+void loopTimerWait(loopTimer* timer);
+
+/**
+ * Drops the ticks whose deadlines have already passed while the current tick ran, so that a loop that only needs its
+ * latest inputs carries on from the next frame boundary instead of releasing the missed ticks back to back. Call it
+ * just before loopTimerWait(); the current tick still counts as an overrun.
+ *
+ * @param timer the timer whose missed ticks to drop
+ */
+void loopTimerSkipMissed(loopTimer* timer);
+
+/**
+ * Prints the timing statistics of a loop timer over the debug terminal
+ *
+ * @param timer the timer to report on
+ * @param name the name of the loop to print alongside the statistics
+ */
+void loopTimerReport(const loopTimer* timer, const char* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -44,9 +44,24 @@
 #define MAIN_H_
 
 #include <API.h>
+#include "log.h"
 #include "autonrecorder.h"
+#include "motorOutput.h"
 #include "robot.h"
+#include "driverInput.h"
+#include "robotCommand.h"
+#include "stickShaping.h"
 #include "lcdDisplay.h"
+#include "lcdCache.h"
+#include "loopTimer.h"
+#include "deadline.h"
+#include "profiler.h"
+#include "sensors.h"
+#include "driveSensors.h"
+#include "driveKinematics.h"
+#include "liftControl.h"
+#include "serialLink.h"
+#include "telemetry.h"
 
 // Allow usage of this file in C++ programs
 #ifdef __cplusplus
@@ -56,27 +71,6 @@ extern "C" {
 #define PRESSED LOW
 #define UNPRESSED HIGH
 
-/**
- * Forward motion
- */
-extern int spd;
-/**
- * Horizontal motion
- */
-extern int horizontal;
-/**
- * CW rotational motion
- */
-extern int turn;
-/**
- * Motion of the pincer
- */
-extern int sht;
-/**
- * Lift motion
- */
-extern int lift;
-
 //#define AUTO_DEBUG
 
 // A function prototype looks exactly like its declaration, but with a semicolon instead of
@@ -142,7 +136,7 @@ void initialize();
 void operatorControl();
 
 // Move the robot based on saved joystick information
-void moveRobot();
+void moveRobot(unsigned long period);
 
 // Store joystick information
 void recordJoyInfo();
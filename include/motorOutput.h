@@ -0,0 +1,117 @@
+/** @file motorOutput.h
+ * @brief File for the batched motor output layer
+ *
+ * Keeps a command table with the target, slewed output and last sent value of every motor port. Callers set targets
+ * with motorOutputSet() during a control tick, and motorOutputCommit() ramps each port toward its target at the port's
+ * slew rate and only calls motorSet() for the ports whose output changed.
+ */
+
+#ifndef MOTOR_OUTPUT_H
+
+// This prevents multiple inclusion
+#define MOTOR_OUTPUT_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of motor ports on the Cortex
+ */
+#define MOTOR_OUTPUT_PORTS 10
+
+/**
+ * Length in milliseconds of the control tick that slew rates are given in
+ */
+#define MOTOR_OUTPUT_TICK 20
+
+/**
+ * Slew rate that lets a port jump straight to any target
+ */
+#define MOTOR_SLEW_NONE 255
+
+/**
+ * Default slew rate of the drive motors, in motor power per MOTOR_OUTPUT_TICK
+ */
+#define MOTOR_SLEW_DRIVE 24
+
+/**
+ * Default slew rate of the lift motors, in motor power per MOTOR_OUTPUT_TICK
+ * The lift is driven at full power in either direction, so this spreads the current spike over about 160 ms.
+ */
+#define MOTOR_SLEW_LIFT 16
+
+/**
+ * Default slew rate of the pincer motor, in motor power per MOTOR_OUTPUT_TICK
+ */
+#define MOTOR_SLEW_PINCER 32
+
+/**
+ * Number of commits after which every port is sent again even if it has not changed
+ * This recovers from the motors being stopped behind the table's back, such as by the kernel when the robot is disabled.
+ */
+#define MOTOR_OUTPUT_REFRESH_COMMITS 50
+
+/**
+ * Output scale that leaves targets unchanged; scales are fixed point with this value as 1
+ */
+#define MOTOR_OUTPUT_SCALE_ONE 1024
+
+/**
+ * Sets the default slew rate of every port and stops all motors
+ */
+void motorOutputInit();
+
+/**
+ * Sets the target power of a motor port, to be applied by the next motorOutputCommit()
+ *
+ * @param port the motor port (1 - 10)
+ * @param value the target power from -127 to 127; values outside this range are clamped
+ */
+void motorOutputSet(unsigned char port, int value);
+
+/**
+ * Sets the scale applied to every target passed to motorOutputSet() from now on, such as a battery voltage compensation
+ *
+ * @param scale the scale, where MOTOR_OUTPUT_SCALE_ONE leaves targets unchanged
+ */
+void motorOutputSetScale(int scale);
+
+/**
+ * Sets how quickly the output of a motor port can move toward its target
+ *
+ * @param port the motor port (1 - 10)
+ * @param rate the largest change in power per MOTOR_OUTPUT_TICK, or MOTOR_SLEW_NONE to apply targets instantly
+ */
+void motorOutputSetSlew(unsigned char port, unsigned char rate);
+
+/**
+ * Ramps every port toward its target and sends the ports whose output changed
+ * This should be called once per control tick by the task that sets the targets.
+ *
+ * @param period the period in milliseconds of the calling loop, which sets how far each port ramps
+ */
+void motorOutputCommit(unsigned long period);
+
+/**
+ * Gets the power that the last commit gave a port, after scaling and slewing
+ *
+ * @param port the motor port (1 - 10)
+ *
+ * @return the power from -127 to 127, or 0 for a port out of range
+ */
+int motorOutputGet(unsigned char port);
+
+/**
+ * Stops every motor immediately, bypassing the slew rates, sets every target to zero and resets the output scale
+ */
+void motorOutputStopAll();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/** @file profiler.h
+ * @brief File for the control loop stage profiler
+ *
+ * Times each stage of the control loops with micros() and accumulates the durations into fixed-size histograms, so
+ * the cost of a stage can be read back as min/max/mean/99th percentile and a count of ticks over its time budget.
+ * Recording a sample is two micros() calls and a few integer operations, so the profiler is left on in competition
+ * builds; comment out PROFILER_ENABLED to remove it entirely.
+ */
+
+#ifndef PROFILER_H
+
+// This prevents multiple inclusion
+#define PROFILER_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Records stage timings; comment this out to compile the profiler calls away
+ */
+#define PROFILER_ENABLED
+
+/**
+ * Number of histogram buckets per stage, the last of which holds every sample too long for the others
+ */
+#define PROFILE_NUM_BUCKETS 32
+
+/**
+ * Width of each histogram bucket in microseconds
+ */
+#define PROFILE_BUCKET_WIDTH 64
+
+/**
+ * The stages of the control loops that are timed
+ */
+typedef enum profileStage {
+	/**
+	 * recordJoyInfo(), reading and shaping the joysticks
+	 */
+	PROFILE_JOY_INFO,
+	/**
+	 * moveRobot(), setting and committing the motor outputs
+	 */
+	PROFILE_MOVE_ROBOT,
+	/**
+	 * updateLCDMenu(), polling the LCD buttons and drawing the menu
+	 */
+	PROFILE_LCD_MENU,
+	/**
+	 * The body of one autonomous playback tick
+	 */
+	PROFILE_PLAYBACK,
+	/**
+	 * Number of stages
+	 */
+	PROFILE_NUM_STAGES
+} profileStage;
+
+/**
+ * @brief Timing statistics of a single stage
+ *
+ * Each stage is only recorded by one task, so the statistics are updated without locking. Readers on other tasks may
+ * see a sample half applied, which only affects the displayed numbers.
+ */
+typedef struct profileStats {
+	/**
+	 * Number of samples recorded
+	 */
+	unsigned long count;
+	/**
+	 * Sum of all sample durations in microseconds
+	 */
+	unsigned long total;
+	/**
+	 * Shortest sample in microseconds
+	 */
+	unsigned long min;
+	/**
+	 * Longest sample in microseconds
+	 */
+	unsigned long max;
+	/**
+	 * Number of samples longer than the stage's budget
+	 */
+	unsigned long misses;
+	/**
+	 * Number of samples in each PROFILE_BUCKET_WIDTH wide bucket
+	 */
+	unsigned long buckets[PROFILE_NUM_BUCKETS];
+} profileStats;
+
+#ifdef PROFILER_ENABLED
+/**
+ * Starts timing a stage
+ *
+ * @return the start time to pass to profileEnd()
+ */
+#define profileBegin() micros()
+
+/**
+ * Finishes timing a stage and records the sample
+ *
+ * @param stage the stage that was timed
+ * @param start the value returned by profileBegin()
+ */
+void profileEnd(profileStage stage, unsigned long start);
+#else
+#define profileBegin() 0
+#define profileEnd(stage, start) ((void) (start))
+#endif
+
+/**
+ * Copies the statistics of a stage
+ *
+ * @param stage the stage to copy
+ * @param stats receives the statistics
+ */
+void profileGetStats(profileStage stage, profileStats* stats);
+
+/**
+ * Estimates the 99th percentile duration of a stage from its histogram
+ *
+ * @param stats the statistics of the stage
+ *
+ * @return the upper edge of the bucket holding the 99th percentile, in microseconds, capped at the longest sample
+ */
+unsigned long profileP99(const profileStats* stats);
+
+/**
+ * Gets the display name of a stage
+ *
+ * @param stage the stage
+ *
+ * @return the name of the stage
+ */
+const char* profileStageName(profileStage stage);
+
+/**
+ * Clears the statistics of every stage
+ * Each stage is cleared by the task that records it at its next sample, so this is safe to call from any task.
+ */
+void profileReset();
+
+/**
+ * Prints the statistics and histogram of every stage to the serial port
+ */
+void profileReport();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
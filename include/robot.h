@@ -9,6 +9,7 @@
 
 #include <API.h>
 #include <math.h>
+#include "motorOutput.h"
 
 // Allow usage of this file in C++ programs
 #ifdef __cplusplus
@@ -17,6 +18,8 @@ extern "C" {
 
 #define MIN(X, Y) (((X) < (Y)) ? (X) : (Y))
 #define MAX(X, Y) (((X) > (Y)) ? (X) : (Y))
+#define ABS(X) (((X) < 0) ? -(X) : (X))
+#define CLAMP(V, LOW, HIGH) MIN(MAX((V), (LOW)), (HIGH))
 #define IGNORE_LOW_VAL(V) ((((V) > -10) && ((V) < 10)) ? (0) : (V))
 
 /**
@@ -62,39 +65,26 @@ extern "C" {
 #define MOTOR_SPEED 127
 #define LCD_PORT uart1
 
-/**
- * Sets the drive motors for the tank drive based on left and right sides
- *
- * @param left sets the power to the left motors
- * @param right sets the power to the right motors
- */
-inline void setDriveMotors(int forward, int horizontal, int turn) {
-	motorSet(FRONT_LEFT_MOTOR, -(forward + horizontal + turn));
-	motorSet(FRONT_RIGHT_MOTOR, -(-forward + horizontal + turn));
-	motorSet(BACK_LEFT_MOTOR, forward - horizontal + turn);
-	motorSet(BACK_RIGHT_MOTOR, -forward - horizontal + turn);
-}
-
 /**
  * Sets the speed of the pincer motors
  *
  * @param pincer sets the power to the pincer motors
  */
 inline void setPincerMotors(int pincer){
-  motorSet(PINCER_Y_MOTOR, pincer);
+  motorOutputSet(PINCER_Y_MOTOR, pincer);
 }
 
 /**
  * Sets the speed of the lift motors such that they rotate to move the lift in the same direction
  *
- * @param spd sets the power to the lift motors on a continuum from -1 to 1
+ * @param power sets the power to the lift motors from -127 to 127, where negative power raises the lift
  */
-inline void setLiftMotors(int spd) {
-	motorSet(LIFT_TOP_Y_MOTOR, -spd * MOTOR_SPEED);
-	motorSet(LIFT_MIDDLE_LEFT_MOTOR, spd * MOTOR_SPEED);
-	motorSet(LIFT_MIDDLE_RIGHT_MOTOR, -spd * MOTOR_SPEED);
- 	motorSet(LIFT_BOTTOM_LEFT_MOTOR, spd * MOTOR_SPEED);
-	motorSet(LIFT_BOTTOM_RIGHT_MOTOR, -spd * MOTOR_SPEED);
+inline void setLiftMotors(int power) {
+	motorOutputSet(LIFT_TOP_Y_MOTOR, -power);
+	motorOutputSet(LIFT_MIDDLE_LEFT_MOTOR, power);
+	motorOutputSet(LIFT_MIDDLE_RIGHT_MOTOR, -power);
+ 	motorOutputSet(LIFT_BOTTOM_LEFT_MOTOR, power);
+	motorOutputSet(LIFT_BOTTOM_RIGHT_MOTOR, -power);
 }
 
 #ifdef __cplusplus
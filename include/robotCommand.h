@@ -0,0 +1,128 @@
+/** @file robotCommand.h
+ * @brief File for the command shared between the sources that drive the robot and the code that moves it
+ *
+ * The driver (recordJoyInfo()) and autonomous playback each publish the command they want as a joyState into a slot
+ * of their own, and moveRobot() combines the fresh ones by the arbitration policy and moves the robot with the
+ * result, which is published in turn for telemetry and logging. Each slot has a single writer and is double buffered:
+ * the writer fills the buffer that readers are not being pointed at and then bumps a sequence number to publish it.
+ * Readers copy the published buffer and copy again only if a publish completed in the meantime, so no task ever waits
+ * on a lock or on a writer that was interrupted part way through, whatever the priorities of the tasks.
+ */
+
+#ifndef ROBOT_COMMAND_H
+
+// This prevents multiple inclusion
+#define ROBOT_COMMAND_H
+
+#include <API.h>
+#include "autonrecorder.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Time in milliseconds after which a command that has not been published again is ignored, so that a source that
+ * stopped, such as a task killed by a change of competition mode, does not keep driving the robot
+ */
+#define COMMAND_STALE_TIME 100
+
+/**
+ * The slots that commands are published in, one for each writer
+ */
+typedef enum commandSource {
+	/**
+	 * The driver's joysticks, published by recordJoyInfo()
+	 */
+	COMMAND_SOURCE_DRIVER,
+	/**
+	 * Autonomous playback, published by the playback loops
+	 */
+	COMMAND_SOURCE_PLAYBACK,
+	/**
+	 * The command the robot was last moved with, published by commandArbitrate()
+	 */
+	COMMAND_SOURCE_OUTPUT,
+	/**
+	 * Number of slots
+	 */
+	COMMAND_NUM_SOURCES
+} commandSource;
+
+/**
+ * How the driver's and the playback's commands are combined while both are fresh; while only one is fresh, it is used
+ * as it is
+ */
+typedef enum commandPolicy {
+	/**
+	 * Playback drives and the driver is ignored, so a routine plays back exactly as recorded
+	 */
+	COMMAND_POLICY_PLAYBACK,
+	/**
+	 * The driver takes over for as long as any stick or button of theirs is commanding something
+	 */
+	COMMAND_POLICY_OVERRIDE,
+	/**
+	 * The driver's drive axes are added to the playback's, so the driver can nudge a routine off its path; the pincer
+	 * and the lift follow the driver while the driver is commanding them
+	 */
+	COMMAND_POLICY_BLEND,
+	/**
+	 * Number of policies
+	 */
+	COMMAND_NUM_POLICIES
+} commandPolicy;
+
+/**
+ * Publishes a new command from a source; only the one task that owns the source may call this
+ *
+ * @param source the COMMAND_SOURCE_* slot to publish in
+ * @param command the command
+ */
+void commandPublish(commandSource source, const joyState* command);
+
+/**
+ * Withdraws the command of a source, such as when playback ends, so that it is ignored until it is published again
+ *
+ * @param source the COMMAND_SOURCE_* slot to withdraw
+ */
+void commandWithdraw(commandSource source);
+
+/**
+ * Copies the latest command of a source without blocking
+ *
+ * @param source the COMMAND_SOURCE_* slot to read
+ * @param command filled in with the command, or with a stopped command if the source is withdrawn or stale
+ *
+ * @return true if the source has a fresh command
+ */
+bool commandRead(commandSource source, joyState* command);
+
+/**
+ * Combines the fresh commands of the driver and the playback by the arbitration policy and publishes the result as
+ * COMMAND_SOURCE_OUTPUT; called by moveRobot() every control tick
+ *
+ * @param command filled in with the command to move the robot with, which is stopped if neither source is fresh
+ */
+void commandArbitrate(joyState* command);
+
+/**
+ * Sets how the driver's and the playback's commands are combined
+ *
+ * @param policy the COMMAND_POLICY_* policy; COMMAND_POLICY_PLAYBACK until this is called
+ */
+void commandSetPolicy(commandPolicy policy);
+
+/**
+ * Gets how the driver's and the playback's commands are combined
+ *
+ * @return the COMMAND_POLICY_* policy
+ */
+commandPolicy commandGetPolicy();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/** @file sensors.h
+ * @brief File for the high-rate sensor acquisition task
+ *
+ * Samples every sensor at SENSOR_SAMPLE_FREQ on a task of its own and publishes each sample as a timestamped
+ * snapshot. The control loop, the autonomous recorder and any other reader take a copy of the latest snapshot with
+ * readSensors(), which never blocks and never touches the sensor hardware, so reading the sensors costs the same no
+ * matter how many are connected. Snapshots are published with a sequence lock: the sampler bumps a sequence number
+ * before and after writing, and a reader that sees the number change while copying copies again.
+ */
+
+#ifndef SENSORS_H
+
+// This prevents multiple inclusion
+#define SENSORS_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Rate at which the sensors are sampled in Hz
+ */
+#define SENSOR_SAMPLE_FREQ 1000
+
+/**
+ * Number of IMEs that are sampled, starting at address 0
+ */
+#define SENSOR_NUM_IMES 4
+
+/**
+ * Digital port of the top wire of the lift quadrature encoder, which counts up as the lift rises, or 0 if there is no
+ * encoder
+ */
+#define SENSOR_ENCODER_TOP_PORT 0
+/**
+ * Digital port of the bottom wire of the lift quadrature encoder
+ */
+#define SENSOR_ENCODER_BOTTOM_PORT 0
+
+/**
+ * Digital port of the orange (echo) wire of the ultrasonic sensor, or 0 if there is no ultrasonic sensor
+ */
+#define SENSOR_ULTRASONIC_ECHO_PORT 0
+/**
+ * Digital port of the yellow (ping) wire of the ultrasonic sensor
+ */
+#define SENSOR_ULTRASONIC_PING_PORT 0
+
+/**
+ * A struct that holds one sample of every sensor
+ */
+typedef struct sensorSnapshot {
+	/**
+	 * The time in microseconds at which the sample was taken
+	 */
+	unsigned long time;
+
+	/**
+	 * The number of samples taken before this one, so readers can tell a new snapshot from one they have seen
+	 */
+	unsigned long sample;
+
+	/**
+	 * The count of each IME, indexed by IME address, or 0 for IMEs that were not found
+	 */
+	int imes[SENSOR_NUM_IMES];
+
+	/**
+	 * The heading of the drive gyro in degrees, or 0 if there is no gyro
+	 */
+	int gyro;
+
+	/**
+	 * The count of the lift quadrature encoder, or 0 if there is no encoder
+	 */
+	int encoder;
+
+	/**
+	 * The distance measured by the ultrasonic sensor in centimeters, or 0 if nothing was in range or there is no
+	 * ultrasonic sensor
+	 */
+	int ultrasonic;
+} sensorSnapshot;
+
+/**
+ * Initializes the sensors and starts the sampling task. Must be called from initialize() before anything reads the
+ * sensors.
+ */
+void initSensors();
+
+/**
+ * Gets the number of IMEs that were found when the sensors were initialized
+ *
+ * @return the number of IMEs chained to the Cortex
+ */
+unsigned int sensorImeCount();
+
+/**
+ * Gets whether the drive gyro was initialized
+ *
+ * @return true if the gyro heading is sampled, false otherwise
+ */
+bool sensorGyroPresent();
+
+/**
+ * Copies the latest snapshot without blocking. Must not be called from a task with a higher priority than the
+ * sampling task, which runs at TASK_PRIORITY_HIGHEST.
+ *
+ * @param snapshot filled in with the latest sample of every sensor
+ */
+void readSensors(sensorSnapshot* snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+/** @file serialLink.h
+ * @brief File for the robot end of the framed serial link
+ *
+ * Sends and receives linkProtocol.h frames over a UART at high baud, so that routines can be moved between the robot
+ * and a computer running tools/autonlink in well under a second. The link uses its own UART instead of the PC debug
+ * terminal, which is slow and shared with the log output. Only one task may use the link at a time.
+ */
+
+#ifndef SERIAL_LINK_H
+
+// This prevents multiple inclusion
+#define SERIAL_LINK_H
+
+#include <API.h>
+#include "linkProtocol.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The UART the link uses; uart1 holds the LCD
+ */
+#define SERIAL_LINK_PORT uart2
+
+/**
+ * Baud rate of the link, which USB serial adapters and the Cortex UART both handle reliably
+ */
+#define SERIAL_LINK_BAUD 460800
+
+/**
+ * Milliseconds the robot waits for the computer to start a transfer
+ */
+#define SERIAL_LINK_WAIT 30000
+
+/**
+ * Opens the link UART; called from initializeIO()
+ */
+void serialLinkInit();
+
+/**
+ * Discards any bytes that have been received but not read, such as the remains of an abandoned transfer
+ */
+void serialLinkFlush();
+
+/**
+ * Sends a frame
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ */
+void serialLinkSend(uint8_t type, uint8_t seq, const void* payload, int length);
+
+/**
+ * Waits for the next frame
+ *
+ * @param frame receives the frame
+ * @param timeout the longest time to wait in milliseconds
+ *
+ * @return LINK_DECODE_FRAME if a frame was received, LINK_DECODE_CORRUPT if a corrupt frame was received, or
+ * LINK_DECODE_PENDING if nothing arrived before the timeout
+ */
+int serialLinkReceive(linkFrame* frame, unsigned long timeout);
+
+/**
+ * Sends a frame and waits for it to be acknowledged, sending it again after a NAK, a corrupt reply or LINK_TIMEOUT
+ * without a reply, up to LINK_MAX_RETRIES times
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ *
+ * @return the LINK_STATUS_* byte of the acknowledgement, or -1 if the frame was never acknowledged
+ */
+int serialLinkRequest(uint8_t type, uint8_t seq, const void* payload, int length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/** @file stickShaping.h
+ * @brief File for the joystick response curve lookup tables
+ *
+ * Each response curve is a 256-entry table, indexed by the raw joystick value plus 128, that holds the shaped value
+ * with the deadband already applied. The tables are built from integer constant expressions, so they are computed by
+ * the compiler and placed in flash, and shaping an axis at runtime costs a single lookup.
+ */
+
+#ifndef STICK_SHAPING_H
+
+// This prevents multiple inclusion
+#define STICK_SHAPING_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of entries in a response curve table
+ */
+#define STICK_CURVE_SIZE 256
+
+/**
+ * Linear response, the raw joystick value
+ */
+#define STICK_LINEAR(X) (X)
+
+/**
+ * Cubic response, which keeps full speed at the end of the stick but softens the middle
+ */
+#define STICK_CUBIC(X) ((X) * (X) * (X) / (127 * 127))
+
+/**
+ * Quartic response with the sign of the input, the curve that used to be applied to horizontal motion with pow()
+ */
+#define STICK_QUARTIC(X) (((X) < 0 ? -1 : 1) * ((X) * (X) * (X) * (X) / (127 * 127 * 127)))
+
+/**
+ * A set of response curves for the drive axes, chosen by the driver
+ */
+typedef struct stickProfile {
+	/**
+	 * The name of the profile shown on the LCD
+	 */
+	const char* name;
+
+	/**
+	 * The response curve of forward/backward motion
+	 */
+	const signed char* forward;
+
+	/**
+	 * The response curve of horizontal motion
+	 */
+	const signed char* horizontal;
+
+	/**
+	 * The response curve of turning
+	 */
+	const signed char* turn;
+} stickProfile;
+
+/**
+ * Linear response curve with deadband
+ */
+extern const signed char stickCurveLinear[STICK_CURVE_SIZE];
+
+/**
+ * Cubic response curve with deadband
+ */
+extern const signed char stickCurveCubic[STICK_CURVE_SIZE];
+
+/**
+ * Quartic response curve with deadband
+ */
+extern const signed char stickCurveQuartic[STICK_CURVE_SIZE];
+
+/**
+ * Number of driver profiles in stickProfiles
+ */
+#define STICK_NUM_PROFILES 3
+
+/**
+ * The driver profiles, starting with the default profile
+ */
+extern const stickProfile stickProfiles[STICK_NUM_PROFILES];
+
+/**
+ * Shapes a joystick axis from the snapshot taken by driverInputPoll() with a response curve
+ *
+ * @param joystick the joystick to read (1 or 2)
+ * @param axis the axis to read (1 - 4)
+ * @param curve the response curve to shape the value with
+ *
+ * @return the shaped value of the axis from -127 to 127
+ */
+int stickRead(unsigned char joystick, unsigned char axis, const signed char* curve);
+
+/**
+ * Gets the driver profile in use
+ *
+ * @return the active driver profile
+ */
+const stickProfile* stickGetProfile();
+
+/**
+ * Selects the driver profile to use
+ *
+ * @param index the index of the profile in stickProfiles; out of range values are ignored
+ */
+void stickSetProfile(int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
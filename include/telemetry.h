@@ -0,0 +1,92 @@
+/** @file telemetry.h
+ * @brief File for the binary telemetry stream
+ *
+ * Every tick of a loop watched by the deadline watchdog is sent out of TELEMETRY_PORT as one LINK_FRAME_TELEMETRY
+ * frame, laid out as described in linkProtocol.h: the joystick state, the power committed to every motor, the main
+ * battery voltage, the latest sensor snapshot and the timing of the tick. The control loop only encodes the frame into
+ * a ring buffer; a low priority task writes the buffer to the UART, so a slow UART drops frames instead of holding up
+ * the loop. Run "autonlink telemetry <file>" on the computer to save the stream as CSV.
+ *
+ * The stream shares the UART with the autonomous file transfers, so it is paused while a transfer runs, and it is the
+ * last thing the deadline watchdog sheds when the loop falls behind.
+ */
+
+#ifndef TELEMETRY_H
+
+// This prevents multiple inclusion
+#define TELEMETRY_H
+
+#include <API.h>
+#include "deadline.h"
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Streams telemetry; comment this out to compile the telemetry calls away
+ */
+#define TELEMETRY_ENABLED
+
+/**
+ * UART the telemetry is written to
+ */
+#define TELEMETRY_PORT SERIAL_LINK_PORT
+
+/**
+ * Size of the ring buffer in bytes, a power of two; holds about 18 frames
+ */
+#define TELEMETRY_BUFFER_SIZE 1024
+
+/**
+ * Most bytes the writing task hands the UART at once
+ */
+#define TELEMETRY_WRITE_SIZE 64
+
+/**
+ * Time in milliseconds the writing task waits between emptying the ring buffer
+ */
+#define TELEMETRY_DRAIN_PERIOD 5
+
+#ifdef TELEMETRY_ENABLED
+/**
+ * Starts the task that writes the telemetry to the UART; called from initialize()
+ */
+void initTelemetry();
+
+/**
+ * Queues the telemetry frame of a tick, or drops it if the ring buffer is full. Called by deadlineWait() at the end
+ * of every watched tick.
+ *
+ * @param monitor the monitor of the loop the tick belongs to
+ * @param work the time in microseconds that the work of the tick took
+ */
+void telemetryRecord(const deadlineMonitor* monitor, unsigned long work);
+
+/**
+ * Stops or resumes the stream, waiting for the writing task to finish a write in progress before stopping; frames
+ * queued before stopping are discarded
+ *
+ * @param paused true to stop sending, false to resume
+ */
+void telemetrySetPaused(bool paused);
+
+/**
+ * Gets the number of frames dropped because the ring buffer was full
+ *
+ * @return the number of frames dropped since the robot started
+ */
+unsigned long telemetryDropped();
+#else
+#define initTelemetry() ((void) 0)
+#define telemetryRecord(monitor, work) ((void) (work))
+#define telemetrySetPaused(paused) ((void) (paused))
+#define telemetryDropped() 0UL
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,244 @@
+/** @file sim.h
+ * @brief File for the host-side simulation of the PROS API
+ *
+ * simApi.c implements the functions declared in include/API.h for an x86 host, so that the robot sources in src/ can
+ * be compiled and run unmodified on a development machine. Motors, joysticks, the LCD, IMEs and the flash filesystem
+ * are simulated in memory, tasks run as POSIX threads, and the functions declared here let a simulation script drive
+ * the inputs and inspect the outputs.
+ *
+ * Time is warped: micros() and millis() follow the real clock, but when the main thread calls delay() or
+ * taskDelayUntil() the clock jumps forward instead of sleeping. Code therefore runs as fast as the host allows while
+ * every stage still takes its real host duration, which keeps the profiler and loop timer statistics meaningful.
+ * Tasks created with taskCreate() sleep in real time until the warped clock reaches their deadline.
+ */
+
+#ifndef SIM_H
+
+// This prevents multiple inclusion
+#define SIM_H
+
+#include <API.h>
+
+// Allow usage of this file in C++ programs
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Number of motor ports on the simulated Cortex
+ */
+#define SIM_NUM_MOTORS 10
+
+/**
+ * Number of IMEs on the simulated robot
+ */
+#define SIM_NUM_IMES 4
+
+/**
+ * Motor power at which a simulated IME counts one tick per millisecond on a SIM_BATTERY_NOMINAL battery
+ */
+#define SIM_IME_POWER_PER_TICK 127
+
+/**
+ * Battery voltage in millivolts that the simulation starts with; motors turn in proportion to the battery voltage
+ */
+#define SIM_BATTERY_NOMINAL 8000
+
+/**
+ * Most motor snapshots that can be traced at once
+ */
+#define SIM_MAX_TRACE 4096
+
+/**
+ * Most bytes written to SERIAL_LINK_PORT that can be captured at once
+ */
+#define SIM_MAX_LINK_CAPTURE 262144
+
+/**
+ * @brief The state of joystick 1 for one frame of a joystick script
+ */
+typedef struct simJoyFrame {
+	/**
+	 * The values of analog axes 1 - 4
+	 */
+	signed char analog[4];
+	/**
+	 * The JOY_* bits held in button groups 5 - 8
+	 */
+	unsigned char digital[4];
+} simJoyFrame;
+
+/**
+ * Resets the simulation and makes the calling thread the main thread, whose delays warp the clock
+ */
+void simInit();
+
+/**
+ * Gets the real time since simInit(), without the time skipped by delays
+ *
+ * @return the real elapsed time in microseconds
+ */
+unsigned long simRealMicros();
+
+/**
+ * Sets whether text written to the serial port (printf() and log messages) is copied to the host's standard output
+ *
+ * @param echo true to show serial output, false to discard it
+ */
+void simSetSerialEcho(bool echo);
+
+/**
+ * Sets the competition state reported by isEnabled(), isAutonomous() and isOnline()
+ *
+ * @param enabled whether the robot is enabled
+ * @param autonomous whether the robot is in autonomous mode
+ * @param online whether a competition switch or field controller is connected
+ */
+void simSetCompetition(bool enabled, bool autonomous, bool online);
+
+/**
+ * Sets the main battery voltage reported by powerLevelMain()
+ *
+ * @param millivolts the battery voltage in millivolts
+ */
+void simSetBattery(unsigned int millivolts);
+
+/**
+ * Sets an analog axis of a joystick
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param axis the axis (1 - 4)
+ * @param value the value of the axis from -127 to 127
+ */
+void simSetJoystickAnalog(unsigned char joystick, unsigned char axis, int value);
+
+/**
+ * Sets the buttons held in a button group of a joystick
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param buttonGroup the button group (5 - 8)
+ * @param buttons the JOY_* bits of the held buttons
+ */
+void simSetJoystickDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char buttons);
+
+/**
+ * Plays a script of frames on joystick 1, overriding the values set with simSetJoystickAnalog() and
+ * simSetJoystickDigital()
+ * The script starts at the first joystick read after this call and advances one frame per period. Joystick 1 reads
+ * zero once the script has run out.
+ *
+ * @param frames the frames to play, which must stay valid until the script has finished
+ * @param numFrames the number of frames
+ * @param period the length of each frame in milliseconds
+ */
+void simPlayJoystick(const simJoyFrame* frames, int numFrames, unsigned long period);
+
+/**
+ * Queues LCD buttons to be held, after the buttons queued before them have been released
+ * Each entry starts at the first lcdReadButtons() call after the previous entry has ended, so every entry is seen.
+ *
+ * @param buttons the LCD_BTN_* bits to hold, or 0 for no buttons
+ * @param duration how long to hold them in milliseconds
+ */
+void simQueueLcdButtons(unsigned int buttons, unsigned long duration);
+
+/**
+ * Gets the text displayed on a line of the LCD
+ *
+ * @param line the line (1 or 2)
+ *
+ * @return the text on the line
+ */
+const char* simLcdLine(unsigned char line);
+
+/**
+ * Gets the number of lcdSetText() calls since simInit()
+ *
+ * @return the number of LCD line writes
+ */
+unsigned long simLcdWrites();
+
+/**
+ * Gets the power last set on a motor port
+ *
+ * @param port the motor port (1 - 10)
+ *
+ * @return the power of the motor
+ */
+int simMotor(unsigned char port);
+
+/**
+ * Gets the number of motorSet() calls since simInit()
+ *
+ * @return the number of motor writes
+ */
+unsigned long simMotorWrites();
+
+/**
+ * Starts recording the power of every motor each time the main thread calls taskDelayUntil(), the end of a control
+ * tick, replacing any earlier trace
+ */
+void simStartMotorTrace();
+
+/**
+ * Gets the motor trace recorded since simStartMotorTrace()
+ *
+ * @param length receives the number of traced ticks
+ *
+ * @return the motor powers of each traced tick, SIM_NUM_MOTORS per tick
+ */
+const signed char* simGetMotorTrace(int* length);
+
+/**
+ * Starts capturing the bytes written to SERIAL_LINK_PORT while no pseudo-terminal is connected, such as the telemetry
+ * stream, replacing any earlier capture
+ */
+void simStartLinkCapture();
+
+/**
+ * Gets the bytes written to SERIAL_LINK_PORT since simStartLinkCapture() and stops capturing
+ *
+ * @param length receives the number of bytes captured
+ *
+ * @return the captured bytes
+ */
+const uint8_t* simStopLinkCapture(int* length);
+
+/**
+ * Connects SERIAL_LINK_PORT to a new pseudo-terminal, so that host tools such as tools/autonlink can talk to the
+ * simulated robot as if it were plugged in
+ * Without this, the link port never receives anything and discards what is written to it, unless it is being captured
+ * with simStartLinkCapture().
+ *
+ * @return the path of the pseudo-terminal for the host tool to open, or NULL if it could not be created
+ */
+const char* simOpenLink();
+
+/**
+ * Deletes every file in the simulated flash filesystem
+ */
+void simResetFlash();
+
+/**
+ * Gets the size of a file in the simulated flash filesystem
+ *
+ * @param file the name of the file
+ *
+ * @return the size of the file in bytes, or -1 if it does not exist
+ */
+int simFileSize(const char* file);
+
+/**
+ * Gets the number of times a file in the simulated flash filesystem has been opened for reading
+ *
+ * @param file the name of the file
+ *
+ * @return the number of times the file was opened for reading, or 0 if it does not exist
+ */
+int simFileReads(const char* file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1383 @@
+/** @file simApi.c
+ * @brief File for the host-side implementation of the PROS API
+ *
+ * Implements the parts of include/API.h that the robot code uses, plus their obvious companions, on top of POSIX.
+ * This file cannot include <stdio.h> because API.h defines its own FILE, so host output goes through write() and
+ * vsnprintf() is declared locally. The robot's printf(), fopen() and friends defined here take the place of the C
+ * library's in the simulation executable.
+ */
+
+#define _GNU_SOURCE
+#include "main.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Provided by the host C library but declared in <stdio.h>, which conflicts with API.h
+ */
+int vsnprintf(char* buffer, size_t limit, const char* formatString, va_list args);
+
+/**
+ * Most files the simulated flash filesystem can hold
+ */
+#define SIM_MAX_FILES 64
+
+/**
+ * Most files that can be open at once
+ */
+#define SIM_MAX_HANDLES 16
+
+/**
+ * The FILE number of the first flash file handle, after uart1, uart2 and stdout
+ */
+#define SIM_FIRST_HANDLE 4
+
+/**
+ * Most entries the LCD button queue can hold
+ */
+#define SIM_MAX_LCD_QUEUE 128
+
+/**
+ * Block time passed by the robot code to wait forever
+ */
+#define SIM_WAIT_FOREVER 0xFFFFFFFFUL
+
+/**
+ * Real time in microseconds that tasks sleep between checks of the warped clock
+ */
+#define SIM_POLL_MICROS 100
+
+/**
+ * Most periodic tasks above the default priority that the main thread waits for
+ */
+#define SIM_MAX_PERIODIC_TASKS 4
+
+/**
+ * @brief A file in the simulated flash filesystem
+ */
+typedef struct simFile {
+	/**
+	 * Whether this entry holds a file
+	 */
+	bool used;
+	/**
+	 * The name of the file
+	 */
+	char name[AUTON_FILENAME_MAX_LENGTH + 8];
+	/**
+	 * The contents of the file
+	 */
+	unsigned char* data;
+	/**
+	 * The size of the file in bytes
+	 */
+	int size;
+	/**
+	 * The number of bytes allocated for data
+	 */
+	int capacity;
+	/**
+	 * The number of times the file has been opened for reading
+	 */
+	int reads;
+} simFile;
+
+/**
+ * @brief An open file in the simulated flash filesystem
+ */
+typedef struct simHandle {
+	/**
+	 * The open file, or NULL if this handle is free
+	 */
+	simFile* file;
+	/**
+	 * The position of the next read or write
+	 */
+	int position;
+	/**
+	 * Whether the file was opened for writing
+	 */
+	bool write;
+} simHandle;
+
+/**
+ * @brief A simulated semaphore or mutex
+ */
+typedef struct simSemaphore {
+	/**
+	 * Protects given
+	 */
+	pthread_mutex_t lock;
+	/**
+	 * Signalled when the semaphore is given
+	 */
+	pthread_cond_t cond;
+	/**
+	 * Whether the semaphore can be taken
+	 */
+	bool given;
+} simSemaphore;
+
+/**
+ * @brief The code and parameter of a task started with taskCreate()
+ */
+typedef struct simTask {
+	/**
+	 * The function the task runs
+	 */
+	TaskCode code;
+	/**
+	 * The parameter passed to the function
+	 */
+	void* parameters;
+	/**
+	 * The priority the task was created with
+	 */
+	unsigned int priority;
+	/**
+	 * The time in milliseconds the task is waiting for in taskDelayUntil(), valid while sleeping is set
+	 */
+	volatile unsigned long wakeTime;
+	/**
+	 * Whether the task is waiting in taskDelayUntil()
+	 */
+	volatile bool sleeping;
+	/**
+	 * The value of periodicRelease when the task started waiting
+	 */
+	volatile unsigned long release;
+	/**
+	 * Whether the task has been added to periodicTasks
+	 */
+	bool periodic;
+} simTask;
+
+/**
+ * @brief LCD buttons held for a duration, queued with simQueueLcdButtons()
+ */
+typedef struct simLcdPress {
+	/**
+	 * The LCD_BTN_* bits held
+	 */
+	unsigned int buttons;
+	/**
+	 * How long the buttons are held in milliseconds
+	 */
+	unsigned long duration;
+} simLcdPress;
+
+/**
+ * The thread that called simInit(), whose delays warp the clock
+ */
+static pthread_t mainThread;
+
+/**
+ * The real time at which simInit() was called
+ */
+static struct timespec startTime;
+
+/**
+ * The time in microseconds that delays on the main thread have skipped
+ */
+static volatile unsigned long skippedMicros;
+
+/**
+ * Whether serial output is copied to the host's standard output
+ */
+static volatile bool serialEcho = true;
+
+/**
+ * The competition state
+ */
+static volatile bool simEnabled = true, simAutonomous = false, simOnline = false;
+
+/**
+ * The main battery voltage in millivolts
+ */
+static volatile unsigned int batteryMillivolts = SIM_BATTERY_NOMINAL;
+
+/**
+ * The power of each motor port
+ */
+static volatile int motors[SIM_NUM_MOTORS];
+
+/**
+ * The number of motorSet() calls
+ */
+static unsigned long motorWrites;
+
+/**
+ * The position of each IME in ticks, scaled by SIM_IME_POWER_PER_TICK
+ */
+static long imePositions[SIM_NUM_IMES];
+
+/**
+ * The motor port that turns each IME
+ */
+static const unsigned char imeMotors[SIM_NUM_IMES] = {
+	[FRONT_LEFT_IME] = FRONT_LEFT_MOTOR, [FRONT_RIGHT_IME] = FRONT_RIGHT_MOTOR,
+	[BACK_LEFT_IME] = BACK_LEFT_MOTOR, [BACK_RIGHT_IME] = BACK_RIGHT_MOTOR
+};
+
+/**
+ * The motor powers recorded at each tick since simStartMotorTrace()
+ */
+static signed char motorTrace[SIM_MAX_TRACE][SIM_NUM_MOTORS];
+
+/**
+ * The number of ticks in motorTrace
+ */
+static int motorTraceLength;
+
+/**
+ * Whether motor powers are being traced
+ */
+static bool motorTracing;
+
+/**
+ * The bytes written to SERIAL_LINK_PORT since simStartLinkCapture()
+ */
+static uint8_t linkCapture[SIM_MAX_LINK_CAPTURE];
+
+/**
+ * The number of bytes in linkCapture
+ */
+static int linkCaptureLength;
+
+/**
+ * Whether the bytes written to SERIAL_LINK_PORT are being captured
+ */
+static bool linkCapturing;
+
+/**
+ * Protects the link capture, which the telemetry task fills alongside the main thread
+ */
+static pthread_mutex_t captureLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * The analog axes of both joysticks
+ */
+static volatile int joyAnalog[2][4];
+
+/**
+ * The buttons held in groups 5 - 8 of both joysticks
+ */
+static volatile unsigned char joyDigital[2][4];
+
+/**
+ * The joystick 1 script, or NULL if none is playing
+ */
+static const simJoyFrame* joyScript;
+
+/**
+ * The number of frames in the joystick script
+ */
+static int joyScriptLength;
+
+/**
+ * The length of each joystick script frame in milliseconds
+ */
+static unsigned long joyScriptPeriod;
+
+/**
+ * The time in microseconds at which the joystick script started, or 0 if it has not been read yet
+ */
+static unsigned long joyScriptStart;
+
+/**
+ * The text on each line of the LCD
+ */
+static char lcdLines[2][LCD_MESSAGE_MAX_LENGTH + 1];
+
+/**
+ * The number of lcdSetText() calls
+ */
+static unsigned long lcdWrites;
+
+/**
+ * Queued LCD button presses, a ring buffer starting at lcdQueueHead
+ */
+static simLcdPress lcdQueue[SIM_MAX_LCD_QUEUE];
+
+/**
+ * The index of the LCD press being held and the number of queued presses, including that one
+ */
+static int lcdQueueHead, lcdQueueLength;
+
+/**
+ * The time in microseconds at which the press at lcdQueueHead started, or 0 if it has not been read yet
+ */
+static unsigned long lcdPressStart;
+
+/**
+ * Protects the LCD button queue
+ */
+static pthread_mutex_t lcdLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * The simulated flash filesystem
+ */
+static simFile files[SIM_MAX_FILES];
+
+/**
+ * The open flash files
+ */
+static simHandle handles[SIM_MAX_HANDLES];
+
+/**
+ * Protects files and handles, which the chunk loader task uses alongside the main thread
+ */
+static pthread_mutex_t fileLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * The master side of the pseudo-terminal behind SERIAL_LINK_PORT, or -1 if simOpenLink() has not been called
+ */
+static int linkMaster = -1;
+
+/**
+ * The path of the link pseudo-terminal
+ */
+static char linkPath[64];
+
+/**
+ * Tasks above the default priority that run periodically with taskDelayUntil(), which run before each tick of the
+ * main thread the way they would preempt it on the robot
+ */
+static simTask* periodicTasks[SIM_MAX_PERIODIC_TASKS];
+
+/**
+ * The number of tasks in periodicTasks
+ */
+static volatile int numPeriodicTasks;
+
+/**
+ * Incremented each time the main thread skips time, which is the only time the periodic tasks are woken so that they
+ * never run in the middle of a tick of the main thread
+ */
+static volatile unsigned long periodicRelease;
+
+/**
+ * The task running on the calling thread, or NULL on the main thread and threads the robot code did not create
+ */
+static __thread simTask* currentTask;
+
+/**
+ * Whether the calling thread is the main thread
+ *
+ * @return true on the main thread
+ */
+static bool onMainThread() {
+	return pthread_equal(pthread_self(), mainThread);
+}
+
+/**
+ * Sleeps for a short real time while another thread makes progress
+ */
+static void pollSleep() {
+	struct timespec wait = { 0, SIM_POLL_MICROS * 1000L };
+	nanosleep(&wait, NULL);
+}
+
+/**
+ * Writes text to the host's standard output if serial echo is on
+ *
+ * @param text the text to write
+ * @param length the number of bytes to write
+ */
+static void writeSerial(const char* text, size_t length) {
+	if (serialEcho && length > 0) {
+		ssize_t ignored = write(STDOUT_FILENO, text, length);
+		(void) ignored;
+	}
+}
+
+/**
+ * Resets the simulation and makes the calling thread the main thread, whose delays warp the clock
+ */
+void simInit() {
+	mainThread = pthread_self();
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	skippedMicros = 0;
+	motorWrites = 0;
+	lcdWrites = 0;
+	motorTracing = false;
+	linkCapturing = false;
+	linkCaptureLength = 0;
+	memset((void*) motors, 0, sizeof(motors));
+	memset(imePositions, 0, sizeof(imePositions));
+	memset((void*) joyAnalog, 0, sizeof(joyAnalog));
+	memset((void*) joyDigital, 0, sizeof(joyDigital));
+	joyScript = NULL;
+	for (int i = 0; i < 2; i++) {
+		memset(lcdLines[i], ' ', LCD_MESSAGE_MAX_LENGTH);
+		lcdLines[i][LCD_MESSAGE_MAX_LENGTH] = 0;
+	}
+	lcdQueueHead = lcdQueueLength = 0;
+}
+
+/**
+ * Gets the real time since simInit(), without the time skipped by delays
+ *
+ * @return the real elapsed time in microseconds
+ */
+unsigned long simRealMicros() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - startTime.tv_sec) * 1000000UL + (now.tv_nsec - startTime.tv_nsec) / 1000;
+}
+
+/**
+ * Sets whether text written to the serial port (printf() and log messages) is copied to the host's standard output
+ *
+ * @param echo true to show serial output, false to discard it
+ */
+void simSetSerialEcho(bool echo) {
+	serialEcho = echo;
+}
+
+/**
+ * Sets the competition state reported by isEnabled(), isAutonomous() and isOnline()
+ *
+ * @param enabled whether the robot is enabled
+ * @param autonomous whether the robot is in autonomous mode
+ * @param online whether a competition switch or field controller is connected
+ */
+void simSetCompetition(bool enabled, bool autonomous, bool online) {
+	simEnabled = enabled;
+	simAutonomous = autonomous;
+	simOnline = online;
+}
+
+/**
+ * Sets the main battery voltage reported by powerLevelMain()
+ *
+ * @param millivolts the battery voltage in millivolts
+ */
+void simSetBattery(unsigned int millivolts) {
+	batteryMillivolts = millivolts;
+}
+
+/**
+ * Sets an analog axis of a joystick
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param axis the axis (1 - 4)
+ * @param value the value of the axis from -127 to 127
+ */
+void simSetJoystickAnalog(unsigned char joystick, unsigned char axis, int value) {
+	if (joystick >= 1 && joystick <= 2 && axis >= 1 && axis <= 4) {
+		joyAnalog[joystick - 1][axis - 1] = CLAMP(value, -127, 127);
+	}
+}
+
+/**
+ * Sets the buttons held in a button group of a joystick
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param buttonGroup the button group (5 - 8)
+ * @param buttons the JOY_* bits of the held buttons
+ */
+void simSetJoystickDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char buttons) {
+	if (joystick >= 1 && joystick <= 2 && buttonGroup >= 5 && buttonGroup <= 8) {
+		joyDigital[joystick - 1][buttonGroup - 5] = buttons;
+	}
+}
+
+/**
+ * Plays a script of frames on joystick 1, overriding the values set with simSetJoystickAnalog() and
+ * simSetJoystickDigital()
+ * The script starts at the first joystick read after this call and advances one frame per period. Joystick 1 reads
+ * zero once the script has run out.
+ *
+ * @param frames the frames to play, which must stay valid until the script has finished
+ * @param numFrames the number of frames
+ * @param period the length of each frame in milliseconds
+ */
+void simPlayJoystick(const simJoyFrame* frames, int numFrames, unsigned long period) {
+	joyScriptLength = numFrames;
+	joyScriptPeriod = MAX(period, 1);
+	joyScriptStart = 0;
+	joyScript = frames;
+}
+
+/**
+ * Gets the joystick script frame for the current time
+ *
+ * @return the current frame, or NULL if the script has run out
+ */
+static const simJoyFrame* currentJoyFrame() {
+	if (joyScriptStart == 0) {
+		joyScriptStart = MAX(micros(), 1);
+	}
+	// Round to the nearest frame so that ticks released slightly after a frame boundary still read that frame
+	unsigned long period = joyScriptPeriod * 1000;
+	unsigned long frame = (micros() - joyScriptStart + period / 2) / period;
+	return (frame < (unsigned long) joyScriptLength) ? &joyScript[frame] : NULL;
+}
+
+/**
+ * Queues LCD buttons to be held, after the buttons queued before them have been released
+ * Each entry starts at the first lcdReadButtons() call after the previous entry has ended.
+ *
+ * @param buttons the LCD_BTN_* bits to hold, or 0 for no buttons
+ * @param duration how long to hold them in milliseconds
+ */
+void simQueueLcdButtons(unsigned int buttons, unsigned long duration) {
+	pthread_mutex_lock(&lcdLock);
+	if (lcdQueueLength < SIM_MAX_LCD_QUEUE) {
+		if (lcdQueueLength == 0) {
+			lcdPressStart = 0;
+		}
+		simLcdPress* press = &lcdQueue[(lcdQueueHead + lcdQueueLength) % SIM_MAX_LCD_QUEUE];
+		press->buttons = buttons;
+		press->duration = duration;
+		lcdQueueLength++;
+	}
+	pthread_mutex_unlock(&lcdLock);
+}
+
+/**
+ * Gets the text displayed on a line of the LCD
+ *
+ * @param line the line (1 or 2)
+ *
+ * @return the text on the line
+ */
+const char* simLcdLine(unsigned char line) {
+	return lcdLines[(line == 2) ? 1 : 0];
+}
+
+/**
+ * Gets the number of lcdSetText() calls since simInit()
+ *
+ * @return the number of LCD line writes
+ */
+unsigned long simLcdWrites() {
+	return lcdWrites;
+}
+
+/**
+ * Gets the power last set on a motor port
+ *
+ * @param port the motor port (1 - 10)
+ *
+ * @return the power of the motor
+ */
+int simMotor(unsigned char port) {
+	return (port >= 1 && port <= SIM_NUM_MOTORS) ? motors[port - 1] : 0;
+}
+
+/**
+ * Gets the number of motorSet() calls since simInit()
+ *
+ * @return the number of motor writes
+ */
+unsigned long simMotorWrites() {
+	return motorWrites;
+}
+
+/**
+ * Starts recording the power of every motor each time the main thread calls taskDelayUntil(), the end of a control
+ * tick, replacing any earlier trace
+ */
+void simStartMotorTrace() {
+	motorTraceLength = 0;
+	motorTracing = true;
+}
+
+/**
+ * Gets the motor trace recorded since simStartMotorTrace()
+ *
+ * @param length receives the number of traced ticks
+ *
+ * @return the motor powers of each traced tick, SIM_NUM_MOTORS per tick
+ */
+const signed char* simGetMotorTrace(int* length) {
+	*length = motorTraceLength;
+	return &motorTrace[0][0];
+}
+
+/**
+ * Starts capturing the bytes written to SERIAL_LINK_PORT while no pseudo-terminal is connected, replacing any earlier
+ * capture
+ */
+void simStartLinkCapture() {
+	pthread_mutex_lock(&captureLock);
+	linkCaptureLength = 0;
+	linkCapturing = true;
+	pthread_mutex_unlock(&captureLock);
+}
+
+/**
+ * Gets the bytes written to SERIAL_LINK_PORT since simStartLinkCapture() and stops capturing
+ *
+ * @param length receives the number of bytes captured
+ *
+ * @return the captured bytes
+ */
+const uint8_t* simStopLinkCapture(int* length) {
+	pthread_mutex_lock(&captureLock);
+	linkCapturing = false;
+	*length = linkCaptureLength;
+	pthread_mutex_unlock(&captureLock);
+	return linkCapture;
+}
+
+/**
+ * Connects SERIAL_LINK_PORT to a new pseudo-terminal, so that host tools such as tools/autonlink can talk to the
+ * simulated robot as if it were plugged in
+ *
+ * @return the path of the pseudo-terminal for the host tool to open, or NULL if it could not be created
+ */
+const char* simOpenLink() {
+	if (linkMaster >= 0) {
+		return linkPath;
+	}
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 || ptsname_r(master, linkPath, sizeof(linkPath)) != 0) {
+		return NULL;
+	}
+	// Hold the slave side open so the link survives the host tool closing it, and make it pass bytes unchanged
+	int slave = open(linkPath, O_RDWR | O_NOCTTY);
+	struct termios options;
+	if (slave >= 0 && tcgetattr(slave, &options) == 0) {
+		cfmakeraw(&options);
+		tcsetattr(slave, TCSANOW, &options);
+	}
+	linkMaster = master;
+	return linkPath;
+}
+
+/**
+ * Deletes every file in the simulated flash filesystem
+ */
+void simResetFlash() {
+	pthread_mutex_lock(&fileLock);
+	for (int i = 0; i < SIM_MAX_FILES; i++) {
+		free(files[i].data);
+		memset(&files[i], 0, sizeof(simFile));
+	}
+	memset(handles, 0, sizeof(handles));
+	pthread_mutex_unlock(&fileLock);
+}
+
+/**
+ * Finds a file in the simulated flash filesystem; fileLock must be held
+ *
+ * @param name the name of the file
+ *
+ * @return the file, or NULL if it does not exist
+ */
+static simFile* findFile(const char* name) {
+	for (int i = 0; i < SIM_MAX_FILES; i++) {
+		if (files[i].used && strcmp(files[i].name, name) == 0) {
+			return &files[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Gets the size of a file in the simulated flash filesystem
+ *
+ * @param file the name of the file
+ *
+ * @return the size of the file in bytes, or -1 if it does not exist
+ */
+int simFileSize(const char* file) {
+	pthread_mutex_lock(&fileLock);
+	simFile* found = findFile(file);
+	int size = (found == NULL) ? -1 : found->size;
+	pthread_mutex_unlock(&fileLock);
+	return size;
+}
+
+/**
+ * Gets the number of times a file in the simulated flash filesystem has been opened for reading
+ *
+ * @param file the name of the file
+ *
+ * @return the number of times the file was opened for reading, or 0 if it does not exist
+ */
+int simFileReads(const char* file) {
+	pthread_mutex_lock(&fileLock);
+	simFile* found = findFile(file);
+	int reads = (found == NULL) ? 0 : found->reads;
+	pthread_mutex_unlock(&fileLock);
+	return reads;
+}
+
+/**
+ * Gets the open file behind a FILE number; fileLock must be held
+ *
+ * @param stream the FILE number returned by fopen()
+ *
+ * @return the handle, or NULL if the stream is not an open flash file
+ */
+static simHandle* findHandle(FILE* stream) {
+	intptr_t index = (intptr_t) stream - SIM_FIRST_HANDLE;
+	if (index < 0 || index >= SIM_MAX_HANDLES || handles[index].file == NULL) {
+		return NULL;
+	}
+	return &handles[index];
+}
+
+/**
+ * Advances the IMEs by one control tick of the main thread, at a speed that follows the battery voltage, and records the
+ * motor trace
+ *
+ * @param milliseconds the length of the tick
+ */
+static void endTick(unsigned long milliseconds) {
+	for (int i = 0; i < SIM_NUM_IMES; i++) {
+		imePositions[i] += motors[imeMotors[i] - 1] * (long) milliseconds * batteryMillivolts / SIM_BATTERY_NOMINAL;
+	}
+	if (motorTracing && motorTraceLength < SIM_MAX_TRACE) {
+		for (int i = 0; i < SIM_NUM_MOTORS; i++) {
+			motorTrace[motorTraceLength][i] = motors[i];
+		}
+		motorTraceLength++;
+	}
+}
+
+// Competition state
+bool isAutonomous() {
+	return simAutonomous;
+}
+
+bool isEnabled() {
+	return simEnabled;
+}
+
+bool isOnline() {
+	return simOnline;
+}
+
+unsigned int powerLevelMain() {
+	return batteryMillivolts;
+}
+
+unsigned int powerLevelBackup() {
+	return 0;
+}
+
+// Joysticks
+int joystickGetAnalog(unsigned char joystick, unsigned char axis) {
+	if (joystick < 1 || joystick > 2 || axis < 1 || axis > 4) {
+		return 0;
+	}
+	if (joystick == 1 && joyScript != NULL) {
+		const simJoyFrame* frame = currentJoyFrame();
+		return (frame == NULL) ? 0 : frame->analog[axis - 1];
+	}
+	return joyAnalog[joystick - 1][axis - 1];
+}
+
+bool joystickGetDigital(unsigned char joystick, unsigned char buttonGroup, unsigned char button) {
+	if (joystick < 1 || joystick > 2 || buttonGroup < 5 || buttonGroup > 8) {
+		return false;
+	}
+	if (joystick == 1 && joyScript != NULL) {
+		const simJoyFrame* frame = currentJoyFrame();
+		return (frame != NULL) && (frame->digital[buttonGroup - 5] & button) != 0;
+	}
+	return (joyDigital[joystick - 1][buttonGroup - 5] & button) != 0;
+}
+
+// Digital and analog I/O, which nothing on the simulated robot is connected to
+int analogRead(unsigned char channel) {
+	return 0;
+}
+
+bool digitalRead(unsigned char pin) {
+	return HIGH;
+}
+
+void digitalWrite(unsigned char pin, bool value) {
+}
+
+void pinMode(unsigned char pin, unsigned char mode) {
+}
+
+// Motors
+int motorGet(unsigned char channel) {
+	return simMotor(channel);
+}
+
+void motorSet(unsigned char channel, int speed) {
+	if (channel >= 1 && channel <= SIM_NUM_MOTORS) {
+		motors[channel - 1] = CLAMP(speed, -127, 127);
+		__sync_fetch_and_add(&motorWrites, 1);
+	}
+}
+
+void motorStop(unsigned char channel) {
+	motorSet(channel, 0);
+}
+
+void motorStopAll() {
+	for (int i = 0; i < SIM_NUM_MOTORS; i++) {
+		motors[i] = 0;
+	}
+	__sync_fetch_and_add(&motorWrites, 1);
+}
+
+// Integrated motor encoders, turned by the motor that drives each wheel
+unsigned int imeInitializeAll() {
+	return SIM_NUM_IMES;
+}
+
+bool imeGet(unsigned char address, int* value) {
+	if (address >= SIM_NUM_IMES) {
+		return false;
+	}
+	*value = imePositions[address] / SIM_IME_POWER_PER_TICK;
+	return true;
+}
+
+bool imeReset(unsigned char address) {
+	if (address >= SIM_NUM_IMES) {
+		return false;
+	}
+	imePositions[address] = 0;
+	return true;
+}
+
+// Gyro, which always reads zero
+Gyro gyroInit(unsigned char port, unsigned short multiplier) {
+	static int gyro;
+	return &gyro;
+}
+
+int gyroGet(Gyro gyro) {
+	return 0;
+}
+
+void gyroReset(Gyro gyro) {
+}
+
+// Quadrature encoder and ultrasonic sensor, which are not connected and always read zero
+Encoder encoderInit(unsigned char portTop, unsigned char portBottom, bool reverse) {
+	static int encoder;
+	return &encoder;
+}
+
+int encoderGet(Encoder enc) {
+	return 0;
+}
+
+Ultrasonic ultrasonicInit(unsigned char portEcho, unsigned char portPing) {
+	static int ultrasonic;
+	return &ultrasonic;
+}
+
+int ultrasonicGet(Ultrasonic ult) {
+	return 0;
+}
+
+// Serial ports and the flash filesystem
+void fclose(FILE* stream) {
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	if (handle != NULL) {
+		handle->file = NULL;
+	}
+	pthread_mutex_unlock(&fileLock);
+}
+
+int fcount(FILE* stream) {
+	int available = 0;
+	if (stream == SERIAL_LINK_PORT && linkMaster >= 0 && ioctl(linkMaster, FIONREAD, &available) == 0 && available == 0) {
+		// Let real time pass while the robot waits for the host tool, so its warped timeouts are not cut short
+		struct pollfd ready = { .fd = linkMaster, .events = POLLIN };
+		if (poll(&ready, 1, 1) > 0) {
+			ioctl(linkMaster, FIONREAD, &available);
+		}
+	}
+	return available;
+}
+
+int fdelete(const char* file) {
+	pthread_mutex_lock(&fileLock);
+	simFile* found = findFile(file);
+	if (found != NULL) {
+		free(found->data);
+		memset(found, 0, sizeof(simFile));
+	}
+	pthread_mutex_unlock(&fileLock);
+	return (found == NULL) ? -1 : 0;
+}
+
+int feof(FILE* stream) {
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	int end = (handle == NULL) || (handle->position >= handle->file->size);
+	pthread_mutex_unlock(&fileLock);
+	return end;
+}
+
+int fflush(FILE* stream) {
+	return 0;
+}
+
+FILE* fopen(const char* file, const char* mode) {
+	bool write = mode[0] == 'w' || mode[0] == 'a';
+	FILE* stream = NULL;
+	pthread_mutex_lock(&fileLock);
+	simFile* found = findFile(file);
+	if (found == NULL && write && strlen(file) < sizeof(found->name)) {
+		for (int i = 0; i < SIM_MAX_FILES && found == NULL; i++) {
+			if (!files[i].used) {
+				found = &files[i];
+				found->used = true;
+				strcpy(found->name, file);
+			}
+		}
+	}
+	if (found != NULL) {
+		for (int i = 0; i < SIM_MAX_HANDLES; i++) {
+			if (handles[i].file == NULL) {
+				if (mode[0] == 'w') {
+					found->size = 0;
+				} else if (!write) {
+					found->reads++;
+				}
+				handles[i].file = found;
+				handles[i].write = write;
+				handles[i].position = (mode[0] == 'a') ? found->size : 0;
+				stream = (FILE*) (intptr_t) (i + SIM_FIRST_HANDLE);
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&fileLock);
+	return stream;
+}
+
+size_t fread(void* ptr, size_t size, size_t count, FILE* stream) {
+	size_t length = 0;
+	if (stream == SERIAL_LINK_PORT) {
+		ssize_t received = (linkMaster >= 0) ? read(linkMaster, ptr, size * count) : 0;
+		return (received > 0) ? received : 0;
+	}
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	if (handle != NULL && !handle->write) {
+		length = MIN(size * count, (size_t) MAX(handle->file->size - handle->position, 0));
+		memcpy(ptr, handle->file->data + handle->position, length);
+		handle->position += length;
+	}
+	pthread_mutex_unlock(&fileLock);
+	return length;
+}
+
+int fseek(FILE* stream, long int offset, int origin) {
+	int result = -1;
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	if (handle != NULL && !handle->write) {
+		long base = (origin == SEEK_END) ? handle->file->size : (origin == SEEK_CUR) ? handle->position : 0;
+		if (base + offset >= 0 && base + offset <= handle->file->size) {
+			handle->position = base + offset;
+			result = 0;
+		}
+	}
+	pthread_mutex_unlock(&fileLock);
+	return result;
+}
+
+long int ftell(FILE* stream) {
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	long position = (handle == NULL) ? -1 : handle->position;
+	pthread_mutex_unlock(&fileLock);
+	return position;
+}
+
+size_t fwrite(const void* ptr, size_t size, size_t count, FILE* stream) {
+	size_t length = size * count;
+	if (stream == SERIAL_LINK_PORT && linkMaster >= 0) {
+		for (size_t written = 0; written < length;) {
+			ssize_t sent = write(linkMaster, (const char*) ptr + written, length - written);
+			if (sent <= 0) {
+				return written;
+			}
+			written += sent;
+		}
+		return length;
+	}
+	if (stream == SERIAL_LINK_PORT) {
+		pthread_mutex_lock(&captureLock);
+		if (linkCapturing) {
+			int captured = MIN((int) length, SIM_MAX_LINK_CAPTURE - linkCaptureLength);
+			memcpy(linkCapture + linkCaptureLength, ptr, captured);
+			linkCaptureLength += captured;
+		}
+		pthread_mutex_unlock(&captureLock);
+		return length;
+	}
+	if (stream == stdout || stream == uart1 || stream == uart2) {
+		writeSerial(ptr, length);
+		return length;
+	}
+	pthread_mutex_lock(&fileLock);
+	simHandle* handle = findHandle(stream);
+	if (handle == NULL || !handle->write) {
+		length = 0;
+	} else {
+		simFile* file = handle->file;
+		if (handle->position + (int) length > file->capacity) {
+			file->capacity = MAX(file->capacity * 2, handle->position + (int) length);
+			file->data = realloc(file->data, file->capacity);
+		}
+		memcpy(file->data + handle->position, ptr, length);
+		handle->position += length;
+		file->size = MAX(file->size, handle->position);
+	}
+	pthread_mutex_unlock(&fileLock);
+	return length;
+}
+
+int fgetc(FILE* stream) {
+	unsigned char value;
+	if (stream == stdin) {
+		return (read(STDIN_FILENO, &value, 1) == 1) ? value : EOF;
+	}
+	return (fread(&value, 1, 1, stream) == 1) ? value : EOF;
+}
+
+int fputc(int value, FILE* stream) {
+	unsigned char byte = value;
+	return (fwrite(&byte, 1, 1, stream) == 1) ? byte : EOF;
+}
+
+int fputs(const char* string, FILE* stream) {
+	fwrite(string, 1, strlen(string), stream);
+	fputc('\n', stream);
+	return 0;
+}
+
+void fprint(const char* string, FILE* stream) {
+	fwrite(string, 1, strlen(string), stream);
+}
+
+int getchar() {
+	return fgetc(stdin);
+}
+
+int putchar(int value) {
+	return fputc(value, stdout);
+}
+
+void print(const char* string) {
+	fprint(string, stdout);
+}
+
+int puts(const char* string) {
+	return fputs(string, stdout);
+}
+
+int printf(const char* formatString, ...) {
+	char buffer[1024];
+	va_list args;
+	va_start(args, formatString);
+	int length = vsnprintf(buffer, sizeof(buffer), formatString, args);
+	va_end(args);
+	writeSerial(buffer, MIN(length, (int) sizeof(buffer) - 1));
+	return length;
+}
+
+void usartInit(FILE* usart, unsigned int baud, unsigned int flags) {
+}
+
+void usartShutdown(FILE* usart) {
+}
+
+// LCD
+void lcdClear(FILE* lcdPort) {
+	lcdSetText(lcdPort, 1, "");
+	lcdSetText(lcdPort, 2, "");
+}
+
+void lcdInit(FILE* lcdPort) {
+}
+
+void lcdPrint(FILE* lcdPort, unsigned char line, const char* formatString, ...) {
+	char buffer[LCD_MESSAGE_MAX_LENGTH + 1];
+	va_list args;
+	va_start(args, formatString);
+	vsnprintf(buffer, sizeof(buffer), formatString, args);
+	va_end(args);
+	lcdSetText(lcdPort, line, buffer);
+}
+
+unsigned int lcdReadButtons(FILE* lcdPort) {
+	unsigned int buttons = 0;
+	pthread_mutex_lock(&lcdLock);
+	unsigned long now = micros();
+	while (lcdQueueLength > 0) {
+		if (lcdPressStart == 0) {
+			lcdPressStart = MAX(now, 1);
+		}
+		if (now - lcdPressStart < lcdQueue[lcdQueueHead].duration * 1000) {
+			buttons = lcdQueue[lcdQueueHead].buttons;
+			break;
+		}
+		// The next press starts when it is first read, so that every press is seen however rarely the buttons are read
+		lcdPressStart = MAX(now, 1);
+		lcdQueueHead = (lcdQueueHead + 1) % SIM_MAX_LCD_QUEUE;
+		lcdQueueLength--;
+	}
+	pthread_mutex_unlock(&lcdLock);
+	return buttons;
+}
+
+void lcdSetBacklight(FILE* lcdPort, bool backlight) {
+}
+
+void lcdSetText(FILE* lcdPort, unsigned char line, const char* buffer) {
+	if (line < 1 || line > 2) {
+		return;
+	}
+	char* text = lcdLines[line - 1];
+	size_t length = MIN(strlen(buffer), (size_t) LCD_MESSAGE_MAX_LENGTH);
+	memset(text, ' ', LCD_MESSAGE_MAX_LENGTH);
+	memcpy(text, buffer, length);
+	__sync_fetch_and_add(&lcdWrites, 1);
+}
+
+void lcdShutdown(FILE* lcdPort) {
+}
+
+// Tasks and timing
+/**
+ * Runs a task created with taskCreate() on its own thread
+ *
+ * @param task the task to run
+ *
+ * @return NULL
+ */
+static void* runTask(void* task) {
+	simTask* started = task;
+	currentTask = started;
+	started->code(started->parameters);
+	return NULL;
+}
+
+TaskHandle taskCreate(TaskCode taskCode, const unsigned int stackDepth, void* parameters,
+		const unsigned int priority) {
+	simTask* task = malloc(sizeof(simTask));
+	task->code = taskCode;
+	task->parameters = parameters;
+	task->priority = priority;
+	task->sleeping = false;
+	task->periodic = false;
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, runTask, task) != 0) {
+		free(task);
+		return NULL;
+	}
+	pthread_detach(thread);
+	return task;
+}
+
+/**
+ * Lets the periodic tasks above the default priority catch up after the main thread has skipped time, waiting until
+ * each one that is due has run and is waiting again
+ */
+static void runPeriodicTasks() {
+	unsigned long release = __sync_add_and_fetch(&periodicRelease, 1);
+	int count = MIN(numPeriodicTasks, SIM_MAX_PERIODIC_TASKS);
+	for (int i = 0; i < count; i++) {
+		simTask* task;
+		while ((task = periodicTasks[i]) == NULL || !task->sleeping
+				|| (task->release != release && (long) (millis() - task->wakeTime) >= 0)) {
+			sched_yield();
+		}
+	}
+	sched_yield();
+}
+
+void taskDelete(TaskHandle taskToDelete) {
+	// Tasks only ever delete themselves
+	if (taskToDelete == NULL) {
+		pthread_exit(NULL);
+	}
+}
+
+void delay(const unsigned long time) {
+	if (onMainThread()) {
+		__sync_fetch_and_add(&skippedMicros, time * 1000);
+		runPeriodicTasks();
+		return;
+	}
+	unsigned long wake = micros() + time * 1000;
+	while ((long) (micros() - wake) < 0) {
+		pollSleep();
+	}
+}
+
+void delayMicroseconds(const unsigned long us) {
+	if (onMainThread()) {
+		__sync_fetch_and_add(&skippedMicros, us);
+		return;
+	}
+	unsigned long wake = micros() + us;
+	while ((long) (micros() - wake) < 0) {
+		sched_yield();
+	}
+}
+
+void taskDelay(const unsigned long msToDelay) {
+	delay(msToDelay);
+}
+
+void taskDelayUntil(unsigned long* previousWakeTime, const unsigned long cycleTime) {
+	*previousWakeTime += cycleTime;
+	if (onMainThread()) {
+		endTick(cycleTime);
+		long remaining = (long) (*previousWakeTime * 1000 - micros());
+		if (remaining > 0) {
+			__sync_fetch_and_add(&skippedMicros, remaining);
+		}
+		runPeriodicTasks();
+		return;
+	}
+	simTask* task = currentTask;
+	if (task == NULL || task->priority <= TASK_PRIORITY_DEFAULT) {
+		while ((long) (millis() - *previousWakeTime) < 0) {
+			pollSleep();
+		}
+		return;
+	}
+	if (!task->periodic) {
+		task->periodic = true;
+		int index = __sync_fetch_and_add(&numPeriodicTasks, 1);
+		if (index < SIM_MAX_PERIODIC_TASKS) {
+			periodicTasks[index] = task;
+		}
+	}
+	// Yield instead of sleeping, since the main thread waits for this task after every tick
+	unsigned long release = periodicRelease;
+	task->wakeTime = *previousWakeTime;
+	task->release = release;
+	__sync_synchronize();
+	task->sleeping = true;
+	while (periodicRelease == release || (long) (millis() - *previousWakeTime) < 0) {
+		sched_yield();
+	}
+	task->sleeping = false;
+}
+
+unsigned long micros() {
+	return simRealMicros() + skippedMicros;
+}
+
+unsigned long millis() {
+	return micros() / 1000;
+}
+
+// Semaphores and mutexes, which share an implementation since the robot code never relies on priority inheritance
+/**
+ * Creates a semaphore that can be taken straight away
+ *
+ * @return the new semaphore
+ */
+static simSemaphore* createSemaphore() {
+	simSemaphore* semaphore = malloc(sizeof(simSemaphore));
+	pthread_mutex_init(&semaphore->lock, NULL);
+	pthread_cond_init(&semaphore->cond, NULL);
+	semaphore->given = true;
+	return semaphore;
+}
+
+/**
+ * Gives a semaphore
+ *
+ * @param semaphore the semaphore to give
+ *
+ * @return true if the semaphore had been taken
+ */
+static bool giveSemaphore(simSemaphore* semaphore) {
+	pthread_mutex_lock(&semaphore->lock);
+	bool wasTaken = !semaphore->given;
+	semaphore->given = true;
+	pthread_cond_signal(&semaphore->cond);
+	pthread_mutex_unlock(&semaphore->lock);
+	return wasTaken;
+}
+
+/**
+ * Takes a semaphore, waiting up to blockTime milliseconds of warped time for it to be given
+ *
+ * @param semaphore the semaphore to take
+ * @param blockTime the longest time to wait, or SIM_WAIT_FOREVER or more to wait forever
+ *
+ * @return true if the semaphore was taken
+ */
+static bool takeSemaphore(simSemaphore* semaphore, unsigned long blockTime) {
+	unsigned long deadline = millis() + blockTime;
+	pthread_mutex_lock(&semaphore->lock);
+	while (!semaphore->given) {
+		if (blockTime >= SIM_WAIT_FOREVER) {
+			pthread_cond_wait(&semaphore->cond, &semaphore->lock);
+		} else if ((long) (millis() - deadline) >= 0) {
+			break;
+		} else {
+			// Time also passes while other threads hold the warped clock still, so check the deadline every poll
+			struct timespec wake;
+			clock_gettime(CLOCK_REALTIME, &wake);
+			wake.tv_nsec += SIM_POLL_MICROS * 1000L;
+			if (wake.tv_nsec >= 1000000000L) {
+				wake.tv_sec++;
+				wake.tv_nsec -= 1000000000L;
+			}
+			pthread_cond_timedwait(&semaphore->cond, &semaphore->lock, &wake);
+		}
+	}
+	bool taken = semaphore->given;
+	semaphore->given = false;
+	pthread_mutex_unlock(&semaphore->lock);
+	return taken;
+}
+
+Semaphore semaphoreCreate() {
+	return createSemaphore();
+}
+
+bool semaphoreGive(Semaphore semaphore) {
+	return giveSemaphore(semaphore);
+}
+
+bool semaphoreTake(Semaphore semaphore, const unsigned long blockTime) {
+	return takeSemaphore(semaphore, blockTime);
+}
+
+void semaphoreDelete(Semaphore semaphore) {
+}
+
+Mutex mutexCreate() {
+	return createSemaphore();
+}
+
+bool mutexGive(Mutex mutex) {
+	return giveSemaphore(mutex);
+}
+
+bool mutexTake(Mutex mutex, const unsigned long blockTime) {
+	return takeSemaphore(mutex, blockTime);
+}
+
+void mutexDelete(Mutex mutex) {
+}
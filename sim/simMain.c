@@ -0,0 +1,862 @@
+/** @file simMain.c
+ * @brief File for the host-side benchmarks and session replay
+ *
+ * Boots the robot code with initialize() against the simulated API and then runs one of two modes:
+ *
+ * bench: times the joystick/motor path, the LCD menu, saving, loading and playing back an autonomous routine, and
+ * recording, playing back and seeking into a full programming skills run, using the real host time of each stage. The
+ * exit code is non-zero if a skills playback misses ticks or the deadline shedding or command arbitration goes wrong.
+ *
+ * replay <capture>: reads the joystick states from a serial capture of a recording (the "Record State" or
+ * "Playback State" lines, such as out.txt), feeds them through the joysticks into recordAndSaveAuton(), reloads
+ * the routine, plays it back, and checks that the recorded states, the reloaded states and the motor outputs of the
+ * playback all match, that the telemetry frames streamed during the playback decode to the same motor outputs, and
+ * that reloading it mirrored at half speed transforms it as expected, that a routine saved in the original
+ * headerless format loads with its fields in the right order, and that an event recording without events is
+ * rejected. The exit code is non-zero if anything differs, so the replay can be used as a regression test.
+ *
+ * link: connects the serial link to a pseudo-terminal, uploads a saved routine through it with "autonlink get" and
+ * downloads it back into the next slot with "autonlink put", then checks that the downloaded routine matches.
+ */
+
+#include "main.h"
+#include "sim.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Provided by the host C library but declared in <stdio.h>, which conflicts with API.h
+ */
+int vsnprintf(char* buffer, size_t limit, const char* formatString, va_list args);
+
+/**
+ * Number of iterations of the joystick/motor and LCD menu benchmarks
+ */
+#define BENCH_LOOP_ITERATIONS 100000
+
+/**
+ * Number of iterations of the save and load benchmarks
+ */
+#define BENCH_FILE_ITERATIONS 50
+
+/**
+ * Slot used by the benchmarks and the replay
+ */
+#define SIM_SLOT 1
+
+/**
+ * Battery voltage in millivolts of the replay's low battery playback
+ */
+#define SIM_BATTERY_FLAT 6800
+
+/**
+ * Playback speed in percent of the replay's accelerated playback
+ */
+#define SIM_FAST_SPEED 150
+
+/**
+ * Real time in microseconds that the replay gives the telemetry task to write out the frames still queued
+ */
+#define SIM_TELEMETRY_DRAIN 50000
+
+/**
+ * How long each simulated LCD button press and release lasts in milliseconds
+ */
+#define SIM_PRESS_TIME 60
+
+/**
+ * Prints a line of results to the host's standard output, whether or not serial echo is on
+ *
+ * @param formatString the printf() format string of the line
+ */
+static void report(const char* formatString, ...) {
+	char buffer[256];
+	va_list args;
+	va_start(args, formatString);
+	int length = vsnprintf(buffer, sizeof(buffer), formatString, args);
+	va_end(args);
+	ssize_t ignored = write(STDOUT_FILENO, buffer, MIN(length, (int) sizeof(buffer) - 1));
+	(void) ignored;
+}
+
+/**
+ * Queues the LCD presses that choose a slot in selectAuton()
+ *
+ * @param slot the slot to choose, where MAX_AUTON_SLOTS + 1 is programming skills and 0 is none
+ */
+static void queueSlotSelection(int slot) {
+	if (slot == MAX_AUTON_SLOTS + 1) {
+		// Left from None wraps around to programming skills
+		simQueueLcdButtons(LCD_BTN_LEFT, SIM_PRESS_TIME);
+		simQueueLcdButtons(0, SIM_PRESS_TIME);
+	} else {
+		for (int i = 0; i < slot; i++) {
+			simQueueLcdButtons(LCD_BTN_RIGHT, SIM_PRESS_TIME);
+			simQueueLcdButtons(0, SIM_PRESS_TIME);
+		}
+	}
+	simQueueLcdButtons(LCD_BTN_CENTER, SIM_PRESS_TIME);
+	simQueueLcdButtons(0, SIM_PRESS_TIME);
+}
+
+/**
+ * Finds the raw stick position that a response curve maps closest to a shaped value
+ *
+ * @param curve the response curve
+ * @param value the shaped value
+ * @param exact receives false if no stick position produces the value exactly
+ *
+ * @return the stick position from -127 to 127
+ */
+static int invertCurve(const signed char* curve, int value, bool* exact) {
+	int best = 0;
+	for (int x = -127; x <= 127; x++) {
+		int error = abs(curve[x + 128] - value);
+		int bestError = abs(curve[best + 128] - value);
+		if (error < bestError || (error == bestError && abs(x) < abs(best))) {
+			best = x;
+		}
+	}
+	*exact = curve[best + 128] == value;
+	return best;
+}
+
+/**
+ * Converts a captured state into the joystick frame that recordJoyInfo() reads back as that state
+ *
+ * @param state the captured state
+ * @param frame receives the joystick frame
+ * @param expected receives the state recordJoyInfo() will produce, which differs from state if it cannot be reproduced
+ *
+ * @return true if the state can be reproduced exactly
+ */
+static bool stateToFrame(const joyState* state, simJoyFrame* frame, joyState* expected) {
+	const stickProfile* profile = stickGetProfile();
+	bool exact[3];
+	memset(frame, 0, sizeof(simJoyFrame));
+	frame->analog[2] = invertCurve(profile->forward, state->spd, &exact[0]);
+	frame->analog[3] = invertCurve(profile->horizontal, state->horizontal, &exact[1]);
+	frame->analog[0] = invertCurve(profile->turn, state->turn, &exact[2]);
+
+	*expected = *state;
+	expected->spd = profile->forward[frame->analog[2] + 128];
+	expected->horizontal = profile->horizontal[frame->analog[3] + 128];
+	expected->turn = profile->turn[frame->analog[0] + 128];
+
+	// recordJoyInfo() maps these buttons to the pincer and lift speeds
+	if (state->sht == 127) {
+		frame->digital[0] = JOY_UP;
+	} else if (state->sht == -127) {
+		frame->digital[0] = JOY_DOWN;
+	} else if (state->sht == -40) {
+		frame->digital[3] = JOY_DOWN;
+	} else if (state->sht == 40) {
+		frame->digital[3] = JOY_UP;
+	} else {
+		expected->sht = 0;
+	}
+	if (state->lift == -1) {
+		frame->digital[1] = JOY_UP;
+	} else if (state->lift == 1) {
+		frame->digital[1] = JOY_DOWN;
+	} else {
+		expected->lift = 0;
+	}
+	return exact[0] && exact[1] && exact[2] && expected->sht == state->sht && expected->lift == state->lift;
+}
+
+/**
+ * Fills the states array with a synthetic routine of held sticks and buttons, like a driver would record
+ *
+ * @param seed varies the routine so that consecutive programming skills chunks differ
+ */
+static void fillSyntheticStates(int seed) {
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		int segment = (i + seed * 17) / 40;
+		states[i].spd = ((segment % 3) - 1) * 127;
+		states[i].horizontal = (segment % 5 == 0) ? 64 : 0;
+		states[i].turn = (segment % 7 == 3) ? -90 : 0;
+		states[i].sht = (segment % 4 == 1) ? 40 : 0;
+		states[i].lift = (segment % 6) - 1 == 0 ? 1 : 0;
+	}
+	autonEventMode = false;
+#ifdef AUTON_SENSORS
+	sensorTraceLoaded = false;
+#endif
+}
+
+/**
+ * Benchmarks reading the joysticks and committing the motors, the body of the operator control loop
+ */
+static void benchControlLoop() {
+	unsigned long writes = simMotorWrites();
+	unsigned long start = simRealMicros();
+	for (int i = 0; i < BENCH_LOOP_ITERATIONS; i++) {
+		simSetJoystickAnalog(1, 3, (i / 10) % 255 - 127);
+		simSetJoystickAnalog(1, 4, (i / 25) % 255 - 127);
+		simSetJoystickAnalog(1, 1, (i / 50) % 255 - 127);
+		simSetJoystickDigital(1, 6, ((i / 100) % 3 == 0) ? JOY_UP : 0);
+		driverInputPoll();
+		recordJoyInfo();
+		moveRobot(MOTOR_OUTPUT_TICK);
+	}
+	unsigned long elapsed = simRealMicros() - start;
+	motorOutputStopAll();
+	report("control loop: %d ticks, %lu ns/tick, %lu motor writes/1000 ticks\n", BENCH_LOOP_ITERATIONS,
+			elapsed * 1000 / BENCH_LOOP_ITERATIONS, (simMotorWrites() - writes) * 1000 / BENCH_LOOP_ITERATIONS);
+}
+
+/**
+ * Benchmarks redrawing an unchanged LCD menu, the body of the LCD task
+ */
+static void benchLcdMenu() {
+	unsigned long writes = simLcdWrites();
+	unsigned long start = simRealMicros();
+	for (int i = 0; i < BENCH_LOOP_ITERATIONS; i++) {
+		updateLCDMenu(LCD_MENU_PERIOD);
+	}
+	unsigned long elapsed = simRealMicros() - start;
+	report("LCD menu: %d redraws, %lu ns/redraw, %lu LCD writes\n", BENCH_LOOP_ITERATIONS,
+			elapsed * 1000 / BENCH_LOOP_ITERATIONS, simLcdWrites() - writes);
+}
+
+/**
+ * Benchmarks saving, loading and playing back a single autonomous routine
+ */
+static void benchAuton() {
+	unsigned long total = 0;
+	for (int i = 0; i < BENCH_FILE_ITERATIONS; i++) {
+		fillSyntheticStates(0);
+		queueSlotSelection(SIM_SLOT);
+		unsigned long start = simRealMicros();
+		saveAuton();
+		total += simRealMicros() - start;
+	}
+	char filename[AUTON_FILENAME_MAX_LENGTH];
+	snprintf(filename, sizeof(filename), "a%d", SIM_SLOT);
+	report("save: %lu us/save including slot selection, %d bytes for %d states\n", total / BENCH_FILE_ITERATIONS,
+			simFileSize(filename), AUTON_NUM_STATES);
+
+	total = 0;
+	for (int i = 0; i < BENCH_FILE_ITERATIONS; i++) {
+		// loadAuton() skips the slot that is already loaded
+		autonLoaded = 0;
+		unsigned long start = simRealMicros();
+		loadAuton(SIM_SLOT);
+		total += simRealMicros() - start;
+	}
+	report("load: %lu us/load\n", total / BENCH_FILE_ITERATIONS);
+
+	unsigned long writes = simMotorWrites();
+	unsigned long start = simRealMicros();
+	playbackAuton();
+	unsigned long elapsed = simRealMicros() - start;
+	report("playback: %d ticks in %lu us, %lu motor writes\n", AUTON_NUM_STATES, elapsed,
+			simMotorWrites() - writes);
+}
+
+/**
+ * Benchmarks recording and playing back a programming skills run, which is captured in one go and loads each chunk in
+ * the background, then seeks into the run
+ *
+ * @return true if both playbacks ran every tick
+ */
+static bool benchProgSkills() {
+	const int numStates = PROGSKILL_TIME * JOY_POLL_FREQ;
+	static simJoyFrame frames[PROGSKILL_TIME * JOY_POLL_FREQ];
+	for (int i = 0; i < numStates; i += AUTON_NUM_STATES) {
+		joyState expected;
+		fillSyntheticStates(i / AUTON_NUM_STATES);
+		for (int j = 0; j < AUTON_NUM_STATES && i + j < numStates; j++) {
+			stateToFrame(&states[j], &frames[i + j], &expected);
+		}
+	}
+	simPlayJoystick(frames, numStates, 1000 / JOY_POLL_FREQ);
+	queueSlotSelection(MAX_AUTON_SLOTS + 1);
+	unsigned long start = simRealMicros();
+	recordAndSaveAuton();
+	unsigned long elapsed = simRealMicros() - start;
+	char filename[AUTON_FILENAME_MAX_LENGTH];
+	snprintf(filename, sizeof(filename), "sk");
+	report("skills record: %lu us, %d bytes for %d states\n", elapsed, simFileSize(filename), numStates);
+
+	loadAuton(MAX_AUTON_SLOTS + 1);
+	simStartMotorTrace();
+	start = simRealMicros();
+	playbackAuton();
+	elapsed = simRealMicros() - start;
+	int ticks;
+	simGetMotorTrace(&ticks);
+	report("skills playback: %d of %d ticks in %lu us\n", ticks, numStates, elapsed);
+	bool passed = ticks == numStates;
+
+	// Start in the last chunk, which the chunk index finds without reading the others
+	autonPlaybackStart = (PROGSKILL_TIME - AUTON_TIME) * 1000;
+	simStartMotorTrace();
+	start = simRealMicros();
+	playbackAuton();
+	elapsed = simRealMicros() - start;
+	autonPlaybackStart = 0;
+	simGetMotorTrace(&ticks);
+	report("skills seek: %d of %d ticks in %lu us\n", ticks, AUTON_TIME * JOY_POLL_FREQ, elapsed);
+	return passed && ticks == AUTON_TIME * JOY_POLL_FREQ;
+}
+
+/**
+ * Runs a watched loop whose ticks first take most of their budget, then stall once, then go back to taking very
+ * little, and reports how far the work was shed and whether all of it came back
+ *
+ * @return true if everything was shed and then restored
+ */
+static bool benchDeadline() {
+	const int period = 20;
+	deadlineMonitor monitor;
+	deadlineStart(&monitor, "Bench", period, false);
+	int heavyTicks = DEADLINE_SHED_TICKS * (DEADLINE_NUM_LEVELS - 1);
+	for (int i = 0; i < heavyTicks; i++) {
+		delayMicroseconds(period * 10 * DEADLINE_NEAR_PERCENT + 1000);
+		deadlineWait(&monitor);
+	}
+	bool shedAll = deadlineShedding(DEADLINE_SHED_TELEMETRY);
+	// One stall of two and a half periods, whose missed ticks are skipped
+	delayMicroseconds(period * 2500);
+	deadlineWait(&monitor);
+	for (int i = 0; i < DEADLINE_RESTORE_TICKS * (DEADLINE_NUM_LEVELS - 1); i++) {
+		deadlineWait(&monitor);
+	}
+	bool restored = !deadlineShedding(DEADLINE_SHED_LCD);
+	report("deadline: shed everything after %d heavy ticks: %s, %u overruns, %u ticks skipped, restored: %s\n",
+			heavyTicks, shedAll ? "yes" : "no", monitor.timer.overruns, monitor.timer.skipped, restored ? "yes" : "no");
+	return shedAll && restored;
+}
+
+/**
+ * Benchmarks exchanging commands between the driver, playback and moveRobot(), and checks the arbitration policies
+ *
+ * @return true if every policy combined the commands as expected
+ */
+static bool benchCommand() {
+	const joyState driver = { .spd = 40, .turn = 0, .horizontal = -20, .sht = 0, .lift = 0 };
+	const joyState playback = { .spd = 100, .turn = 30, .horizontal = -120, .sht = 40, .lift = 1 };
+	joyState command;
+	unsigned long start = simRealMicros();
+	for (int i = 0; i < BENCH_LOOP_ITERATIONS; i++) {
+		commandPublish(COMMAND_SOURCE_DRIVER, &driver);
+		commandPublish(COMMAND_SOURCE_PLAYBACK, &playback);
+		commandArbitrate(&command);
+	}
+	unsigned long elapsed = simRealMicros() - start;
+
+	bool playbackFirst = memcmp(&command, &playback, sizeof(joyState)) == 0;
+	commandSetPolicy(COMMAND_POLICY_OVERRIDE);
+	commandArbitrate(&command);
+	bool override = memcmp(&command, &driver, sizeof(joyState)) == 0;
+	commandSetPolicy(COMMAND_POLICY_BLEND);
+	commandArbitrate(&command);
+	bool blend = command.spd == 127 && command.horizontal == -127 && command.turn == 30 && command.sht == 40
+			&& command.lift == 1;
+	commandSetPolicy(COMMAND_POLICY_PLAYBACK);
+	commandWithdraw(COMMAND_SOURCE_PLAYBACK);
+	commandArbitrate(&command);
+	bool withdrawn = memcmp(&command, &driver, sizeof(joyState)) == 0;
+	// Neither source publishes again, so both go stale and the robot is stopped
+	delay(COMMAND_STALE_TIME + 1);
+	commandArbitrate(&command);
+	const joyState stopped = {0, 0, 0, 0, 0};
+	bool stale = memcmp(&command, &stopped, sizeof(joyState)) == 0;
+	report("command: %lu ns/exchange, playback %s, override %s, blend %s, withdrawn %s, stale %s\n",
+			elapsed * 1000 / BENCH_LOOP_ITERATIONS, playbackFirst ? "ok" : "wrong", override ? "ok" : "wrong",
+			blend ? "ok" : "wrong", withdrawn ? "ok" : "wrong", stale ? "ok" : "wrong");
+	return playbackFirst && override && blend && withdrawn && stale;
+}
+
+/**
+ * Runs every benchmark and prints the stage profile
+ *
+ * @return the process exit code, which is non-zero if a benchmark that checks its results found them wrong
+ */
+static int runBenchmarks() {
+	benchControlLoop();
+	benchLcdMenu();
+	benchAuton();
+	bool passed = benchProgSkills();
+	passed = benchDeadline() && passed;
+	passed = benchCommand() && passed;
+
+	// Keep leftover log messages from interleaving with the profile
+	logSetPaused(true);
+	simSetSerialEcho(true);
+	profileReport();
+	deadlineReportEvents();
+	report("bench: %s\n", passed ? "PASS" : "FAIL");
+	return passed ? 0 : 1;
+}
+
+/**
+ * Reads a whole host file
+ *
+ * @param path the path of the file
+ * @param length receives the length of the file
+ *
+ * @return the null-terminated contents of the file, or NULL if it could not be read
+ */
+static char* readHostFile(const char* path, int* length) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	int capacity = 4096;
+	char* text = malloc(capacity);
+	*length = 0;
+	ssize_t count;
+	while ((count = read(fd, text + *length, capacity - *length - 1)) > 0) {
+		*length += count;
+		if (*length == capacity - 1) {
+			capacity *= 2;
+			text = realloc(text, capacity);
+		}
+	}
+	close(fd);
+	text[*length] = 0;
+	return text;
+}
+
+/**
+ * Parses the joystick states out of a serial capture of a recording or playback
+ *
+ * @param text the capture
+ * @param captured receives up to AUTON_NUM_STATES states, indexed by the state number in the capture
+ * @param marker the text that starts a state line, such as "Record State "
+ *
+ * @return one more than the highest state number found, or 0 if there were none
+ */
+static int parseCapture(const char* text, joyState* captured, const char* marker) {
+	int numStates = 0;
+	for (const char* line = strstr(text, marker); line != NULL; line = strstr(line + 1, marker)) {
+		char* end;
+		long index = strtol(line + strlen(marker), &end, 10);
+		const char* speed = strstr(end, "Speed:");
+		const char* lineEnd = strchr(end, '\n');
+		if (speed == NULL || (lineEnd != NULL && speed > lineEnd) || index < 0 || index >= AUTON_NUM_STATES) {
+			continue;
+		}
+		signed char values[5];
+		end = (char*) speed + strlen("Speed:");
+		for (int i = 0; i < 5; i++) {
+			// CLAMP() evaluates its argument more than once, so parse before clamping
+			long value = strtol(end, &end, 10);
+			values[i] = CLAMP(value, -127, 127);
+		}
+		captured[index].spd = values[0];
+		captured[index].horizontal = values[1];
+		captured[index].turn = values[2];
+		captured[index].sht = values[3];
+		captured[index].lift = values[4];
+		numStates = MAX(numStates, (int) index + 1);
+	}
+	return numStates;
+}
+
+/**
+ * Counts the states that differ between two arrays
+ *
+ * @param a the first states
+ * @param b the second states
+ * @param numStates the number of states to compare
+ *
+ * @return the number of states that differ
+ */
+static int countStateMismatches(const joyState* a, const joyState* b, int numStates) {
+	int mismatches = 0;
+	for (int i = 0; i < numStates; i++) {
+		if (memcmp(&a[i], &b[i], sizeof(joyState)) != 0) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * Decodes the telemetry frames captured from the link port and compares the motor outputs in each frame with the
+ * motor trace of the same tick, using the gaps in the sequence numbers to place frames after dropped ones
+ *
+ * @param capture the bytes captured from the link port
+ * @param length the number of bytes captured
+ * @param trace the motor trace, SIM_NUM_MOTORS per tick
+ * @param numTicks the number of traced ticks
+ * @param numFrames receives the number of telemetry frames decoded
+ *
+ * @return the number of frames that were corrupt, out of place or differ from the trace
+ */
+static int countTelemetryMismatches(const uint8_t* capture, int length, const signed char* trace, int numTicks,
+		int* numFrames) {
+	linkDecoder decoder;
+	linkDecoderReset(&decoder);
+	int mismatches = 0;
+	int tick = -1;
+	uint8_t lastSeq = 0;
+	*numFrames = 0;
+	for (int i = 0; i < length; i++) {
+		int result = linkDecode(&decoder, capture[i]);
+		if (result == LINK_DECODE_CORRUPT) {
+			mismatches++;
+		}
+		if (result != LINK_DECODE_FRAME) {
+			continue;
+		}
+		const linkFrame* frame = &decoder.frame;
+		if (frame->type != LINK_FRAME_TELEMETRY || frame->length != TELEMETRY_PAYLOAD) {
+			mismatches++;
+			continue;
+		}
+		tick = (tick < 0) ? 0 : tick + (uint8_t) (frame->seq - lastSeq);
+		lastSeq = frame->seq;
+		(*numFrames)++;
+		if (tick >= numTicks || memcmp(frame->payload + TELEMETRY_MOTORS, trace + tick * SIM_NUM_MOTORS,
+				TELEMETRY_NUM_MOTORS) != 0) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+/**
+ * Plays the routine in the states array back at the recorded speed and at SIM_FAST_SPEED, open loop, and compares
+ * where the drive ends up
+ *
+ * @param pathLength filled in with the distance of the end of the recorded speed playback from the start
+ * @param pathError filled in with the distance between the ends of the two playbacks
+ *
+ * @return the number of ticks of the faster playback
+ */
+static int measureFastPlayback(int* pathLength, int* pathError) {
+	drivePose recordedPose, fastPose;
+	resetDriveSensors();
+	playbackAuton();
+	readDriveSensors(&recordedPose);
+	resetDriveSensors();
+	autonPlaybackSpeed = SIM_FAST_SPEED;
+	simStartMotorTrace();
+	playbackAuton();
+	autonPlaybackSpeed = 100;
+	readDriveSensors(&fastPose);
+	int fastTicks;
+	simGetMotorTrace(&fastTicks);
+	*pathLength = abs(recordedPose.forward) + abs(recordedPose.horizontal) + abs(recordedPose.turn);
+	*pathError = abs(fastPose.forward - recordedPose.forward) + abs(fastPose.horizontal - recordedPose.horizontal)
+			+ abs(fastPose.turn - recordedPose.turn);
+	return fastTicks;
+}
+
+/**
+ * Replays a captured session through recording, saving, loading and playback
+ *
+ * @param path the path of the capture on the host
+ *
+ * @return the process exit code
+ */
+static int runReplay(const char* path) {
+	int length;
+	char* text = readHostFile(path, &length);
+	if (text == NULL) {
+		report("replay: cannot read %s\n", path);
+		return 2;
+	}
+	static joyState captured[AUTON_NUM_STATES], expected[AUTON_NUM_STATES];
+	static simJoyFrame frames[AUTON_NUM_STATES];
+	int numCaptured = parseCapture(text, captured, "Record State ");
+	if (numCaptured == 0) {
+		numCaptured = parseCapture(text, captured, "Playback State: ");
+	}
+	free(text);
+	if (numCaptured == 0) {
+		report("replay: no states found in %s\n", path);
+		return 2;
+	}
+
+	int unreproducible = 0;
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		if (!stateToFrame(&captured[i], &frames[i], &expected[i])) {
+			unreproducible++;
+		}
+	}
+	report("replay: %d states captured, %d cannot be reproduced with the active stick profile\n", numCaptured,
+			unreproducible);
+
+	static signed char recordTrace[SIM_MAX_TRACE][SIM_NUM_MOTORS];
+	simPlayJoystick(frames, AUTON_NUM_STATES, 1000 / JOY_POLL_FREQ);
+	// Choose the slot before recording, so the routine is streamed to flash while it is recorded
+	queueSlotSelection(SIM_SLOT);
+	simStartMotorTrace();
+	unsigned long start = simRealMicros();
+	recordAndSaveAuton();
+	unsigned long recordTime = simRealMicros() - start;
+	int recordTicks;
+	memcpy(recordTrace, simGetMotorTrace(&recordTicks), sizeof(recordTrace));
+	int recordMismatches = countStateMismatches(states, expected, AUTON_NUM_STATES);
+
+	// Forget the routine that recordAndSaveAuton() left in memory so that loadAuton() reads it back from flash
+	memset(states, 0, sizeof(states));
+	autonLoaded = 0;
+	start = simRealMicros();
+	loadAuton(SIM_SLOT);
+	unsigned long loadTime = simRealMicros() - start;
+	int loadMismatches = countStateMismatches(states, expected, AUTON_NUM_STATES);
+
+	// Boot again the way initialize() does, which should preload the routine that was just loaded
+	memset(states, 0, sizeof(states));
+	autonLoaded = 0;
+	int bootSlot = getBootAutonSlot();
+	start = simRealMicros();
+	startAutonPreload(bootSlot);
+	waitAutonPreload();
+	unsigned long bootTime = simRealMicros() - start;
+	int bootMismatches = countStateMismatches(states, expected, AUTON_NUM_STATES);
+
+	simStartMotorTrace();
+	simStartLinkCapture();
+	unsigned long dropped = telemetryDropped();
+	start = simRealMicros();
+	playbackAuton();
+	unsigned long playbackTime = simRealMicros() - start;
+	int playbackTicks;
+	const signed char* playbackTrace = simGetMotorTrace(&playbackTicks);
+	usleep(SIM_TELEMETRY_DRAIN);
+	int captureLength, telemetryFrames;
+	const uint8_t* capture = simStopLinkCapture(&captureLength);
+	int telemetryMismatches = countTelemetryMismatches(capture, captureLength, playbackTrace, playbackTicks,
+			&telemetryFrames);
+	dropped = telemetryDropped() - dropped;
+	int motorMismatches = abs(playbackTicks - recordTicks);
+	for (int i = 0; i < MIN(playbackTicks, recordTicks); i++) {
+		if (memcmp(recordTrace[i], playbackTrace + i * SIM_NUM_MOTORS, SIM_NUM_MOTORS) != 0) {
+			motorMismatches++;
+		}
+	}
+
+	// Play a routine that moves back on a flatter battery than it was recorded on, which should raise the motor power;
+	// the capture may hold the robot still, which leaves nothing to compensate, so the routine is synthetic and driven
+	// at half stick to leave the compensation room below full power
+	static signed char nominalTrace[SIM_MAX_TRACE][SIM_NUM_MOTORS];
+	fillSyntheticStates(1);
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		states[i].spd /= 2;
+		states[i].horizontal /= 2;
+		states[i].turn /= 2;
+	}
+	simStartMotorTrace();
+	playbackAuton();
+	int nominalTicks;
+	memcpy(nominalTrace, simGetMotorTrace(&nominalTicks), sizeof(nominalTrace));
+	simSetBattery(SIM_BATTERY_FLAT);
+	simStartMotorTrace();
+	playbackAuton();
+	simSetBattery(SIM_BATTERY_NOMINAL);
+	int flatTicks;
+	const signed char* flatTrace = simGetMotorTrace(&flatTicks);
+	long nominalPower = 0, flatPower = 0;
+	for (int i = 0; i < MIN(flatTicks, nominalTicks); i++) {
+		for (int port = 0; port < SIM_NUM_MOTORS; port++) {
+			nominalPower += abs(nominalTrace[i][port]);
+			flatPower += abs(flatTrace[i * SIM_NUM_MOTORS + port]);
+		}
+	}
+	int flatGain = (nominalPower == 0) ? 0 : (int) (flatPower * 100 / nominalPower);
+
+	// Play the routine back faster than recorded, which should drive the same path in less time; it is turned down to
+	// quarter stick so that the faster commands still fit below full power, and only drives forwards so that the end
+	// of the path is far from where it started
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		states[i].spd = abs(states[i].spd) / 2;
+		states[i].horizontal /= 2;
+		states[i].turn /= 2;
+	}
+	int pathLength, pathError;
+	int fastTicks = measureFastPlayback(&pathLength, &pathError);
+	int expectedFastTicks = AUTON_NUM_STATES * 100 * AUTON_FAST_PLAYBACK_FREQ / (SIM_FAST_SPEED * JOY_POLL_FREQ);
+
+	// At full stick the faster commands would need more than full power, so the playback should slow down to keep to
+	// the recorded path
+	fillSyntheticStates(1);
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		states[i].spd = abs(states[i].spd);
+	}
+	int fullPathLength, fullPathError;
+	int fullTicks = measureFastPlayback(&fullPathLength, &fullPathError);
+
+	// Reload the routine mirrored and played at half speed, as the load-time transform should produce it
+	autonFlipped = -1;
+	autonPlaybackTransform.timeScale = 200;
+	loadAuton(SIM_SLOT);
+	int transformMismatches = 0;
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		joyState mirrored = expected[i / 2];
+		mirrored.turn = -mirrored.turn;
+		mirrored.horizontal = -mirrored.horizontal;
+		transformMismatches += countStateMismatches(&states[i], &mirrored, 1);
+	}
+	autonFlipped = 1;
+	autonPlaybackTransform.timeScale = 100;
+
+	// Switch back to the unmirrored routine, which should come from the routine cache without reading the file
+	char filename[AUTON_FILENAME_MAX_LENGTH];
+	snprintf(filename, sizeof(filename), "a%d", SIM_SLOT);
+	int fileReads = simFileReads(filename);
+	start = simRealMicros();
+	loadAuton(SIM_SLOT);
+	unsigned long switchTime = simRealMicros() - start;
+	fileReads = simFileReads(filename) - fileReads;
+	int switchMismatches = countStateMismatches(states, expected, AUTON_NUM_STATES);
+
+	// Load a routine in the headerless format of the original saveAuton(), which stores horizontal before turn
+	static joyState legacy[AUTON_NUM_STATES];
+	fillSyntheticStates(1);
+	memcpy(legacy, states, sizeof(legacy));
+	char legacyName[AUTON_FILENAME_MAX_LENGTH];
+	snprintf(legacyName, sizeof(legacyName), "a%d", SIM_SLOT + 1);
+	FILE* legacyFile = fopen(legacyName, "w");
+	for (int i = 0; i < AUTON_NUM_STATES; i++) {
+		const signed char fields[AUTON_LEGACY_STATE_SIZE] = { legacy[i].spd, legacy[i].horizontal, legacy[i].turn,
+				legacy[i].sht, legacy[i].lift };
+		fwrite(fields, 1, sizeof(fields), legacyFile);
+	}
+	fclose(legacyFile);
+	memset(states, 0, sizeof(states));
+	autonLoaded = 0;
+	loadAuton(SIM_SLOT + 1);
+	int legacyMismatches = (autonLoaded == SIM_SLOT + 1) ? countStateMismatches(states, legacy, AUTON_NUM_STATES)
+			: AUTON_NUM_STATES;
+
+	// An event recording without events, not even the end marker, has no length to play back and must not load
+	autonHeader emptyHeader = { .magic = AUTON_FILE_MAGIC, .version = AUTON_FILE_VERSION_EVENTS | AUTON_FILE_FLAG_BATTERY,
+			.numStates = 0, .pollFreq = AUTON_EVENT_SAMPLE_FREQ, .checksum = autonChecksum(NULL, 0),
+			.batteryLevel = SIM_BATTERY_NOMINAL };
+	char emptyName[AUTON_FILENAME_MAX_LENGTH];
+	snprintf(emptyName, sizeof(emptyName), "a%d", SIM_SLOT + 2);
+	FILE* emptyFile = fopen(emptyName, "w");
+	fwrite(&emptyHeader, 1, sizeof(emptyHeader), emptyFile);
+	fclose(emptyFile);
+	loadAuton(SIM_SLOT + 2);
+	bool emptyRejected = autonLoaded == 0;
+
+	report("replay: recorded %d ticks in %lu us, %d states differ from the capture\n", recordTicks, recordTime,
+			recordMismatches);
+	report("replay: saved %d bytes, loaded in %lu us, %d states differ after reloading\n", simFileSize(filename),
+			loadTime, loadMismatches);
+	report("replay: booted slot %d, preloaded in %lu us, %d states differ\n", bootSlot, bootTime, bootMismatches);
+	report("replay: played back %d ticks in %lu us, %d ticks of motor output differ from the recording\n",
+			playbackTicks, playbackTime, motorMismatches);
+	report("replay: streamed %d telemetry frames (%lu dropped), %d differ from the motor output\n", telemetryFrames,
+			dropped, telemetryMismatches);
+	report("replay: played back a moving routine at %u mV, motor power %d%% of a full battery\n", SIM_BATTERY_FLAT,
+			flatGain);
+	report("replay: played back at %d%% in %d ticks (expected %d), ended %d ticks from the recorded path of %d\n",
+			SIM_FAST_SPEED, fastTicks, expectedFastTicks, pathError, pathLength);
+	report("replay: played back at full stick at %d%% in %d ticks, ended %d ticks from the recorded path of %d\n",
+			SIM_FAST_SPEED, fullTicks, fullPathError, fullPathLength);
+	report("replay: reloaded mirrored at half speed, %d states differ\n", transformMismatches);
+	report("replay: switched back in %lu us with %d file reads, %d states differ\n", switchTime, fileReads,
+			switchMismatches);
+	report("replay: loaded a file without a header, %d states differ\n", legacyMismatches);
+	report("replay: %s an event recording without events\n", emptyRejected ? "rejected" : "loaded");
+
+	bool passed = recordMismatches == 0 && loadMismatches == 0 && motorMismatches == 0 && transformMismatches == 0
+#ifndef AUTON_POT_SELECT
+			&& bootSlot == SIM_SLOT
+#endif
+			&& bootMismatches == 0
+			&& nominalPower > 0 && flatTicks == nominalTicks && fastTicks == expectedFastTicks && pathLength > 0
+			&& pathError <= pathLength / 10
+			&& fullPathLength > 0 && fullPathError <= fullPathLength / 10;
+#ifdef AUTON_BATTERY_COMPENSATION
+	passed = passed && flatGain > 100;
+#endif
+	passed = passed && switchMismatches == 0 && legacyMismatches == 0 && emptyRejected;
+#ifdef TELEMETRY_ENABLED
+	passed = passed && telemetryMismatches == 0 && telemetryFrames + (int) dropped == playbackTicks;
+#endif
+#ifdef AUTON_CACHE
+	passed = passed && fileReads == 0;
+#endif
+	report("replay: %s\n", passed ? "PASS" : "FAIL");
+	return passed ? 0 : 1;
+}
+
+/**
+ * Uploads a saved routine through the link pseudo-terminal and downloads it back into the next slot, checking the
+ * serial link against tools/autonlink
+ *
+ * @return the process exit code
+ */
+static int runLink() {
+	const char* path = simOpenLink();
+	if (path == NULL) {
+		report("Cannot create the link pseudo-terminal\n");
+		return 1;
+	}
+	fillSyntheticStates(0);
+	queueSlotSelection(SIM_SLOT);
+	saveAuton();
+	static joyState saved[AUTON_NUM_STATES];
+	memcpy(saved, states, sizeof(saved));
+
+	report("link: run \"autonlink -p %s get <file>\" to upload slot %d\n", path, SIM_SLOT);
+	uploadAutonToComputer(SIM_SLOT);
+	report("link: run \"autonlink -p %s put <file>\" to download into slot %d\n", path, SIM_SLOT + 1);
+	memset(states, 0, sizeof(states));
+	downloadAutonFromComputer(SIM_SLOT + 1);
+
+	int mismatches = (autonLoaded == SIM_SLOT + 1) ? countStateMismatches(saved, states, AUTON_NUM_STATES) : AUTON_NUM_STATES;
+	report("link: %s, %d of %d downloaded states differ\n", (mismatches == 0) ? "PASS" : "FAIL", mismatches,
+			AUTON_NUM_STATES);
+	return (mismatches == 0) ? 0 : 1;
+}
+
+/**
+ * Boots the robot code and runs the mode chosen on the command line
+ *
+ * @param argc the number of arguments
+ * @param argv "bench", "replay <capture>" or "link", optionally preceded by "-v" to show serial output
+ *
+ * @return the process exit code
+ */
+int main(int argc, char** argv) {
+	int arg = 1;
+	bool verbose = argc > arg && strcmp(argv[arg], "-v") == 0;
+	if (verbose) {
+		arg++;
+	}
+	bool bench = argc == arg + 1 && strcmp(argv[arg], "bench") == 0;
+	bool replay = argc == arg + 2 && strcmp(argv[arg], "replay") == 0;
+	bool link = argc == arg + 1 && strcmp(argv[arg], "link") == 0;
+	if (!bench && !replay && !link) {
+		report("usage: %s [-v] bench | [-v] replay <capture> | [-v] link\n", argv[0]);
+		return 2;
+	}
+
+	simInit();
+	simSetSerialEcho(verbose);
+	simResetFlash();
+
+#ifdef AUTON_FAST_BOOT
+	// The flash is empty, so initialize() preloads "None"; wait for it before keeping the LCD task away from the buttons
+	initializeIO();
+	initialize();
+	waitAutonPreload();
+#else
+	// Choose "None" when initialize() asks which routine to load, then keep the LCD task away from the buttons
+	simQueueLcdButtons(LCD_BTN_CENTER, SIM_PRESS_TIME);
+	simQueueLcdButtons(0, SIM_PRESS_TIME);
+	initializeIO();
+	initialize();
+#endif
+	lockLCDMenu();
+
+	if (link) {
+		return runLink();
+	}
+	return bench ? runBenchmarks() : runReplay(argv[arg + 1]);
+}
@@ -27,5 +27,10 @@
  * so, the robot will await a switch to another mode or disable/enable cycle.
  */
 void autonomous() {
+    motorOutputStopAll();
+    // A field control restart can enter autonomous while the boot routine is still loading
+    waitAutonPreload();
+    lockLCDMenu();
     playbackAuton();
+    unlockLCDMenu();
 }
@@ -7,12 +7,15 @@
  * It works by saving the motor values at a point in time.
  * At the corresponding point in time, the values are played back.
  *
- * This file also handles the recording of programming skills by stitching 4 autonomous routines together.
+ * This file also handles programming skills, which are recorded in one go into a single "sk" file of chunks. Each
+ * chunk is run-length encoded on its own and located by a chunk index, so playback loads the next chunk in the
+ * background and can start from any point in the run.
  */
 
 #include "main.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 /**
  * Stores the joystick state variables for moving the robot.
@@ -31,284 +34,2005 @@ int autonLoaded;
 int autonFlipped = 1;
 
 /**
- * Section number (0-3) of currently loaded programming skills routine.
+ * Transform applied to routines as they are loaded.
  */
-int progSkills;
+autonTransform autonPlaybackTransform = AUTON_TRANSFORM_IDENTITY;
 
 /**
- * Initializes autonomous recorder by setting states array to zero.
+ * Speed in percent of the recorded speed at which routines are played back.
+ */
+int autonPlaybackSpeed = 100;
+
+/**
+ * Time in milliseconds into the loaded routine at which playback starts.
+ */
+int autonPlaybackStart = 0;
+
+/**
+ * The transform that was applied to the loaded routine.
+ */
+static autonTransform loadedTransform = AUTON_TRANSFORM_IDENTITY;
+
+/**
+ * The mirroring that was applied to the loaded routine.
+ */
+static int loadedFlipped = 1;
+
+/**
+ * Average battery voltage in millivolts at which the routine in the states or events array was recorded, or 0 if it is not known.
+ */
+static uint16_t autonBatteryLevel;
+
+/**
+ * Number of states in the loaded programming skills routine.
+ */
+static int skillsStates;
+
+/**
+ * Chunk index of the loaded programming skills file.
+ */
+static autonChunkIndex skillsIndex;
+
+/**
+ * Stores the timestamped events of an event recording.
+ */
+autonEvent events[AUTON_MAX_EVENTS];
+
+/**
+ * Number of valid events in the events array.
+ */
+int numEvents;
+
+/**
+ * Whether the recorded or loaded autonomous routine is stored in the events array (true) or the states array (false).
+ */
+bool autonEventMode;
+
+#ifdef AUTON_SENSORS
+/**
+ * Stores the drive position at each state of the states array.
+ */
+autonSensorFrame sensorTrace[AUTON_TIME*JOY_POLL_FREQ];
+
+/**
+ * Whether the sensorTrace array holds the trace of the recorded or loaded routine.
+ */
+bool sensorTraceLoaded;
+#endif
+
+/**
+ * Number of states read from or written to flash in a single block transfer when streaming a file in pieces.
+ */
+#define AUTON_IO_BLOCK_STATES 50
+
+/**
+ * Number of runs read from or written to flash in a single block transfer for a run-length encoded file.
+ */
+#define AUTON_IO_BLOCK_RUNS 16
+
+/**
+ * Fixed point scale of a playback position, which counts recorded states in steps of 1/AUTON_POSITION_ONE of a state.
+ */
+#define AUTON_POSITION_ONE 256
+
+/**
+ * Computes the Fletcher-16 checksum of a block of autonomous data.
+ *
+ * @param data the packed states or events to checksum
+ * @param size the size of data in bytes
+ *
+ * @return the checksum of the data
+ */
+uint16_t autonChecksum(const void* data, int size) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    unsigned int sum1 = 0;
+    unsigned int sum2 = 0;
+    for (int i = 0; i < size; i++) {
+        sum1 = (sum1 + bytes[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    return (uint16_t) ((sum2 << 8) | sum1);
+}
+
+/**
+ * Counts the number of runs of identical consecutive states in a states buffer.
+ *
+ * @param buf the states to count runs in
+ * @param numStates the number of states in buf
+ *
+ * @return the number of autonRun structs needed to encode buf
+ */
+static int countAutonRuns(const joyState* buf, int numStates) {
+    int numRuns = 0;
+    int runLength = 0;
+    for (int i = 0; i < numStates; i++) {
+        if (runLength == 0 || runLength == AUTON_MAX_RUN_LENGTH || memcmp(buf + i, buf + i - 1, sizeof(joyState)) != 0) {
+            numRuns++;
+            runLength = 0;
+        }
+        runLength++;
+    }
+    return numRuns;
+}
+
+/**
+ * @brief Run-length encoder that writes the runs of a states file in block transfers as the states arrive.
+ */
+typedef struct autonRunWriter {
+    /**
+     * The file being written.
+     */
+    FILE* file;
+    /**
+     * Runs waiting to be written; the run after the first blockRuns is still being extended.
+     */
+    autonRun block[AUTON_IO_BLOCK_RUNS];
+    /**
+     * Number of finished runs in block.
+     */
+    int blockRuns;
+    /**
+     * Whether a run has been started in block.
+     */
+    bool started;
+    /**
+     * Whether every block so far was written.
+     */
+    bool written;
+    /**
+     * Number of bytes of runs written to the file so far.
+     */
+    int size;
+} autonRunWriter;
+
+/**
+ * Prepares a run writer to encode states into a file opened for writing.
+ *
+ * @param writer the writer to prepare
+ * @param autonFile the file to write the runs to, after its header
+ */
+static void startAutonRuns(autonRunWriter* writer, FILE* autonFile) {
+    writer->file = autonFile;
+    writer->blockRuns = 0;
+    writer->started = false;
+    writer->written = true;
+    writer->size = 0;
+}
+
+/**
+ * Adds the next state to a run writer, writing a block of runs whenever the block fills up.
+ *
+ * @param writer the run writer
+ * @param state the state to add
+ */
+static void addAutonRunState(autonRunWriter* writer, const joyState* state) {
+    autonRun* run = &writer->block[writer->blockRuns];
+    if (writer->started && run->count != AUTON_MAX_RUN_LENGTH && memcmp(state, &run->state, sizeof(joyState)) == 0) {
+        run->count++;
+        return;
+    }
+    if (writer->started && ++writer->blockRuns == AUTON_IO_BLOCK_RUNS) {
+        writer->written = writer->written && fwrite(writer->block, 1, sizeof(writer->block), writer->file) == sizeof(writer->block);
+        writer->size += sizeof(writer->block);
+        writer->blockRuns = 0;
+    }
+    run = &writer->block[writer->blockRuns];
+    run->count = 1;
+    run->state = *state;
+    writer->started = true;
+}
+
+/**
+ * Writes the runs left in a run writer.
+ *
+ * @param writer the run writer
+ *
+ * @return true if every run was written, false otherwise
+ */
+static bool finishAutonRuns(autonRunWriter* writer) {
+    int blockRuns = writer->blockRuns + (writer->started ? 1 : 0);
+    writer->blockRuns = 0;
+    writer->started = false;
+    writer->size += blockRuns * sizeof(autonRun);
+    return fwrite(writer->block, 1, blockRuns * sizeof(autonRun), writer->file) == blockRuns * sizeof(autonRun) && writer->written;
+}
+
+/**
+ * Writes a header followed by the states to an autonomous file opened for writing.
+ * The states are run-length encoded unless that would make the file larger than storing them packed.
+ *
+ * @param autonFile the file to write to
+ * @param buf the states to write
+ * @param numStates the number of states in buf
+ * @param batteryLevel the average battery voltage in millivolts at which the states were recorded, or 0 if it is not known
+ *
+ * @return true if the whole file was written, false otherwise
+ */
+static bool writeAutonStates(FILE* autonFile, const joyState* buf, int numStates, uint16_t batteryLevel) {
+    int numRuns = countAutonRuns(buf, numStates);
+    bool compress = numRuns * sizeof(autonRun) < numStates * sizeof(joyState);
+    autonHeader header = {
+        .magic = AUTON_FILE_MAGIC,
+        .version = (compress ? AUTON_FILE_VERSION_RLE : AUTON_FILE_VERSION_RAW) | AUTON_FILE_FLAG_BATTERY,
+        .numStates = numStates,
+        .pollFreq = JOY_POLL_FREQ,
+        .checksum = autonChecksum(buf, numStates * sizeof(joyState)),
+        .batteryLevel = batteryLevel
+    };
+    if (fwrite(&header, 1, sizeof(header), autonFile) != sizeof(header)) {
+        return false;
+    }
+    if (!compress) {
+        return fwrite(buf, 1, numStates * sizeof(joyState), autonFile) == numStates * sizeof(joyState);
+    }
+
+    autonRunWriter writer;
+    startAutonRuns(&writer, autonFile);
+    for (int i = 0; i < numStates; i++) {
+        addAutonRunState(&writer, buf + i);
+    }
+    return finishAutonRuns(&writer);
+}
+
+/**
+ * @brief Streaming decoder for the states stored in an autonomous file.
+ *
+ * Reads packed or run-length encoded states from a file in block transfers, so that a file can be decoded into a
+ * buffer of any size without holding the encoded data in memory. The same decoder reads file images held in the
+ * routine cache.
+ */
+typedef struct autonReader {
+    /**
+     * The file being read, or NULL if a cached file image is being read.
+     */
+    FILE* file;
+    /**
+     * The cached file image being read if file is NULL.
+     */
+    const uint8_t* image;
+    /**
+     * Size of the cached file image in bytes.
+     */
+    int imageSize;
+    /**
+     * Offset in the cached file image of the next byte to read.
+     */
+    int imageOffset;
+    /**
+     * The header of the file.
+     */
+    autonHeader header;
+    /**
+     * Number of states in the file that have not been returned yet.
+     */
+    int statesLeft;
+    /**
+     * Block of runs read from a run-length encoded file.
+     */
+    autonRun runs[AUTON_IO_BLOCK_RUNS];
+    /**
+     * Number of valid runs in the runs block.
+     */
+    int numRuns;
+    /**
+     * Index of the run currently being expanded.
+     */
+    int runIndex;
+    /**
+     * Number of states left to return from the current run.
+     */
+    int runLeft;
+} autonReader;
+
+/**
+ * Reads bytes from the file or cached file image of a reader.
+ *
+ * @param reader the reader to read from
+ * @param buf the buffer to read into
+ * @param size the number of bytes to read
+ *
+ * @return the number of bytes read, which is less than size at the end of the file
+ */
+static int readAutonBytes(autonReader* reader, void* buf, int size) {
+    if (reader->file != NULL) {
+        return fread(buf, 1, size, reader->file);
+    }
+    size = MIN(size, reader->imageSize - reader->imageOffset);
+    memcpy(buf, reader->image + reader->imageOffset, size);
+    reader->imageOffset += size;
+    return size;
+}
+
+/**
+ * Moves a reader to a position in its file or cached file image.
+ *
+ * @param reader the reader to move
+ * @param offset the position in bytes, relative to the origin
+ * @param origin SEEK_SET to count from the start of the file, or SEEK_END to count from its end
+ */
+static void seekAutonReader(autonReader* reader, int offset, int origin) {
+    if (reader->file != NULL) {
+        fseek(reader->file, offset, origin);
+    } else {
+        reader->imageOffset = CLAMP((origin == SEEK_END) ? reader->imageSize + offset : offset, 0, reader->imageSize);
+    }
+}
+
+/**
+ * Reads the header through a reader whose source has been set and prepares it to decode the states that follow.
+ * Files without a header (written before the header was introduced) are reported as version 0 with a full set of packed states.
+ * Headers written before the battery level was recorded are reported with a battery level of 0, and AUTON_FILE_FLAG_BATTERY is cleared from the version.
+ * Files streamed while recording take their checksum and battery level from the trailer, and AUTON_FILE_FLAG_TRAILER is cleared from the version.
+ *
+ * @param reader the reader to prepare
+ *
+ * @return the number of states (or events, for an event recording) in the file, or -1 if the file is from an unsupported format version
+ */
+static int startAutonReader(autonReader* reader) {
+    autonHeader* header = &reader->header;
+    reader->numRuns = 0;
+    reader->runIndex = 0;
+    reader->runLeft = 0;
+    const int legacySize = offsetof(autonHeader, batteryLevel);
+    seekAutonReader(reader, 0, SEEK_SET);
+    header->batteryLevel = 0;
+    header->reserved = 0;
+    if (readAutonBytes(reader, header, legacySize) != legacySize || header->magic != AUTON_FILE_MAGIC) {
+        seekAutonReader(reader, 0, SEEK_SET);
+        header->magic = AUTON_FILE_MAGIC;
+        header->version = 0;
+        header->numStates = AUTON_NUM_STATES;
+        header->pollFreq = JOY_POLL_FREQ;
+        header->checksum = 0;
+        reader->statesLeft = header->numStates;
+        return header->numStates;
+    }
+    int headerSize = legacySize;
+    if (header->version & AUTON_FILE_FLAG_BATTERY) {
+        header->version &= ~AUTON_FILE_FLAG_BATTERY;
+        headerSize = sizeof(*header);
+        if (readAutonBytes(reader, &header->batteryLevel, sizeof(*header) - legacySize) != sizeof(*header) - legacySize) {
+            return -1;
+        }
+    }
+    if (header->version & AUTON_FILE_FLAG_TRAILER) {
+        header->version &= ~AUTON_FILE_FLAG_TRAILER;
+        autonHeader trailer;
+        seekAutonReader(reader, -(int) sizeof(trailer), SEEK_END);
+        // A recording that was cut off before its trailer was written is reported as unsupported
+        if (readAutonBytes(reader, &trailer, sizeof(trailer)) != sizeof(trailer) || trailer.magic != AUTON_FILE_MAGIC
+                || (trailer.version & ~AUTON_FILE_FLAG_BATTERY & ~AUTON_FILE_FLAG_TRAILER) != header->version) {
+            return -1;
+        }
+        header->numStates = trailer.numStates;
+        header->checksum = trailer.checksum;
+        header->batteryLevel = trailer.batteryLevel;
+        seekAutonReader(reader, headerSize, SEEK_SET);
+    }
+    if (header->version == AUTON_FILE_VERSION_EVENTS) {
+        // A recording always ends with its end marker event, which playback takes the length of the routine from
+        if (header->pollFreq != AUTON_EVENT_SAMPLE_FREQ || header->numStates == 0 || header->numStates > AUTON_MAX_EVENTS) {
+            return -1;
+        }
+    } else if (header->version == AUTON_FILE_VERSION_CHUNKED) {
+        if (header->pollFreq != JOY_POLL_FREQ || header->numStates > AUTON_MAX_CHUNKS * AUTON_CHUNK_STATES) {
+            return -1;
+        }
+    } else if ((header->version != AUTON_FILE_VERSION_RAW && header->version != AUTON_FILE_VERSION_RLE && header->version != AUTON_FILE_VERSION_SENSORS) || header->pollFreq != JOY_POLL_FREQ) {
+        return -1;
+    }
+    reader->statesLeft = header->numStates;
+    return header->numStates;
+}
+
+/**
+ * Reads the header of an autonomous file opened for reading and prepares a reader to decode its states.
+ *
+ * @param reader the reader to prepare
+ * @param autonFile the file to read from
+ *
+ * @return the number of states (or events, for an event recording) in the file, or -1 if the file is from an unsupported format version
+ */
+static int openAutonReader(autonReader* reader, FILE* autonFile) {
+    reader->file = autonFile;
+    reader->image = NULL;
+    return startAutonReader(reader);
+}
+
+/**
+ * Reads the header of a cached file image and prepares a reader to decode its states.
+ *
+ * @param reader the reader to prepare
+ * @param image the file image
+ * @param size the size of the file image in bytes
+ *
+ * @return the number of states (or events, for an event recording) in the file, or -1 if the file is from an unsupported format version
+ */
+static int openCachedAutonReader(autonReader* reader, const uint8_t* image, int size) {
+    reader->file = NULL;
+    reader->image = image;
+    reader->imageSize = size;
+    reader->imageOffset = 0;
+    return startAutonReader(reader);
+}
+
+/**
+ * Decodes the next states of an autonomous file.
+ *
+ * @param reader the reader to decode from
+ * @param buf the buffer to decode the states into
+ * @param maxStates the number of states that fit in buf
+ *
+ * @return the number of states decoded, which is less than maxStates at the end of the file
+ */
+static int readAutonReader(autonReader* reader, joyState* buf, int maxStates) {
+    int numStates = MIN(maxStates, reader->statesLeft);
+    if (reader->header.version == 0) {
+        // Files without a header store each state as spd, horizontal, turn, sht, lift, the order the first saveAuton() used,
+        // so the block is read in one go and each state is then rebuilt from its fields in place
+        numStates = readAutonBytes(reader, buf, numStates * AUTON_LEGACY_STATE_SIZE) / AUTON_LEGACY_STATE_SIZE;
+        for (int i = 0; i < numStates; i++) {
+            signed char fields[AUTON_LEGACY_STATE_SIZE];
+            memcpy(fields, (const signed char*) buf + i * AUTON_LEGACY_STATE_SIZE, sizeof(fields));
+            buf[i].spd = fields[0];
+            buf[i].horizontal = fields[1];
+            buf[i].turn = fields[2];
+            buf[i].sht = fields[3];
+            buf[i].lift = fields[4];
+        }
+        reader->statesLeft -= numStates;
+        return numStates;
+    }
+    if (reader->header.version != AUTON_FILE_VERSION_RLE && reader->header.version != AUTON_FILE_VERSION_CHUNKED) {
+        numStates = readAutonBytes(reader, buf, numStates * sizeof(joyState)) / sizeof(joyState);
+        reader->statesLeft -= numStates;
+        return numStates;
+    }
+
+    int decoded = 0;
+    while (decoded < numStates) {
+        if (reader->runLeft == 0) {
+            if (reader->runIndex == reader->numRuns) {
+                reader->numRuns = readAutonBytes(reader, reader->runs, sizeof(reader->runs)) / sizeof(autonRun);
+                reader->runIndex = 0;
+            }
+            if (reader->runIndex == reader->numRuns || reader->runs[reader->runIndex].count == 0) {
+                break;
+            }
+            reader->runLeft = reader->runs[reader->runIndex].count;
+        }
+        int runStates = MIN(reader->runLeft, numStates - decoded);
+        for (int i = 0; i < runStates; i++) {
+            buf[decoded++] = reader->runs[reader->runIndex].state;
+        }
+        reader->runLeft -= runStates;
+        if (reader->runLeft == 0) {
+            reader->runIndex++;
+        }
+    }
+    reader->statesLeft -= decoded;
+    return decoded;
+}
+
+/**
+ * Decodes all the states of a file through a reader that has just been opened.
+ * States past the end of the file are set to zero.
+ *
+ * @param reader the opened reader
+ * @param buf the buffer to read the states into
+ * @param maxStates the number of states that fit in buf
+ *
+ * @return the number of states read, or -1 if the file is corrupt or from an unsupported format version
+ */
+static int decodeAutonStates(autonReader* reader, joyState* buf, int maxStates) {
+    if (reader->header.version > AUTON_FILE_VERSION_RLE) {
+        return -1;
+    }
+    int numStates = readAutonReader(reader, buf, maxStates);
+    memset(buf + numStates, 0, sizeof(joyState) * (maxStates - numStates));
+    if (reader->header.version != 0 && (numStates != reader->header.numStates || autonChecksum(buf, numStates * sizeof(joyState)) != reader->header.checksum)) {
+        return -1;
+    }
+    return numStates;
+}
+
+/**
+ * Reads an entire autonomous file opened for reading into a states buffer.
+ * States past the end of the file are set to zero.
+ *
+ * @param autonFile the file to read from
+ * @param buf the buffer to read the states into
+ * @param maxStates the number of states that fit in buf
+ *
+ * @return the number of states read, or -1 if the file is corrupt or from an unsupported format version
+ */
+static int readAutonStates(FILE* autonFile, joyState* buf, int maxStates) {
+    autonReader reader;
+    if (openAutonReader(&reader, autonFile) < 0) {
+        return -1;
+    }
+    return decodeAutonStates(&reader, buf, maxStates);
+}
+
+/**
+ * Writes a header followed by the events of an event recording to an autonomous file opened for writing.
+ *
+ * @param autonFile the file to write to
+ * @param buf the events to write
+ * @param count the number of events in buf
+ * @param batteryLevel the average battery voltage in millivolts at which the events were recorded, or 0 if it is not known
+ *
+ * @return true if the whole file was written, false otherwise
+ */
+static bool writeAutonEvents(FILE* autonFile, const autonEvent* buf, int count, uint16_t batteryLevel) {
+    autonHeader header = {
+        .magic = AUTON_FILE_MAGIC,
+        .version = AUTON_FILE_VERSION_EVENTS | AUTON_FILE_FLAG_BATTERY,
+        .numStates = count,
+        .pollFreq = AUTON_EVENT_SAMPLE_FREQ,
+        .checksum = autonChecksum(buf, count * sizeof(autonEvent)),
+        .batteryLevel = batteryLevel
+    };
+    if (fwrite(&header, 1, sizeof(header), autonFile) != sizeof(header)) {
+        return false;
+    }
+    return fwrite(buf, 1, count * sizeof(autonEvent), autonFile) == count * sizeof(autonEvent);
+}
+
+/**
+ * Reads the events of an event recording through a reader that has just been opened, in one block transfer.
+ *
+ * @param reader the opened reader
+ * @param buf the buffer to read the events into
+ * @param maxEvents the number of events that fit in buf
+ *
+ * @return the number of events read, or -1 if the file is corrupt or is not an event recording
+ */
+static int decodeAutonEvents(autonReader* reader, autonEvent* buf, int maxEvents) {
+    int count = reader->header.numStates;
+    if (count <= 0 || count > maxEvents || reader->header.version != AUTON_FILE_VERSION_EVENTS) {
+        return -1;
+    }
+    if (readAutonBytes(reader, buf, count * sizeof(autonEvent)) != count * sizeof(autonEvent)
+            || autonChecksum(buf, count * sizeof(autonEvent)) != reader->header.checksum) {
+        return -1;
+    }
+    return count;
+}
+
+/**
+ * Reads the events of an event recording opened for reading in one block transfer.
+ *
+ * @param autonFile the file to read from
+ * @param buf the buffer to read the events into
+ * @param maxEvents the number of events that fit in buf
+ *
+ * @return the number of events read, or -1 if the file is corrupt or is not an event recording
+ */
+static int readAutonEvents(FILE* autonFile, autonEvent* buf, int maxEvents) {
+    autonReader reader;
+    if (openAutonReader(&reader, autonFile) < 0) {
+        return -1;
+    }
+    return decodeAutonEvents(&reader, buf, maxEvents);
+}
+
+#ifdef AUTON_SENSORS
+/**
+ * Gets the name of the file that holds the sensor trace of an autonomous slot.
+ *
+ * @param filename the buffer to write the file name to (at least AUTON_FILENAME_MAX_LENGTH long)
+ * @param autonSlot the slot (1 - MAX_AUTON_SLOTS) of the routine
+ */
+static void getSensorTraceFilename(char* filename, int autonSlot) {
+    snprintf(filename, AUTON_FILENAME_MAX_LENGTH, "s%d", autonSlot);
+}
+
+/**
+ * Saves the sensor trace of a routine next to its states file, or removes a stale trace if there is none to save.
+ *
+ * @param autonSlot the slot (1 - MAX_AUTON_SLOTS) of the routine
+ */
+static void saveSensorTrace(int autonSlot) {
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    getSensorTraceFilename(filename, autonSlot);
+    if (!sensorTraceLoaded || autonEventMode) {
+        fdelete(filename);
+        return;
+    }
+    FILE* traceFile = fopen(filename, "w");
+    if (traceFile == NULL) {
+        LOG_WARN("Could not save sensor trace for slot %d.\n", autonSlot);
+        return;
+    }
+    autonHeader header = {
+        .magic = AUTON_FILE_MAGIC,
+        .version = AUTON_FILE_VERSION_SENSORS | AUTON_FILE_FLAG_BATTERY,
+        .numStates = AUTON_NUM_STATES,
+        .pollFreq = JOY_POLL_FREQ,
+        .checksum = autonChecksum(sensorTrace, sizeof(sensorTrace)),
+        .batteryLevel = autonBatteryLevel
+    };
+    if (fwrite(&header, 1, sizeof(header), traceFile) != sizeof(header)
+            || fwrite(sensorTrace, 1, sizeof(sensorTrace), traceFile) != sizeof(sensorTrace)) {
+        LOG_WARN("Could not save sensor trace for slot %d.\n", autonSlot);
+    }
+    fclose(traceFile);
+}
+
+/**
+ * Loads the sensor trace of a routine into the sensorTrace array if one was saved with it.
+ *
+ * @param autonSlot the slot (1 - MAX_AUTON_SLOTS) of the routine
+ */
+static void loadSensorTrace(int autonSlot) {
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    getSensorTraceFilename(filename, autonSlot);
+    sensorTraceLoaded = false;
+    FILE* traceFile = fopen(filename, "r");
+    if (traceFile == NULL) {
+        return;
+    }
+    autonReader reader;
+    if (openAutonReader(&reader, traceFile) == AUTON_NUM_STATES && reader.header.version == AUTON_FILE_VERSION_SENSORS
+            && fread(sensorTrace, 1, sizeof(sensorTrace), traceFile) == sizeof(sensorTrace)
+            && autonChecksum(sensorTrace, sizeof(sensorTrace)) == reader.header.checksum) {
+        sensorTraceLoaded = true;
+        LOG_INFO("Loaded sensor trace for slot %d.\n", autonSlot);
+    } else {
+        LOG_WARN("Sensor trace for slot %d is corrupt, playing back open loop.\n", autonSlot);
+    }
+    fclose(traceFile);
+}
+
+/**
+ * Records the current drive position into the sensor trace.
+ *
+ * @param index the index of the state being recorded
+ */
+static void recordSensorFrame(int index) {
+    drivePose pose;
+    readDriveSensors(&pose);
+    sensorTrace[index].forward = pose.forward;
+    sensorTrace[index].horizontal = pose.horizontal;
+    sensorTrace[index].turn = pose.turn;
+}
+
+/**
+ * Corrects a replayed command using the difference between the recorded and current drive position.
+ *
+ * @param state the command to correct
+ * @param index the index of the state being played back
+ */
+static void applySensorCorrection(joyState* state, int index) {
+    drivePose pose;
+    readDriveSensors(&pose);
+    int forwardError = sensorTrace[index].forward - pose.forward;
+    int horizontalError = sensorTrace[index].horizontal - pose.horizontal;
+    int turnError = sensorTrace[index].turn - pose.turn;
+    state->spd = CLAMP(state->spd + CLAMP(forwardError * AUTON_SENSOR_KP_NUM / AUTON_SENSOR_KP_DEN, -AUTON_SENSOR_MAX_CORRECTION, AUTON_SENSOR_MAX_CORRECTION), -127, 127);
+    state->horizontal = CLAMP(state->horizontal + CLAMP(horizontalError * AUTON_SENSOR_KP_NUM / AUTON_SENSOR_KP_DEN, -AUTON_SENSOR_MAX_CORRECTION, AUTON_SENSOR_MAX_CORRECTION), -127, 127);
+    state->turn = CLAMP(state->turn + CLAMP(turnError * AUTON_SENSOR_KP_NUM / AUTON_SENSOR_KP_DEN, -AUTON_SENSOR_MAX_CORRECTION, AUTON_SENSOR_MAX_CORRECTION), -127, 127);
+    LOG_DEBUG("Sensor correction at state %d, error: %d %d %d\n", index, forwardError, horizontalError, turnError);
+}
+#endif
+
+/**
+ * Mirrors a state by autonFlipped and applies the gains of autonPlaybackTransform to it.
+ *
+ * @param state the state to transform
+ *
+ * @return the transformed state
+ */
+static joyState transformState(joyState state) {
+    const autonTransform* transform = &autonPlaybackTransform;
+    joyState result = {
+        .spd = CLAMP(state.spd * transform->spdGain / 100, -127, 127),
+        .turn = CLAMP(state.turn * autonFlipped * transform->turnGain / 100, -127, 127),
+        .horizontal = CLAMP(state.horizontal * autonFlipped * transform->horizontalGain / 100, -127, 127),
+        .sht = CLAMP(state.sht * transform->shtGain / 100, -127, 127),
+        // A lift command is a direction or a preset height rather than a power, so no gain applies to it
+        .lift = state.lift
+    };
+    return result;
+}
+
+/**
+ * Clamps the gains and time scale of autonPlaybackTransform to the range the transform supports.
+ */
+static void checkTransform() {
+    autonTransform* transform = &autonPlaybackTransform;
+    autonTransform checked = {
+        .spdGain = CLAMP(transform->spdGain, 0, AUTON_TRANSFORM_MAX_GAIN),
+        .turnGain = CLAMP(transform->turnGain, 0, AUTON_TRANSFORM_MAX_GAIN),
+        .horizontalGain = CLAMP(transform->horizontalGain, 0, AUTON_TRANSFORM_MAX_GAIN),
+        .shtGain = CLAMP(transform->shtGain, 0, AUTON_TRANSFORM_MAX_GAIN),
+        .timeScale = CLAMP(transform->timeScale, AUTON_TRANSFORM_MIN_TIME_SCALE, AUTON_TRANSFORM_MAX_TIME_SCALE)
+    };
+    if (memcmp(&checked, transform, sizeof(checked)) != 0) {
+        LOG_WARN("Playback transform out of range, clamped.\n");
+        *transform = checked;
+    }
+}
+
+/**
+ * Checks whether the current mirroring and transform leave a routine unchanged.
+ *
+ * @return true if loading needs no transform pass
+ */
+static bool isIdentityTransform() {
+    static const autonTransform identity = AUTON_TRANSFORM_IDENTITY;
+    return autonFlipped == 1 && memcmp(&autonPlaybackTransform, &identity, sizeof(identity)) == 0;
+}
+
+/**
+ * Mirrors, scales and retimes a buffer of loaded states in place in a single pass.
+ * Each output state holds the input state at the matching recorded time, so stretching repeats states and compressing
+ * skips them; states past the end of a compressed routine are set to zero.
+ *
+ * @param buf the states to transform
+ * @param numStates the number of states in buf
+ */
+static void transformAutonStates(joyState* buf, int numStates) {
+    if (isIdentityTransform()) {
+        return;
+    }
+    int scale = MAX(autonPlaybackTransform.timeScale, 1);
+    if (scale >= 100) {
+        // Every state is read from an earlier or the same index, so going backwards never reads a transformed state
+        for (int i = numStates - 1; i >= 0; i--) {
+            buf[i] = transformState(buf[i * 100 / scale]);
+        }
+    } else {
+        joyState stopped = {0, 0, 0, 0, 0};
+        for (int i = 0; i < numStates; i++) {
+            int source = i * 100 / scale;
+            buf[i] = (source < numStates) ? transformState(buf[source]) : stopped;
+        }
+    }
+}
+
+/**
+ * Mirrors, scales and retimes the loaded events in place.
+ *
+ * @param buf the events to transform
+ * @param count the number of events in buf
+ */
+static void transformAutonEvents(autonEvent* buf, int count) {
+    if (isIdentityTransform()) {
+        return;
+    }
+    int scale = MAX(autonPlaybackTransform.timeScale, 1);
+    for (int i = 0; i < count; i++) {
+        buf[i].time = MIN((unsigned long) buf[i].time * scale / 100, 0xFFFF);
+        buf[i].state = transformState(buf[i].state);
+    }
+}
+
+/**
+ * Applies the mirroring and transform to the routine that was just loaded into the states or events array, and to its
+ * sensor trace, and remembers them so that loadAuton() can tell when they change.
+ */
+static void transformLoadedAuton() {
+    checkTransform();
+    if (autonEventMode) {
+        transformAutonEvents(events, numEvents);
+    } else {
+        transformAutonStates(states, AUTON_NUM_STATES);
+    }
+#ifdef AUTON_SENSORS
+    if (sensorTraceLoaded && !isIdentityTransform()) {
+        const autonTransform* transform = &autonPlaybackTransform;
+        if (transform->spdGain != 100 || transform->turnGain != 100 || transform->horizontalGain != 100 || transform->timeScale != 100) {
+            // The robot no longer follows the recorded path, so correcting towards it would fight the transform
+            LOG_INFO("Playback transform changes the drive path, ignoring the sensor trace.\n");
+            sensorTraceLoaded = false;
+        } else {
+            for (int i = 0; i < AUTON_NUM_STATES; i++) {
+                sensorTrace[i].horizontal *= autonFlipped;
+                sensorTrace[i].turn *= autonFlipped;
+            }
+        }
+    }
+#endif
+    loadedTransform = autonPlaybackTransform;
+    loadedFlipped = autonFlipped;
+}
+
+/**
+ * The slot directory: every autonomous slot followed by the programming skills file.
+ */
+static autonSlotInfo autonDirectory[AUTON_DIRECTORY_SIZE];
+
+/**
+ * Gets the slot directory index of an autonomous slot or of programming skills.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return the index into autonDirectory, or -1 if the slot is not valid
+ */
+static int getDirectoryIndex(int slot) {
+    if (slot >= 1 && slot <= MAX_AUTON_SLOTS) {
+        return slot - 1;
+    } else if (slot == AUTON_SKILLS_SLOT) {
+        return MAX_AUTON_SLOTS;
+    }
+    return -1;
+}
+
+/**
+ * Gets the name of the file that holds an autonomous slot or programming skills.
+ *
+ * @param filename the buffer to write the file name to (at least AUTON_FILENAME_MAX_LENGTH long)
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+static bool getSlotFilename(char* filename, int slot) {
+    if (slot >= 1 && slot <= MAX_AUTON_SLOTS) {
+        snprintf(filename, AUTON_FILENAME_MAX_LENGTH, "a%d", slot);
+    } else if (slot == AUTON_SKILLS_SLOT) {
+        snprintf(filename, AUTON_FILENAME_MAX_LENGTH, "sk");
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#ifdef AUTON_CACHE
+/**
+ * @brief A routine file held in the cache.
+ */
+typedef struct autonCacheEntry {
+    /**
+     * The slot the file belongs to, numbered as in the slot directory, or 0 if the entry is unused.
+     */
+    int slot;
+    /**
+     * Offset of the file image in autonCachePool.
+     */
+    int offset;
+    /**
+     * Size of the file image in bytes.
+     */
+    int size;
+    /**
+     * Value of autonCacheClock when the file was last loaded, used to find the least recently loaded entry.
+     */
+    unsigned long lastUsed;
+} autonCacheEntry;
+
+/**
+ * File images of the cached routines, packed from the start with no gaps between them.
+ */
+static uint8_t autonCachePool[AUTON_CACHE_SIZE];
+
+/**
+ * The cached routines.
+ */
+static autonCacheEntry autonCache[AUTON_CACHE_ENTRIES];
+
+/**
+ * Number of bytes of autonCachePool in use.
+ */
+static int autonCacheUsed;
+
+/**
+ * Counts cache lookups, giving the order in which entries were last used.
+ */
+static unsigned long autonCacheClock;
+
+/**
+ * Drops a file from the cache, moving the images after it down to close the gap.
+ *
+ * @param entry the cache entry to drop
+ */
+static void dropCachedAuton(autonCacheEntry* entry) {
+    int end = entry->offset + entry->size;
+    memmove(autonCachePool + entry->offset, autonCachePool + end, autonCacheUsed - end);
+    for (int i = 0; i < AUTON_CACHE_ENTRIES; i++) {
+        if (autonCache[i].slot != 0 && autonCache[i].offset > entry->offset) {
+            autonCache[i].offset -= entry->size;
+        }
+    }
+    autonCacheUsed -= entry->size;
+    entry->slot = 0;
+}
+
+/**
+ * Finds the cached file image of a slot and marks it as the most recently used.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ * @param size receives the size of the file image in bytes
+ *
+ * @return the file image, or NULL if the slot's file is not cached
+ */
+static const uint8_t* findCachedAuton(int slot, int* size) {
+    for (int i = 0; i < AUTON_CACHE_ENTRIES; i++) {
+        if (autonCache[i].slot == slot) {
+            autonCache[i].lastUsed = ++autonCacheClock;
+            *size = autonCache[i].size;
+            return autonCachePool + autonCache[i].offset;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Reads a whole slot file into the cache in one block transfer, dropping the least recently used files until it fits.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ * @param autonFile the slot's file, opened for reading
+ * @param size receives the size of the file image in bytes
+ *
+ * @return the file image, or NULL if the file is larger than the cache or could not be read
+ */
+static const uint8_t* cacheAutonFile(int slot, FILE* autonFile, int* size) {
+    fseek(autonFile, 0, SEEK_END);
+    int fileSize = ftell(autonFile);
+    fseek(autonFile, 0, SEEK_SET);
+    if (fileSize <= 0 || fileSize > AUTON_CACHE_SIZE) {
+        return NULL;
+    }
+    autonCacheEntry* free = NULL;
+    while (free == NULL || autonCacheUsed + fileSize > AUTON_CACHE_SIZE) {
+        autonCacheEntry* oldest = NULL;
+        free = NULL;
+        for (int i = 0; i < AUTON_CACHE_ENTRIES; i++) {
+            if (autonCache[i].slot == 0) {
+                free = &autonCache[i];
+            } else if (oldest == NULL || autonCache[i].lastUsed < oldest->lastUsed) {
+                oldest = &autonCache[i];
+            }
+        }
+        if (free == NULL || autonCacheUsed + fileSize > AUTON_CACHE_SIZE) {
+            LOG_DEBUG("Dropping slot %d from the auton cache.\n", oldest->slot);
+            dropCachedAuton(oldest);
+        }
+    }
+    if (fread(autonCachePool + autonCacheUsed, 1, fileSize, autonFile) != fileSize) {
+        return NULL;
+    }
+    free->slot = slot;
+    free->offset = autonCacheUsed;
+    free->size = fileSize;
+    free->lastUsed = ++autonCacheClock;
+    autonCacheUsed += fileSize;
+    *size = fileSize;
+    return autonCachePool + free->offset;
+}
+
+/**
+ * Drops a slot's file from the cache, if it is cached, so that the next load reads the file again.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ */
+static void invalidateCachedAuton(int slot) {
+    for (int i = 0; i < AUTON_CACHE_ENTRIES; i++) {
+        if (autonCache[i].slot == slot) {
+            dropCachedAuton(&autonCache[i]);
+        }
+    }
+}
+#endif
+
+/**
+ * Reads the header of a slot's file into its slot directory entry.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ */
+static void updateAutonSlot(int slot) {
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    int index = getDirectoryIndex(slot);
+    if (index < 0 || !getSlotFilename(filename, slot)) {
+        return;
+    }
+#ifdef AUTON_CACHE
+    invalidateCachedAuton(slot);
+#endif
+    autonSlotInfo* info = &autonDirectory[index];
+    memset(info, 0, sizeof(*info));
+    FILE* autonFile = fopen(filename, "r");
+    if (autonFile != NULL) {
+        autonReader reader;
+        info->present = true;
+        info->valid = openAutonReader(&reader, autonFile) >= 0 && ((slot < 0) ? reader.header.version == AUTON_FILE_VERSION_CHUNKED
+                : (reader.header.version <= AUTON_FILE_VERSION_RLE || reader.header.version == AUTON_FILE_VERSION_EVENTS));
+        info->version = reader.header.version;
+        info->numStates = reader.header.numStates;
+        info->checksum = reader.header.checksum;
+        fclose(autonFile);
+    }
+    const char* status = !info->present ? " (EMPTY)" : !info->valid ? " (BAD)" : (info->version == AUTON_FILE_VERSION_EVENTS) ? " Events" : "";
+    if (slot > 0) {
+        snprintf(info->label, sizeof(info->label), "Slot: %d%s", slot, status);
+    } else if (info->valid) {
+        snprintf(info->label, sizeof(info->label), "Skills: %d s", info->numStates / JOY_POLL_FREQ);
+    } else {
+        snprintf(info->label, sizeof(info->label), "Skills%s", status);
+    }
+}
+
+/**
+ * Reads the header of every autonomous slot file and of the programming skills file into the slot directory.
+ */
+static void scanAutonDirectory() {
+    for (int slot = 1; slot <= MAX_AUTON_SLOTS; slot++) {
+        updateAutonSlot(slot);
+    }
+    updateAutonSlot(AUTON_SKILLS_SLOT);
+}
+
+/**
+ * Gets the slot directory entry of an autonomous slot or of programming skills.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return the entry, or NULL if the slot is not valid
+ */
+const autonSlotInfo* getAutonSlotInfo(int slot) {
+    int index = getDirectoryIndex(slot);
+    return (index < 0) ? NULL : &autonDirectory[index];
+}
+
+/**
+ * Reads the chunk index of an AUTON_FILE_VERSION_CHUNKED file through a reader that has just been opened.
+ *
+ * @param reader the opened reader
+ * @param index receives the chunk index
+ *
+ * @return true if the index is intact and matches the header, false otherwise
+ */
+static bool readAutonIndex(autonReader* reader, autonChunkIndex* index) {
+    if (reader->header.version != AUTON_FILE_VERSION_CHUNKED) {
+        return false;
+    }
+    seekAutonReader(reader, -(int) (sizeof(autonChunkIndex) + sizeof(autonHeader)), SEEK_END);
+    if (readAutonBytes(reader, index, sizeof(*index)) != sizeof(*index) || autonChecksum(index, sizeof(*index)) != reader->header.checksum
+            || index->numChunks != (reader->header.numStates + AUTON_CHUNK_STATES - 1) / AUTON_CHUNK_STATES) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Decodes one chunk of an AUTON_FILE_VERSION_CHUNKED file, seeking straight to it through the chunk index.
+ * States of the buffer past the end of the chunk are set to zero.
+ *
+ * @param reader a reader opened on the file
+ * @param index the chunk index of the file
+ * @param chunk the number of the chunk to decode, counting from 0
+ * @param buf the buffer to decode the chunk into (AUTON_CHUNK_STATES long)
+ *
+ * @return true if the chunk was decoded and matches its checksum, false otherwise
+ */
+static bool readAutonChunk(autonReader* reader, const autonChunkIndex* index, int chunk, joyState* buf) {
+    if (chunk < 0 || chunk >= index->numChunks || index->chunks[chunk].numStates > AUTON_CHUNK_STATES) {
+        return false;
+    }
+    const autonChunk* entry = &index->chunks[chunk];
+    seekAutonReader(reader, entry->offset, SEEK_SET);
+    reader->numRuns = 0;
+    reader->runIndex = 0;
+    reader->runLeft = 0;
+    reader->statesLeft = entry->numStates;
+    int numStates = readAutonReader(reader, buf, entry->numStates);
+    memset(buf + numStates, 0, sizeof(joyState) * (AUTON_CHUNK_STATES - numStates));
+    return numStates == entry->numStates && autonChecksum(buf, numStates * sizeof(joyState)) == entry->checksum;
+}
+
+/**
+ * Second states buffer. Playback loads the next programming skills chunk into it while the current chunk plays, and
+ * recording captures every other chunk into it.
+ */
+static joyState chunkStates[AUTON_CHUNK_STATES];
+
+/**
+ * The chunk loader task, started by the first chunk request.
+ */
+static TaskHandle chunkLoader = NULL;
+
+/**
+ * Given by playback to ask the chunk loader task to load a chunk.
+ */
+static Semaphore chunkRequest;
+
+/**
+ * Given by the chunk loader task once the requested chunk is in its buffer.
+ */
+static Semaphore chunkReady;
+
+/**
+ * Buffer that the chunk loader task should fill with the requested chunk.
+ */
+static joyState* volatile chunkTarget;
+
+/**
+ * Programming skills chunk that the chunk loader task should load, counting from 0.
+ */
+static volatile int chunkNumber;
+
+/**
+ * Loads programming skills chunks from flash on request so that file reads never happen inside a playback tick.
+ * The chunk index loaded with the routine gives where each chunk starts, so any chunk loads as quickly as the first.
+ * Chunks that are missing or corrupt are loaded as all zero states.
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void chunkLoaderTask(void* ignore) {
+    while (true) {
+        semaphoreTake(chunkRequest, -1);
+        char filename[AUTON_FILENAME_MAX_LENGTH];
+        getSlotFilename(filename, AUTON_SKILLS_SLOT);
+        FILE* skillsFile = fopen(filename, "r");
+        bool loaded = false;
+        if (skillsFile != NULL) {
+            autonReader reader;
+            loaded = openAutonReader(&reader, skillsFile) >= 0 && readAutonChunk(&reader, &skillsIndex, chunkNumber, chunkTarget);
+            fclose(skillsFile);
+        }
+        if (loaded) {
+            transformAutonStates(chunkTarget, AUTON_CHUNK_STATES);
+        } else {
+            LOG_WARN("Could not load programming skills chunk %d, playing it as empty.\n", chunkNumber);
+            memset(chunkTarget, 0, sizeof(joyState) * AUTON_CHUNK_STATES);
+        }
+        semaphoreGive(chunkReady);
+    }
+}
+
+/**
+ * Asks the chunk loader task to load a programming skills chunk in the background.
+ *
+ * @param target the buffer to load the chunk into
+ * @param chunk the number of the chunk to load, counting from 0
+ */
+static void requestChunk(joyState* target, int chunk) {
+    // Only programming skills needs the loader, so its stack is not taken from the other tasks until then
+    if (chunkLoader == NULL) {
+        chunkLoader = taskCreate(chunkLoaderTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT - 1);
+    }
+    chunkTarget = target;
+    chunkNumber = chunk;
+    semaphoreGive(chunkRequest);
+}
+
+/**
+ * Gets the buffer and position that a state of a continuous recording is captured at, alternating between the states
+ * and chunkStates buffers from one chunk to the next.
+ *
+ * @param index the number of the state in the recording, counting from 0
+ *
+ * @return the state in its buffer
+ */
+static joyState* recordedState(int index) {
+    joyState* buf = ((index / AUTON_CHUNK_STATES) % 2 == 0) ? states : chunkStates;
+    return &buf[index % AUTON_CHUNK_STATES];
+}
+
+/**
+ * The file that the states being recorded are streamed to, or NULL if the recording is not being streamed.
+ */
+static FILE* streamFile;
+
+/**
+ * Whether the recording is streamed as an AUTON_FILE_VERSION_CHUNKED file instead of a single run-length encoded routine.
+ */
+static bool streamChunked;
+
+/**
+ * Number of states recorded so far, which the stream writer task may write.
+ */
+static volatile int streamRecorded;
+
+/**
+ * Set once the recording has ended and no more states will be recorded.
+ */
+static volatile bool streamFinished;
+
+/**
+ * Whether the stream writer task wrote the whole file.
+ */
+static volatile bool streamWritten;
+
+/**
+ * Given when more states have been recorded, to wake up the stream writer task.
+ */
+static Semaphore streamReady;
+
+/**
+ * Given by the stream writer task once it has written the trailer.
+ */
+static Semaphore streamDone;
+
+/**
+ * Writes the last runs of a chunk being streamed and stores its length and checksum in the chunk index.
+ *
+ * @param writer the run writer of the chunk
+ * @param chunk the index entry of the chunk
+ * @param lastState the number of the last state of the chunk in the recording
+ *
+ * @return true if every run of the chunk was written, false otherwise
+ */
+static bool endStreamChunk(autonRunWriter* writer, autonChunk* chunk, int lastState) {
+    int numStates = lastState % AUTON_CHUNK_STATES + 1;
+    chunk->numStates = numStates;
+    chunk->checksum = autonChecksum(recordedState(lastState) - (numStates - 1), numStates * sizeof(joyState));
+    return finishAutonRuns(writer);
+}
+
+/**
+ * Run-length encodes the states into streamFile while they are recorded, taking a block of AUTON_IO_BLOCK_STATES
+ * at a time and starting a new chunk every AUTON_CHUNK_STATES. Once the recording ends the last runs are written,
+ * followed by the chunk index of a chunked file and a trailer holding the finished header.
+ *
+ * @param ignore does nothing - required by task definition
+ */
+static void streamWriterTask(void* ignore) {
+    autonHeader header = {
+        .magic = AUTON_FILE_MAGIC,
+        .version = (streamChunked ? AUTON_FILE_VERSION_CHUNKED : AUTON_FILE_VERSION_RLE) | AUTON_FILE_FLAG_BATTERY | AUTON_FILE_FLAG_TRAILER,
+        .pollFreq = JOY_POLL_FREQ
+    };
+    bool written = fwrite(&header, 1, sizeof(header), streamFile) == sizeof(header);
+    autonChunkIndex index;
+    memset(&index, 0, sizeof(index));
+    autonRunWriter writer;
+    uint32_t offset = sizeof(header);
+    int numEncoded = 0;
+    bool finished = false;
+    bool overrun = false;
+    while (!finished) {
+        semaphoreTake(streamReady, -1);
+        // Read the flag first, so that every state is counted once the recording has finished
+        finished = streamFinished;
+        int recorded = MIN(streamRecorded, AUTON_MAX_CHUNKS * AUTON_CHUNK_STATES);
+        int end = finished ? recorded : recorded - recorded % AUTON_IO_BLOCK_STATES;
+        for (; numEncoded < end; numEncoded++) {
+            if (numEncoded % AUTON_CHUNK_STATES == 0) {
+                startAutonRuns(&writer, streamFile);
+                index.chunks[index.numChunks++].offset = offset;
+            }
+            addAutonRunState(&writer, recordedState(numEncoded));
+            if ((numEncoded + 1) % AUTON_CHUNK_STATES == 0 || (finished && numEncoded + 1 == end)) {
+                written = endStreamChunk(&writer, &index.chunks[index.numChunks - 1], numEncoded) && written;
+                offset += writer.size;
+            }
+            // Recording reuses each buffer every other chunk, so a writer a whole chunk behind may have read states
+            // that were already overwritten, and the chunk checksum would match the wrong states
+            if (!overrun && MIN(streamRecorded, AUTON_MAX_CHUNKS * AUTON_CHUNK_STATES) - numEncoded > AUTON_CHUNK_STATES) {
+                LOG_ERROR("Stream writer fell behind the recording at state %d, the routine will not be saved!\n", numEncoded);
+                overrun = true;
+                written = false;
+            }
+        }
+    }
+    header.numStates = numEncoded;
+    header.batteryLevel = autonBatteryLevel;
+    if (streamChunked) {
+        header.checksum = autonChecksum(&index, sizeof(index));
+        written = written && fwrite(&index, 1, sizeof(index), streamFile) == sizeof(index);
+    } else {
+        header.checksum = index.chunks[0].checksum;
+    }
+    streamWritten = written && fwrite(&header, 1, sizeof(header), streamFile) == sizeof(header);
+    semaphoreGive(streamDone);
+    taskDelete(NULL);
+}
+
+/**
+ * Tells the stream writer task how many states have been recorded, waking it up at the end of every block.
+ *
+ * @param recorded the number of states recorded so far
+ * @param finished true once the recording has ended and the battery level is known
+ */
+static void streamRecordedStates(int recorded, bool finished) {
+    if (streamFile == NULL) {
+        return;
+    }
+    streamRecorded = recorded;
+    streamFinished = finished;
+    if (finished || recorded % AUTON_IO_BLOCK_STATES == 0) {
+        semaphoreGive(streamReady);
+    }
+}
+
+/**
+ * Initializes autonomous recorder by setting states array to zero and reading the slot directory.
  */
 void initAutonRecorder() {
-    printf("Beginning initialization of autonomous recorder...\n");
-    lcdClear(LCD_PORT);
-    lcdSetText(LCD_PORT, 1, "Init recorder...");
-    lcdSetText(LCD_PORT, 2, "");
+    LOG_INFO("Beginning initialization of autonomous recorder...\n");
+    lcdClearLines();
+    lcdWriteLine(1, "Init recorder...");
+    lcdWriteLine(2, "");
     memset(states, 0, sizeof(*states));
-    printf("Completed initialization of autonomous recorder.\n");
-    lcdSetText(LCD_PORT, 1, "Init-ed recorder!");
-    lcdSetText(LCD_PORT, 2, "");
+    LOG_INFO("Completed initialization of autonomous recorder.\n");
+    lcdWriteLine(1, "Init-ed recorder!");
+    lcdWriteLine(2, "");
+    autonLoaded = 0;
+    skillsStates = 0;
+    numEvents = 0;
+    autonEventMode = false;
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = false;
+#endif
+    chunkRequest = semaphoreCreate();
+    chunkReady = semaphoreCreate();
+    semaphoreTake(chunkRequest, 0);
+    semaphoreTake(chunkReady, 0);
+    streamFile = NULL;
+    streamReady = semaphoreCreate();
+    streamDone = semaphoreCreate();
+    semaphoreTake(streamReady, 0);
+    semaphoreTake(streamDone, 0);
+    scanAutonDirectory();
+}
+
+/**
+ * Records driver joystick values in one continuous capture of up to maxStates states, handing them to the stream
+ * writer task as they are recorded if a recording is being streamed.
+ * A single routine is recorded into the states array, padded with zero states if it is cancelled early. Longer
+ * recordings alternate between the states and chunkStates buffers, one chunk at a time, and end where they are cancelled.
+ *
+ * @param maxStates the number of states to record, either AUTON_NUM_STATES or a multiple of AUTON_CHUNK_STATES
+ *
+ * @return the number of states recorded
+ */
+static int recordRoutine(int maxStates) {
+    lcdClearLines();
+    for(int i = 3; i > 0; i--){
+        lcdSetBacklight(LCD_PORT, true);
+        LOG_INFO("Beginning autonomous recording in %d...\n", i);
+        lcdWriteLine(1, "Recording auton");
+        lcdPrintLine(2, "in %d...", i);
+        delay(1000);
+    }
+    LOG_INFO("Ready to begin autonomous recording.\n");
+    lcdWriteLine(1, "Recording auton...");
+    lcdWriteLine(2, "");
+    bool lightState = false;
+    unsigned long batteryTotal = 0;
+    unsigned int batterySamples = 0;
+    int numRecorded = 0;
+#ifdef AUTON_SENSORS
+    // The trace only covers the states array, so longer recordings play back open loop
+    bool recordSensors = driveSensorsPresent() && maxStates == AUTON_NUM_STATES;
+    resetDriveSensors();
+#endif
+    loopTimer timer;
+    loopTimerStart(&timer, 1000 / JOY_POLL_FREQ);
+    for (int i = 0; i < maxStates; i++) {
+        LOG_DEBUG("Recording state %d...\n", i);
+        lcdSetBacklight(LCD_PORT, lightState);
+        lightState = !lightState;
+        batteryTotal += powerLevelMain();
+        batterySamples++;
+        driverInputPoll();
+        recordJoyInfo();
+        joyState* state = recordedState(i);
+        commandRead(COMMAND_SOURCE_DRIVER, state);
+        numRecorded = i + 1;
+        LOG_DEBUG("Record State %d, Speed: %d %d %d %d %d\n", i, state->spd, state->horizontal, state->turn, state->sht, state->lift);
+#ifdef AUTON_SENSORS
+        if (recordSensors) {
+            recordSensorFrame(i);
+        }
+#endif
+        if (driverHeld(DRIVER_CANCEL)) {
+            LOG_WARN("Autonomous recording manually cancelled.\n");
+            lcdWriteLine(1, "Cancelled record.");
+            lcdWriteLine(2, "");
+            if (maxStates == AUTON_NUM_STATES) {
+                memset(states + i + 1, 0, sizeof(joyState) * (AUTON_NUM_STATES - i - 1));
+                numRecorded = AUTON_NUM_STATES;
+#ifdef AUTON_SENSORS
+                // The robot stays where it was stopped for the rest of the recording
+                for (int j = i + 1; j < AUTON_NUM_STATES; j++) {
+                    sensorTrace[j] = sensorTrace[i];
+                }
+#endif
+            }
+            i = maxStates;
+        }
+        streamRecordedStates(numRecorded, false);
+        moveRobot(timer.period);
+        loopTimerWait(&timer);
+    }
+    lcdSetBacklight(LCD_PORT, true);
+    loopTimerReport(&timer, "Recording");
+    // A cancelled recording stops the robot for the remaining states, so average over the states that were driven
+    autonBatteryLevel = batteryTotal / batterySamples;
+    LOG_INFO("Recorded at an average battery level of %d mV.\n", autonBatteryLevel);
+    streamRecordedStates(numRecorded, true);
+
+    LOG_INFO("Completed autonomous recording of %d states.\n", numRecorded);
+    lcdWriteLine(1, "Recorded auton!");
+    lcdWriteLine(2, "");
+    motorOutputStopAll();
+    delay(1000);
+    autonLoaded = 0;
+    autonEventMode = false;
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = recordSensors;
+#endif
+    return numRecorded;
+}
+
+/**
+ * Records driver joystick values into states array.
+ */
+void recordAuton() {
+    recordRoutine(AUTON_NUM_STATES);
+}
+
+/**
+ * Records driver joystick changes into the events array, sampling at AUTON_EVENT_SAMPLE_FREQ.
+ * A new event is only stored when the state differs from the previous one.
+ */
+void recordAutonEvents() {
+    lcdClearLines();
+    for(int i = 3; i > 0; i--){
+        lcdSetBacklight(LCD_PORT, true);
+        LOG_INFO("Beginning event recording in %d...\n", i);
+        lcdWriteLine(1, "Recording events");
+        lcdPrintLine(2, "in %d...", i);
+        delay(1000);
+    }
+    LOG_INFO("Ready to begin event recording.\n");
+    lcdWriteLine(1, "Recording events...");
+    lcdWriteLine(2, "");
+
+    numEvents = 0;
+    bool lightState = false;
+    unsigned long batteryTotal = 0;
+    unsigned int batterySamples = 0;
+    unsigned long start = micros();
+    unsigned long elapsed = 0;
+    loopTimer timer;
+    loopTimerStart(&timer, 1000 / AUTON_EVENT_SAMPLE_FREQ);
+    while (elapsed < AUTON_TIME * 1000) {
+        if (timer.ticks % (AUTON_EVENT_SAMPLE_FREQ / JOY_POLL_FREQ) == 0) {
+            lcdSetBacklight(LCD_PORT, lightState);
+            lightState = !lightState;
+        }
+        batteryTotal += powerLevelMain();
+        batterySamples++;
+        driverInputPoll();
+        recordJoyInfo();
+        joyState state;
+        commandRead(COMMAND_SOURCE_DRIVER, &state);
+        if (numEvents == 0 || memcmp(&state, &events[numEvents - 1].state, sizeof(joyState)) != 0) {
+            // Keep the last event free for the end marker
+            if (numEvents == AUTON_MAX_EVENTS - 1) {
+                LOG_WARN("Event buffer full, ending recording at %d ms.\n", (int) elapsed);
+                break;
+            }
+            events[numEvents].time = elapsed;
+            events[numEvents].state = state;
+            events[numEvents].reserved = 0;
+            LOG_DEBUG("Record Event at %d ms, Speed: %d %d %d %d %d\n", (int) elapsed, state.spd, state.horizontal, state.turn, state.sht, state.lift);
+            numEvents++;
+        }
+        if (driverHeld(DRIVER_CANCEL)) {
+            LOG_WARN("Event recording manually cancelled.\n");
+            lcdWriteLine(1, "Cancelled record.");
+            lcdWriteLine(2, "");
+            break;
+        }
+        moveRobot(timer.period);
+        loopTimerWait(&timer);
+        elapsed = (micros() - start) / 1000;
+    }
+    events[numEvents].time = MIN(elapsed, AUTON_TIME * 1000);
+    memset(&events[numEvents].state, 0, sizeof(joyState));
+    events[numEvents].reserved = 0;
+    numEvents++;
+    lcdSetBacklight(LCD_PORT, true);
+    loopTimerReport(&timer, "Event recording");
+    autonBatteryLevel = batteryTotal / batterySamples;
+    LOG_INFO("Recorded at an average battery level of %d mV.\n", autonBatteryLevel);
+
+    LOG_INFO("Completed event recording with %d events.\n", numEvents);
+    lcdWriteLine(1, "Recorded auton!");
+    lcdPrintLine(2, "%d events", numEvents);
+    motorOutputStopAll();
+    delay(1000);
+    autonLoaded = 0;
+    autonEventMode = true;
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = false;
+#endif
+}
+
+/**
+ * Asks which slot to save a recording to.
+ *
+ * @param allowSkills true if the recording can be saved as programming skills, which must be recorded in one continuous capture
+ *
+ * @return the slot to save to (MAX_AUTON_SLOTS + 1 for programming skills), or 0 to not save
+ */
+static int chooseSaveSlot(bool allowSkills) {
+    LOG_INFO("Waiting for file selection...\n");
+    lcdClearLines();
+    lcdWriteLine(1, "Save to?");
+    lcdWriteLine(2, "");
+    int autonSlot = selectAuton(false);
+    if(autonSlot == 0) {
+        LOG_INFO("Not saving this autonomous!\n");
+        delay(1000);
+        return 0;
+    }
+    if(!allowSkills && autonSlot == MAX_AUTON_SLOTS + 1) {
+        LOG_WARN("Programming skills must be recorded in one continuous capture.\n");
+        lcdWriteLine(1, "Can't save this");
+        lcdWriteLine(2, "as prog. skills!");
+        delay(1000);
+        return 0;
+    }
+    if (autonSlot < 0) {
+        LOG_WARN("Invalid autonomous selection.\n");
+        delay(1000);
+        return 0;
+    }
+    return autonSlot;
+}
+
+/**
+ * Opens the file of the slot chosen by chooseSaveSlot() for writing.
+ *
+ * @param autonSlot the slot to save to, where MAX_AUTON_SLOTS + 1 is programming skills
+ *
+ * @return the file, or NULL if it could not be opened
+ */
+static FILE* openSaveFile(int autonSlot) {
+    lcdWriteLine(1, "Saving auton...");
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    if(autonSlot != MAX_AUTON_SLOTS + 1) {
+        LOG_INFO("Not doing programming skills, recording to slot %d.\n",autonSlot);
+        getSlotFilename(filename, autonSlot);
+        lcdPrintLine(2, "Slot: %d", autonSlot);
+    } else {
+        LOG_INFO("Doing programming skills, recording to the skills file.\n");
+        getSlotFilename(filename, AUTON_SKILLS_SLOT);
+        lcdWriteLine(2, "Prog. Skills");
+    }
+    FILE *autonFile = fopen(filename, "w");
+    if (autonFile == NULL) {
+        LOG_ERROR("Error opening autonomous file for saving!\n");
+        lcdWriteLine(1, "Error saving!");
+        if(autonSlot != MAX_AUTON_SLOTS + 1){
+            LOG_ERROR("Not doing programming skills, error saving auton in slot %d!\n", autonSlot);
+            lcdWriteLine(1, "Error saving!");
+            lcdPrintLine(2, "Slot: %d", autonSlot);
+        } else {
+            LOG_ERROR("Doing programming skills, error saving the skills file!\n");
+            lcdWriteLine(1, "Error saving!");
+            lcdWriteLine(2, "Prog. Skills");
+        }
+    }
+    return autonFile;
+}
+
+/**
+ * Finishes saving a recording once its file has been written and closed: updates the slot directory and saves the
+ * sensor trace. Programming skills are loaded again afterwards, since recording leaves the last chunks in the buffers.
+ *
+ * @param autonSlot the slot that was saved to, where MAX_AUTON_SLOTS + 1 is programming skills
+ * @param written whether the whole file was written
+ *
+ * @return true if the recording was saved
+ */
+static bool finishSave(int autonSlot, bool written) {
+    updateAutonSlot((autonSlot != MAX_AUTON_SLOTS + 1) ? autonSlot : AUTON_SKILLS_SLOT);
+    if (!written) {
+        LOG_ERROR("Error writing autonomous to flash!\n");
+        lcdWriteLine(1, "Error saving!");
+        return false;
+    }
+#ifdef AUTON_SENSORS
+    if(autonSlot != MAX_AUTON_SLOTS + 1) {
+        saveSensorTrace(autonSlot);
+    }
+#endif
+    LOG_INFO("Completed saving autonomous.\n");
+    lcdWriteLine(1, "Saved auton!");
+    if(autonSlot != MAX_AUTON_SLOTS + 1) {
+        LOG_INFO("Not doing programming skills, recorded to slot %d.\n",autonSlot);
+        lcdPrintLine(2, "Slot: %d", autonSlot);
+        autonLoaded = autonSlot;
+    } else {
+        LOG_INFO("Doing programming skills, recorded to the skills file.\n");
+        loadAuton(autonSlot);
+    }
+    return true;
+}
+
+/**
+ * Saves contents of the states array to a file in flash memory.
+ */
+void saveAuton() {
+    int autonSlot = chooseSaveSlot(false);
+    if (autonSlot == 0) {
+        return;
+    }
+    FILE* autonFile = openSaveFile(autonSlot);
+    if (autonFile == NULL) {
+        delay(1000);
+        return;
+    }
+    bool written = autonEventMode ? writeAutonEvents(autonFile, events, numEvents, autonBatteryLevel)
+            : writeAutonStates(autonFile, states, AUTON_NUM_STATES, autonBatteryLevel);
+    fclose(autonFile);
+    finishSave(autonSlot, written);
+    delay(1000);
+}
+
+/**
+ * Asks for a slot, then records driver joystick values while streaming them to its file, so the routine is saved as
+ * soon as recording ends. Programming skills are recorded for PROGSKILL_TIME in one continuous capture.
+ */
+void recordAndSaveAuton() {
+    int autonSlot = chooseSaveSlot(true);
+    streamFile = (autonSlot == 0) ? NULL : openSaveFile(autonSlot);
+    if (streamFile == NULL) {
+        // Record anyway, so that the routine can still be played back before it is saved
+        recordAuton();
+        return;
+    }
+    streamChunked = autonSlot == MAX_AUTON_SLOTS + 1;
+    streamFinished = false;
+    streamRecorded = 0;
+    semaphoreTake(streamReady, 0);
+    taskCreate(streamWriterTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT - 1);
+    recordRoutine(streamChunked ? PROGSKILL_TIME * JOY_POLL_FREQ : AUTON_NUM_STATES);
+    semaphoreTake(streamDone, -1);
+    fclose(streamFile);
+    streamFile = NULL;
+    finishSave(autonSlot, streamWritten);
+}
+
+// The largest autonomous file is a programming skills file of AUTON_MAX_CHUNKS chunks that do not compress at all,
+// and the host tool must accept every file that the robot can send
+_Static_assert(LINK_MAX_FILE_SIZE == 2 * sizeof(autonHeader) + sizeof(autonChunkIndex)
+        + AUTON_MAX_CHUNKS * AUTON_CHUNK_STATES * sizeof(autonRun), "LINK_MAX_FILE_SIZE does not match the file format");
+
+/**
+ * Gets the name of the file that a routine is transferred to or from.
+ *
+ * @param filename the buffer to write the file name to (at least AUTON_FILENAME_MAX_LENGTH long)
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return true if the slot is valid, false otherwise
+ */
+static bool getTransferFilename(char* filename, int slot) {
+    if (!getSlotFilename(filename, slot)) {
+        LOG_WARN("Invalid autonomous selection.\n");
+        lcdWriteLine(1, "No slot selected!");
+        lcdWriteLine(2, "");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Checks whether a transfer should stop waiting for the computer, because SERIAL_LINK_WAIT has passed or the center LCD button was pressed.
+ *
+ * @param buttons the LCD button state of the wait
+ * @param start the time in milliseconds at which the wait started
+ *
+ * @return true if the transfer should be abandoned
+ */
+static bool transferCancelled(lcdButtons* buttons, unsigned long start) {
+    lcdPollButtons(buttons);
+    if (LCD_BUTTON_PRESSED(*buttons, LCD_BTN_CENTER) || millis() - start >= SERIAL_LINK_WAIT) {
+        LOG_WARN("No transfer from the computer, cancelling.\n");
+        lcdWriteLine(1, "Transfer cancelled");
+        lcdWriteLine(2, "");
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Checks a downloaded file by loading it, and removes the sensor trace recorded for the routine it replaced.
+ *
+ * @param autonFile the downloaded file, opened for reading
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ *
+ * @return true if the file is valid, false otherwise
+ */
+static bool checkDownloadedAuton(FILE* autonFile, int slot) {
     autonLoaded = 0;
-    progSkills = 0;
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = false;
+#endif
+    autonReader reader;
+    if (openAutonReader(&reader, autonFile) < 0) {
+        return false;
+    }
+    autonBatteryLevel = reader.header.batteryLevel;
+    if (slot == AUTON_SKILLS_SLOT) {
+        // Check every chunk, so that playback never reaches a corrupt one
+        autonEventMode = false;
+        if (!readAutonIndex(&reader, &skillsIndex)) {
+            return false;
+        }
+        for (int chunk = 0; chunk < skillsIndex.numChunks; chunk++) {
+            if (!readAutonChunk(&reader, &skillsIndex, chunk, chunkStates)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    autonEventMode = reader.header.version == AUTON_FILE_VERSION_EVENTS;
+    int numStates;
+    if (autonEventMode) {
+        numStates = numEvents = readAutonEvents(autonFile, events, AUTON_MAX_EVENTS);
+    } else {
+        numStates = readAutonStates(autonFile, states, AUTON_NUM_STATES);
+    }
+    if (numStates < 0) {
+        numEvents = 0;
+        autonEventMode = false;
+        return false;
+    }
+#ifdef AUTON_SENSORS
+    saveSensorTrace(slot);
+#endif
+    transformLoadedAuton();
+    autonLoaded = slot;
+    return true;
 }
 
 /**
- * Records driver joystick values into states array.
+ * Receives an autonomous file over the serial link for downloadAutonFromComputer(), with the telemetry stream paused.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
  */
-void recordAuton() {
-    lcdClear(LCD_PORT);
-    for(int i = 3; i > 0; i--){
-        lcdSetBacklight(LCD_PORT, true);
-        printf("Beginning autonomous recording in %d...\n", i);
-        lcdSetText(LCD_PORT, 1, "Recording auton");
-        lcdPrint(LCD_PORT, 2, "in %d...", i);
+static void receiveAutonFile(int slot) {
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    if (!getTransferFilename(filename, slot)) {
         delay(1000);
+        return;
     }
-    printf("Ready to begin autonomous recording.\n");
-    lcdSetText(LCD_PORT, 1, "Recording auton...");
-    lcdSetText(LCD_PORT, 2, "");
-    bool lightState = false;
-    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-        printf("Recording state %d...\n", i);
-        lcdSetBacklight(LCD_PORT, lightState);
-        lightState = !lightState;
-        recordJoyInfo();
-        states[i].spd = spd;
-        states[i].horizontal = horizontal;
-        states[i].turn = turn;
-        states[i].sht = sht;
-        states[i].lift = lift;
-        printf("Record State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
-        if (joystickGetDigital(1, 7, JOY_UP)) {
-            printf("Autonomous recording manually cancelled.\n");
-            lcdSetText(LCD_PORT, 1, "Cancelled record.");
-            lcdSetText(LCD_PORT, 2, "");
-            memset(states + i + 1, 0, sizeof(joyState) * (AUTON_TIME * JOY_POLL_FREQ - i - 1));
-            i = AUTON_TIME * JOY_POLL_FREQ;
-        }
-        moveRobot();
-        delay(1000 / JOY_POLL_FREQ);
+    motorOutputStopAll();
+    LOG_INFO("Waiting for the computer to send slot %d...\n", slot);
+    lcdWriteLine(1, "Waiting for PC...");
+    lcdWriteLine(2, "Center: cancel");
+    serialLinkFlush();
+
+    linkFrame frame;
+    lcdButtons buttons = {0, 0};
+    unsigned long start = millis();
+    int result;
+    while ((result = serialLinkReceive(&frame, LINK_TIMEOUT)) != LINK_DECODE_FRAME || frame.type != LINK_FRAME_BEGIN) {
+        if (result == LINK_DECODE_CORRUPT) {
+            serialLinkSend(LINK_FRAME_NAK, 0, NULL, 0);
+        }
+        if (transferCancelled(&buttons, start)) {
+            delay(1000);
+            return;
+        }
     }
-    lcdSetBacklight(LCD_PORT, true);
 
-    printf("Completed autonomous recording.\n");
-    lcdSetText(LCD_PORT, 1, "Recorded auton!");
-    lcdSetText(LCD_PORT, 2, "");
-    motorStopAll();
-    delay(1000);
-    autonLoaded = 0;
+    uint32_t size = (frame.length >= 4) ? linkGet32(frame.payload) : LINK_MAX_FILE_SIZE + 1;
+    FILE* autonFile = (size <= LINK_MAX_FILE_SIZE) ? fopen(filename, "w") : NULL;
+    uint8_t status = LINK_STATUS_OK;
+    if (autonFile == NULL) {
+        LOG_ERROR("Cannot download a %d byte file to slot %d!\n", (int) size, slot);
+        lcdWriteLine(1, "Download refused!");
+        status = LINK_STATUS_REJECTED;
+        serialLinkSend(LINK_FRAME_ACK, 0, &status, 1);
+        delay(1000);
+        return;
+    }
+    serialLinkSend(LINK_FRAME_ACK, 0, &status, 1);
+    lcdWriteLine(1, "Downloading...");
+    lcdPrintLine(2, "%d bytes", (int) size);
 
-}
+    unsigned long transferStart = millis();
+    uint32_t received = 0;
+    uint16_t crc = 0xFFFF;
+    uint8_t expected = 1;
+    int failures = 0;
+    bool ended = false;
+    while (!ended && failures < LINK_MAX_RETRIES) {
+        result = serialLinkReceive(&frame, LINK_TIMEOUT);
+        if (result != LINK_DECODE_FRAME) {
+            if (result == LINK_DECODE_CORRUPT) {
+                serialLinkSend(LINK_FRAME_NAK, expected, NULL, 0);
+            }
+            failures++;
+            continue;
+        }
+        failures = 0;
+        uint8_t ack = LINK_STATUS_OK;
+        if (frame.type == LINK_FRAME_DATA && frame.seq == expected) {
+            if (status == LINK_STATUS_OK && (received + frame.length > size || fwrite(frame.payload, 1, frame.length, autonFile) != frame.length)) {
+                status = LINK_STATUS_REJECTED;
+            }
+            received += frame.length;
+            crc = linkCrc16(crc, frame.payload, frame.length);
+            expected++;
+            ack = status;
+        } else if (frame.type == LINK_FRAME_END && frame.seq == expected) {
+            ended = true;
+            continue;
+        } else if (!((frame.type == LINK_FRAME_DATA && frame.seq == (uint8_t) (expected - 1)) || frame.type == LINK_FRAME_BEGIN)) {
+            // Repeats of the last frame only mean its acknowledgement was lost, so only other frames are corrupt
+            serialLinkSend(LINK_FRAME_NAK, expected, NULL, 0);
+            continue;
+        }
+        serialLinkSend(LINK_FRAME_ACK, frame.seq, &ack, 1);
+    }
+    fclose(autonFile);
 
-/**
- * Saves contents of the states array to a file in flash memory.
- */
-void saveAuton() {
-    printf("Waiting for file selection...\n");
-    lcdClear(LCD_PORT);
-    lcdSetText(LCD_PORT, 1, "Save to?");
-    lcdSetText(LCD_PORT, 2, "");
-    int autonSlot;
-    if(progSkills == 0) {
-        autonSlot = selectAuton(false);
+    if (!ended) {
+        LOG_ERROR("Download of slot %d stopped after %d bytes!\n", slot, (int) received);
+        status = LINK_STATUS_REJECTED;
+    } else if (status == LINK_STATUS_OK) {
+        if (received != size || frame.length < 2 || linkGet16(frame.payload) != crc) {
+            status = LINK_STATUS_CORRUPT;
+        } else {
+            autonFile = fopen(filename, "r");
+            if (autonFile == NULL || !checkDownloadedAuton(autonFile, slot)) {
+                status = LINK_STATUS_CORRUPT;
+            }
+            if (autonFile != NULL) {
+                fclose(autonFile);
+            }
+        }
+    }
+    if (status != LINK_STATUS_OK) {
+        fdelete(filename);
+        autonLoaded = 0;
+    }
+    updateAutonSlot(slot);
+    unsigned long elapsed = millis() - transferStart;
+    if (ended) {
+        uint8_t endSeq = frame.seq;
+        serialLinkSend(LINK_FRAME_ACK, endSeq, &status, 1);
+        // Answer repeats of the final frame in case the acknowledgement was lost
+        while (serialLinkReceive(&frame, 2 * LINK_TIMEOUT) != LINK_DECODE_PENDING) {
+            if (frame.type == LINK_FRAME_END && frame.seq == endSeq) {
+                serialLinkSend(LINK_FRAME_ACK, endSeq, &status, 1);
+            }
+        }
+    }
+
+    if (status == LINK_STATUS_OK) {
+        LOG_INFO("Downloaded %d bytes to slot %d in %d ms.\n", (int) received, slot, (int) elapsed);
+        lcdWriteLine(1, "Downloaded auton!");
+    } else if (status == LINK_STATUS_CORRUPT) {
+        LOG_ERROR("Download to slot %d was corrupt and has been discarded!\n", slot);
+        lcdWriteLine(1, "Corrupt download!");
     } else {
-        printf("Currently in the middle of a programming skills run.\n");
-        autonSlot = MAX_AUTON_SLOTS + 1;
+        lcdWriteLine(1, "Download failed!");
     }
-    if(autonSlot == 0) {
-        printf("Not saving this autonomous!\n");
-        delay(1000);
-        return;
+    if (slot == AUTON_SKILLS_SLOT) {
+        lcdWriteLine(2, "Skills");
+    } else {
+        lcdPrintLine(2, "Slot: %d", slot);
     }
-    lcdSetText(LCD_PORT, 1, "Saving auton...");
+    delay(1000);
+}
+
+/**
+ * Sends an autonomous file over the serial link for uploadAutonToComputer(), with the telemetry stream paused.
+ *
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
+ */
+static void sendAutonFile(int slot) {
     char filename[AUTON_FILENAME_MAX_LENGTH];
-    if(autonSlot != MAX_AUTON_SLOTS + 1 && autonSlot > 0) {
-        printf("Not doing programming skills, recording to slot %d.\n",autonSlot);
-        snprintf(filename, sizeof(filename)/sizeof(char), "a%d", autonSlot);
-        lcdPrint(LCD_PORT, 2, "Slot: %d", autonSlot);
-    } else if (autonSlot < 0) {
-        printf("Invalid autonomous selection.");
+    if (!getTransferFilename(filename, slot)) {
         delay(1000);
         return;
-    } else {
-        printf("Doing programming skills, recording to section %d.\n", progSkills);
-        snprintf(filename, sizeof(filename)/sizeof(char), "p%d", progSkills);
-        lcdPrint(LCD_PORT, 2, "Skills Part: %d", progSkills+1);
     }
-    printf("Saving to file %s...\n",filename);
-    FILE *autonFile = fopen(filename, "w");
+    FILE* autonFile = fopen(filename, "r");
     if (autonFile == NULL) {
-        printf("Error saving autonomous in file %s!\n", filename);
-        lcdSetText(LCD_PORT, 1, "Error saving!");
-        if(autonSlot != MAX_AUTON_SLOTS + 1){
-            printf("Not doing programming skills, error saving auton in slot %d!\n", autonSlot);
-            lcdSetText(LCD_PORT, 1, "Error saving!");
-            lcdPrint(LCD_PORT, 2,   "Slot: %d", autonSlot);
-        } else {
-            printf("Doing programming skills, error saving auton in section 0!\n");
-            lcdSetText(LCD_PORT, 1, "Error saving!");
-            lcdSetText(LCD_PORT, 2, "Prog. Skills");
-        }
+        LOG_WARN("No autonomous was saved in slot %d!\n", slot);
+        lcdWriteLine(1, "No auton saved!");
         delay(1000);
         return;
     }
-    signed char write[5];
-    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-        printf("Recording state %d to file %s...\n", i, filename);
-        write[0] = states[i].spd;
-        write[1] = states[i].horizontal;
-        write[2] = states[i].turn;
-        write[3] = states[i].sht;
-        write[4] = states[i].lift;
+    fseek(autonFile, 0, SEEK_END);
+    uint8_t block[LINK_MAX_PAYLOAD];
+    linkPut32(block, ftell(autonFile));
+    fseek(autonFile, 0, SEEK_SET);
 
-        printf("Save State %d, Speed: %d %d %d %d %d\n", i, write[0], write[1], write[2], write[3], write[4]);
-        for (int j = 0; j < 5; j++) {
-            fwrite(write + j, sizeof(char), sizeof(char), autonFile);
+    LOG_INFO("Waiting for the computer to receive slot %d...\n", slot);
+    lcdWriteLine(1, "Waiting for PC...");
+    lcdWriteLine(2, "Center: cancel");
+    serialLinkFlush();
+    lcdButtons buttons = {0, 0};
+    unsigned long start = millis();
+    int status;
+    while ((status = serialLinkRequest(LINK_FRAME_BEGIN, 0, block, 4)) < 0) {
+        if (transferCancelled(&buttons, start)) {
+            fclose(autonFile);
+            delay(1000);
+            return;
         }
-        delay(10);
+    }
+
+    lcdWriteLine(1, "Uploading...");
+    lcdWriteLine(2, "");
+    unsigned long transferStart = millis();
+    int sent = 0;
+    uint16_t crc = 0xFFFF;
+    uint8_t seq = 1;
+    int length;
+    while (status == LINK_STATUS_OK && (length = fread(block, 1, sizeof(block), autonFile)) > 0) {
+        crc = linkCrc16(crc, block, length);
+        status = serialLinkRequest(LINK_FRAME_DATA, seq++, block, length);
+        sent += length;
     }
     fclose(autonFile);
-    printf("Completed saving autonomous to file %s.\n", filename);
-    lcdSetText(LCD_PORT, 1, "Saved auton!");
-    if(autonSlot != MAX_AUTON_SLOTS + 1) {
-        printf("Not doing programming skills, recorded to slot %d.\n",autonSlot);
-        lcdPrint(LCD_PORT, 2, "Slot: %d", autonSlot);
-    } else {
-        printf("Doing programming skills, recorded to section %d.\n", progSkills);
-        lcdPrint(LCD_PORT, 2, "Skills Part: %d", progSkills+1);
+    if (status == LINK_STATUS_OK) {
+        linkPut16(block, crc);
+        status = serialLinkRequest(LINK_FRAME_END, seq, block, 2);
     }
-    delay(1000);
-    if(autonSlot == MAX_AUTON_SLOTS + 1) {
-        printf("Proceeding to next programming skills section (%d).\n", ++progSkills);
+
+    if (status == LINK_STATUS_OK) {
+        LOG_INFO("Uploaded %d bytes from slot %d in %d ms.\n", sent, slot, (int) (millis() - transferStart));
+        lcdWriteLine(1, "Uploaded auton!");
+    } else {
+        LOG_ERROR("Upload of slot %d failed after %d bytes!\n", slot, sent);
+        lcdWriteLine(1, "Upload failed!");
     }
-    if(progSkills == PROGSKILL_TIME/AUTON_TIME) {
-        printf("Finished recording programming skills (all parts).\n");
-        progSkills = 0;
+    if (slot == AUTON_SKILLS_SLOT) {
+        lcdWriteLine(2, "Skills");
+    } else {
+        lcdPrintLine(2, "Slot: %d", slot);
     }
-    autonLoaded = autonSlot;
+    delay(1000);
 }
 
 /**
- * Downloads a 15 second autonomous portion from the computer through the serial monitor
+ * Downloads an autonomous file from the computer over the serial link and writes it straight to flash, one block per frame.
+ * The transfer is started by running "autonlink put" on the computer; the file is only kept if its CRC matches and it loads.
  *
- * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
  */
 void downloadAutonFromComputer(int slot) {
-    motorStopAll();
-
-    char filename[AUTON_FILENAME_MAX_LENGTH + 1];
-    if (slot >= 1 && slot <= 10) {
-        snprintf(filename, sizeof(filename), "a%d", slot);
-    } else if (slot <= -1 && slot >= -4) {
-        snprintf(filename, sizeof(filename), "p%d", -slot - 1);
-    }
-
-    FILE* autonFile = fopen(filename, "w");
-    if (autonFile == NULL) {
-        printf("Writing to autonomous file failed. \n");
-        lcdSetText(LCD_PORT, 1, "Failed to open!");
-        return;
-    } else {
-        printf("Please input the autonomous file fully in the serial input \n");
-        lcdSetText(LCD_PORT, 1, "Waiting for input...");
-
-        signed char read[5] = {0, 0, 0, 0, 0};
-        for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            lcdPrint(LCD_PORT, 2, "Pull state %d", i);
-            for (int j = 0; j < 5; j++) {
-                read[j] = getchar();
-                if (read[j] == -1) {//(fread(read + j, sizeof(char), sizeof(char), stdin) == 0) {
-                    printf("Not enough input for a full autonomous file, ending at state %d", i);
-                    fclose(autonFile);
-                    return;
-                }
-            }
-            states[i].spd = (signed char) read[0];
-            states[i].horizontal = (signed char) read[1];
-            states[i].turn = (signed char) read[2];
-            states[i].sht = (signed char) read[3];
-            states[i].lift = (signed char) read[4];
-            delay(20);
-        }
-
-        lcdPrint(LCD_PORT, 1, "Writing to file...");
-        lcdSetText(LCD_PORT, 2, "");
-
-        signed char write[5];
-        for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            printf("Recording state %d to file %s...\n", i, filename);
-            write[0] = states[i].spd;
-            write[1] = states[i].horizontal;
-            write[2] = states[i].turn;
-            write[3] = states[i].sht;
-            write[4] = states[i].lift;
-
-            printf("Save State %d, Speed: %d %d %d %d %d\n", i, write[0], write[1], write[2], write[3], write[4]);
-            for (int j = 0; j < 5; j++) {
-                fwrite(write + j, sizeof(char), sizeof(char), autonFile);
-            }
-            delay(10);
-        }
-    }
+    // The telemetry stream shares the UART, so it would corrupt the transfer
+    telemetrySetPaused(true);
+    receiveAutonFile(slot);
+    telemetrySetPaused(false);
 }
 
 /**
- * Uploads a 15 second autonomous portion to the computer through the serial monitor
+ * Uploads an autonomous file to the computer over the serial link, sending the file as it is stored in flash one block per frame.
+ * The computer receives it by running "autonlink get".
  *
- * @param slot A number from 1 - 10 for a regular autonomous routine, or a number from -1 to -4 for a programming skills slot
+ * @param slot A number from 1 - MAX_AUTON_SLOTS for a regular autonomous routine, or AUTON_SKILLS_SLOT for programming skills
  */
 void uploadAutonToComputer(int slot) {
-    char filename[AUTON_FILENAME_MAX_LENGTH + 1];
-    if (slot >= 1 && slot <= 10) {
-        snprintf(filename, sizeof(filename), "a%d", slot);
-    } else if (slot <= -1 && slot >= -4) {
-        snprintf(filename, sizeof(filename), "p%d", -slot - 1);
-    }
-
-    FILE* autonFile = fopen(filename, "r");
-    if (autonFile == NULL) {
-        printf("Reading from autonomous file failed. \n");
-        lcdSetText(LCD_PORT, 1, "Failed to open!");
-        return;
-    } else {
-        lcdSetText(LCD_PORT, 1, "Uploading...");
-        lcdSetText(LCD_PORT, 2, "");
-        printf("Sending file...\n");
-        printf("----------\n");
-        char read[5] = {0, 0, 0, 0, 0};
-        for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            for (int j = 0; j < 5; j++) {
-                fseek(autonFile, 5 * i + j, SEEK_SET);
-                fread(read + j, sizeof(char), sizeof(char), autonFile);
-            }
-            printf("%c%c%c%c%c", read[0], read[1], read[2], read[3], read[4]);
-            delay(20);
-        }
-        printf("----------\n");
-        printf("File ended.\n");
-        fclose(autonFile);
-    }
+    telemetrySetPaused(true);
+    sendAutonFile(slot);
+    telemetrySetPaused(false);
 }
 
 /**
  * Gets the autonomous selection from the LCD buttons
  * 
- * @param allowProgSkillSection Allows the user to select a specific programming skills section slot if this is true
+ * @param allowSkillsFile Reports programming skills as the AUTON_SKILLS_SLOT file if this is true
  *
- * @return the autonomous selected (slot number), or if allowProgSkillSection is true and a programming skills is selected, the negative of the programming skill section number from -1 to -4
+ * @return the autonomous selected (slot number), where MAX_AUTON_SLOTS + 1 is programming skills, or AUTON_SKILLS_SLOT if allowSkillsFile is true and programming skills is selected
  */
-int selectAuton(int allowProgSkillSection) {
-    printf("Waiting for file selection...\n");
-    lcdSetText(LCD_PORT, 1, "Select file");
-    lcdSetText(LCD_PORT, 2, "None");
+int selectAuton(int allowSkillsFile) {
+    LOG_INFO("Waiting for file selection...\n");
+    lcdWriteLine(1, "Select file");
+    lcdWriteLine(2, "None");
 
     int curSlot = 0;
 
-    int prevLCDLeft = 0;
-    int prevLCDRight = 0;
-    while ((lcdReadButtons(LCD_PORT) & LCD_BTN_CENTER) == 0) {
-        if (((lcdReadButtons(LCD_PORT) & LCD_BTN_RIGHT) != 0) && prevLCDRight == 0) {
+    lcdButtons buttons = {0, 0};
+    lcdPollButtons(&buttons);
+    while (!LCD_BUTTON_HELD(buttons, LCD_BTN_CENTER)) {
+        if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT)) {
             curSlot = (curSlot + 1) % (MAX_AUTON_SLOTS + 2);
-        } else if (((lcdReadButtons(LCD_PORT) & LCD_BTN_LEFT) != 0) && prevLCDLeft == 0) {
+        } else if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
             curSlot--;
             if (curSlot == -1) {
                 curSlot = MAX_AUTON_SLOTS + 1;
@@ -316,54 +2040,188 @@ int selectAuton(int allowProgSkillSection) {
         }
 
         if (curSlot == 0) {
-            lcdSetText(LCD_PORT, 2, "None");
+            lcdWriteLine(2, "None");
         } else if (curSlot == MAX_AUTON_SLOTS + 1) {
-            lcdSetText(LCD_PORT, 2, "Programming skills");
+            lcdWriteLine(2, getAutonSlotInfo(AUTON_SKILLS_SLOT)->label);
         } else {
-            char filename[AUTON_FILENAME_MAX_LENGTH];
-            snprintf(filename, sizeof(filename)/sizeof(char), "a%d", curSlot);
-            FILE* autonFile = fopen(filename, "r");
-
-            if(autonFile == NULL){
-                lcdPrint(LCD_PORT, 2, "Slot: %d (EMPTY)", curSlot);
-            } else {
-                lcdPrint(LCD_PORT, 2, "Slot: %d", curSlot);
-                fclose(autonFile);
-            }
+            lcdWriteLine(2, getAutonSlotInfo(curSlot)->label);
         }
 
-        prevLCDLeft = lcdReadButtons(LCD_PORT) & LCD_BTN_LEFT;
-        prevLCDRight = lcdReadButtons(LCD_PORT) & LCD_BTN_RIGHT;
-
         delay(20);
+        lcdPollButtons(&buttons);
     }
     delay(500);
 
-    prevLCDLeft = 0;
-    prevLCDRight = 0;
-    int curProgSkillSection = 0;
-    if ((curSlot == MAX_AUTON_SLOTS + 1) && allowProgSkillSection) {
-        while ((lcdReadButtons(LCD_PORT) & LCD_BTN_CENTER) == 0) {
-            lcdSetText(LCD_PORT, 1, "Prog. Skills Slot");
-            
-            if (((lcdReadButtons(LCD_PORT) & LCD_BTN_RIGHT) != 0) && prevLCDRight == 0) {
-                curProgSkillSection = (curProgSkillSection + 1) % (PROGSKILL_TIME / AUTON_TIME);
-            } else if (((lcdReadButtons(LCD_PORT) & LCD_BTN_LEFT) != 0) && prevLCDLeft == 0) {
-                curProgSkillSection--;
-                if (curProgSkillSection == -1) {
-                    curProgSkillSection = 3;
-                }
-            }
+    if ((curSlot == MAX_AUTON_SLOTS + 1) && allowSkillsFile) {
+        return AUTON_SKILLS_SLOT;
+    }
+
+    delay(500);
+    return curSlot;
+}
+
+/**
+ * Name of the file that remembers the routine loaded last, so that it can be loaded again at boot.
+ */
+#define AUTON_BOOT_FILENAME "boot"
+
+/**
+ * @brief The routine loaded last, as stored in the AUTON_BOOT_FILENAME file.
+ */
+typedef struct autonBootChoice {
+    /**
+     * The slot that was loaded, as passed to loadAuton().
+     */
+    signed char slot;
+    /**
+     * The mirroring it was loaded with (-1 if flipped, 1 if not).
+     */
+    signed char flipped;
+} autonBootChoice;
+
+/**
+ * The routine loaded last, which is what the AUTON_BOOT_FILENAME file holds.
+ */
+static autonBootChoice bootChoice = { .slot = 0, .flipped = 1 };
+
+/**
+ * Whether a routine started with startAutonPreload() is still loading.
+ */
+static volatile bool preloadPending;
 
-            lcdPrint(LCD_PORT, 1, "Prog. Skills Part %d", curProgSkillSection + 1);
+/**
+ * The slot being loaded by the preload task.
+ */
+static volatile int preloadSlot;
+
+/**
+ * Records the routine that was just loaded so that the next boot loads it again.
+ * Flash is only written when the routine or its mirroring changes.
+ *
+ * @param autonSlot the slot that was loaded
+ */
+static void rememberBootChoice(int autonSlot) {
+    autonBootChoice choice = { .slot = autonSlot, .flipped = autonFlipped };
+    if (memcmp(&choice, &bootChoice, sizeof(choice)) == 0) {
+        return;
+    }
+    FILE* bootFile = fopen(AUTON_BOOT_FILENAME, "w");
+    if (bootFile == NULL || fwrite(&choice, 1, sizeof(choice), bootFile) != sizeof(choice)) {
+        LOG_WARN("Could not remember slot %d for the next boot.\n", autonSlot);
+    } else {
+        bootChoice = choice;
+    }
+    if (bootFile != NULL) {
+        fclose(bootFile);
+    }
+}
 
-            delay(50);
+/**
+ * Chooses the routine to load at boot without using the LCD, and restores the mirroring it was last loaded with.
+ *
+ * @return the slot that the AUTON_POT potentiometer points at if AUTON_POT_SELECT is defined, or otherwise the slot
+ * loaded last, in the same form as the result of selectAuton()
+ */
+int getBootAutonSlot() {
+    FILE* bootFile = fopen(AUTON_BOOT_FILENAME, "r");
+    if (bootFile != NULL) {
+        autonBootChoice choice;
+        if (fread(&choice, 1, sizeof(choice), bootFile) == sizeof(choice) && choice.slot >= 0 && choice.slot <= MAX_AUTON_SLOTS + 2
+                && (choice.flipped == 1 || choice.flipped == -1)) {
+            bootChoice = choice;
         }
-        return -curProgSkillSection - 1;
+        fclose(bootFile);
     }
+    autonFlipped = bootChoice.flipped;
+#ifdef AUTON_POT_SELECT
+    int value = CLAMP(analogRead(AUTON_POT), AUTON_POT_LOW, AUTON_POT_HIGH);
+    int slot = (value - AUTON_POT_LOW) * (MAX_AUTON_SLOTS + 2) / (AUTON_POT_HIGH - AUTON_POT_LOW + 1);
+    LOG_INFO("Autonomous selector reads %d, booting slot %d.\n", value, slot);
+    return slot;
+#else
+    LOG_INFO("Booting slot %d, which was loaded last.\n", bootChoice.slot);
+    return bootChoice.slot;
+#endif
+}
 
-    delay(500);
-    return curSlot;
+/**
+ * Loads the requested routine and then deletes itself.
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void autonPreloadTask(void* ignore) {
+    unsigned long start = millis();
+    loadAuton(preloadSlot);
+    LOG_INFO("Preloaded slot %d in %d ms.\n", preloadSlot, (int) (millis() - start));
+    preloadPending = false;
+    taskDelete(NULL);
+}
+
+/**
+ * Starts loading a routine in a background task, so that the caller does not wait for flash.
+ *
+ * @param autonSlot the slot to load, as passed to loadAuton()
+ */
+void startAutonPreload(int autonSlot) {
+    preloadSlot = autonSlot;
+    preloadPending = true;
+    if (taskCreate(autonPreloadTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT) == NULL) {
+        LOG_WARN("Could not start the preload task, loading slot %d now.\n", autonSlot);
+        loadAuton(autonSlot);
+        preloadPending = false;
+    }
+}
+
+/**
+ * Waits for a routine started with startAutonPreload() to finish loading; returns immediately if it already has.
+ */
+void waitAutonPreload() {
+    if (preloadPending) {
+        LOG_INFO("Waiting for slot %d to finish loading...\n", preloadSlot);
+    }
+    while (preloadPending) {
+        delay(1);
+    }
+}
+
+/**
+ * Loads the programming skills file for playback: reads its chunk index and decodes the first chunk into the states
+ * array. Playback loads the other chunks in the background as it reaches them.
+ */
+static void loadProgSkills() {
+    LOG_INFO("Performing programming skills.\n");
+    lcdWriteLine(1, "Loading skills...");
+    lcdWriteLine(2, "Prog. Skills");
+    autonLoaded = 0;
+    autonEventMode = false;
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = false;
+#endif
+    char filename[AUTON_FILENAME_MAX_LENGTH];
+    getSlotFilename(filename, AUTON_SKILLS_SLOT);
+    FILE* skillsFile = fopen(filename, "r");
+    if (skillsFile == NULL) {
+        LOG_WARN("Doing programming skills, no skills saved!\n");
+        lcdWriteLine(1, "No skills saved!");
+        return;
+    }
+    autonReader reader;
+    bool loaded = openAutonReader(&reader, skillsFile) >= 0 && readAutonIndex(&reader, &skillsIndex)
+            && readAutonChunk(&reader, &skillsIndex, 0, states);
+    fclose(skillsFile);
+    if (!loaded) {
+        LOG_ERROR("Programming skills file is corrupt!\n");
+        lcdWriteLine(1, "Corrupt skills!");
+        return;
+    }
+    skillsStates = reader.header.numStates;
+    autonBatteryLevel = reader.header.batteryLevel;
+    transformLoadedAuton();
+    LOG_INFO("Loaded %d s of programming skills in %d chunks.\n", skillsStates / JOY_POLL_FREQ, skillsIndex.numChunks);
+    lcdWriteLine(1, "Loaded skills!");
+    lcdPrintLine(2, "Skills: %d s", skillsStates / JOY_POLL_FREQ);
+    autonLoaded = MAX_AUTON_SLOTS + 1;
+    rememberBootChoice(autonLoaded);
 }
 
 /**
@@ -372,158 +2230,412 @@ int selectAuton(int allowProgSkillSection) {
  * @param autonSlot The slot of the autonomous to load. If this value is MAX_AUTON_SLOTS + 1, it will load the programming skills run instead.
  */
 void loadAuton(int autonSlot) {
-    lcdClear(LCD_PORT);
+    lcdClearLines();
     FILE* autonFile;
     char filename[AUTON_FILENAME_MAX_LENGTH];
 
     if(autonSlot == 0) {
-        printf("Not loading an autonomous!\n");
-        lcdSetText(LCD_PORT, 1, "Not loading!");
-        lcdSetText(LCD_PORT, 2, "");
+        LOG_INFO("Not loading an autonomous!\n");
+        lcdWriteLine(1, "Not loading!");
+        lcdWriteLine(2, "");
         autonLoaded = 0;
+        rememberBootChoice(0);
         return;
     } else if(autonSlot == MAX_AUTON_SLOTS + 1){
-        printf("Performing programming skills.\n");
-        lcdSetText(LCD_PORT, 1, "Loading skills...");
-        lcdPrint(LCD_PORT,   2, "Skills Part: 1");
-        autonLoaded = MAX_AUTON_SLOTS + 1;
+        loadProgSkills();
+        return;
     } else if (autonSlot == MAX_AUTON_SLOTS + 2) {
-        printf("Performing hard-coded programming skills.\n");
-        lcdSetText(LCD_PORT, 1, "Loaded skills!");
-        lcdPrint(LCD_PORT,   2, "Hardcoded Skills");
+        LOG_INFO("Performing hard-coded programming skills.\n");
+        lcdWriteLine(1, "Loaded skills!");
+        lcdPrintLine(2, "Hardcoded Skills");
         autonLoaded = MAX_AUTON_SLOTS + 2;
+        rememberBootChoice(autonLoaded);
         return;
-    } else if(autonSlot == autonLoaded) {
-        printf("Autonomous %d is already loaded.\n", autonSlot);
-        lcdSetText(LCD_PORT, 1, "Loaded auton!");
-        lcdPrint(LCD_PORT,   2, "Slot: %d", autonSlot);
+    } else if(autonSlot == autonLoaded && loadedFlipped == autonFlipped
+            && memcmp(&loadedTransform, &autonPlaybackTransform, sizeof(autonTransform)) == 0) {
+        LOG_INFO("Autonomous %d is already loaded.\n", autonSlot);
+        lcdWriteLine(1, "Loaded auton!");
+        lcdPrintLine(2, "Slot: %d", autonSlot);
         return;
-    } else if (autonSlot < 0) {
-        printf("Invalid autonomous selection");
+    } else if (autonSlot < 0 || !getSlotFilename(filename, autonSlot)) {
+        LOG_WARN("Invalid autonomous selection.\n");
         return;
     }
-    printf("Loading autonomous from slot %d...\n", autonSlot);
-    lcdSetText(LCD_PORT, 1, "Loading auton...");
-    if(autonSlot != MAX_AUTON_SLOTS + 1){
-        lcdPrint(LCD_PORT, 2,   "Slot: %d", autonSlot);
+    LOG_INFO("Loading autonomous from slot %d...\n", autonSlot);
+    lcdWriteLine(1, "Loading auton...");
+    lcdPrintLine(2, "Slot: %d", autonSlot);
+    autonReader reader;
+    const uint8_t* image = NULL;
+    int imageSize;
+    autonFile = NULL;
+#ifdef AUTON_CACHE
+    image = findCachedAuton(autonSlot, &imageSize);
+    if (image != NULL) {
+        LOG_INFO("Loading from the auton cache...\n");
     }
-    if(autonSlot != MAX_AUTON_SLOTS + 1){
-        printf("Not doing programming skills, loading slot %d\n", autonSlot);
-        snprintf(filename, sizeof(filename)/sizeof(char), "a%d", autonSlot);
-    } else {
-        printf("Doing programming skills, loading section 0.\n");
-        snprintf(filename, sizeof(filename)/sizeof(char), "p0");
-    }
-    printf("Loading from file %s...\n",filename);
-    autonFile = fopen(filename, "r");
-    if (autonFile == NULL) {
-        printf("No autonomous was saved in file %s!\n", filename);
-        lcdSetText(LCD_PORT, 1, "No auton saved!");
-        if(autonSlot != MAX_AUTON_SLOTS + 1){
-            printf("Not doing programming skills, no auton in slot %d!\n", autonSlot);
-            lcdSetText(LCD_PORT, 1, "No auton saved!");
-            lcdPrint(LCD_PORT, 2,   "Slot: %d", autonSlot);
-        } else {
-            printf("Doing programming skills, no auton in section 0!\n");
-            lcdSetText(LCD_PORT, 1, "No skills saved!");
+#endif
+    if (image == NULL) {
+        LOG_INFO("Loading from file a%d...\n", autonSlot);
+        autonFile = fopen(filename, "r");
+        if (autonFile == NULL) {
+            LOG_WARN("No autonomous was saved in slot %d!\n", autonSlot);
+            lcdWriteLine(1, "No auton saved!");
+            lcdPrintLine(2, "Slot: %d", autonSlot);
+            return;
         }
-        return;
+#ifdef AUTON_CACHE
+        // Decode from the cached copy when the file fits, so the flash is only read once
+        image = cacheAutonFile(autonSlot, autonFile, &imageSize);
+        if (image != NULL) {
+            fclose(autonFile);
+            autonFile = NULL;
+        }
+#endif
     }
 
-    fseek(autonFile, 0, SEEK_SET);
-    signed char read[5];
-    for (int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-        printf("Loading state %d from file %s...\n", i, filename);
-        for (int j = 0; j < 5; j++) {
-            fseek(autonFile, 5 * i + j, SEEK_SET);
-            fread(read + j, sizeof(char), sizeof(char), autonFile);
-        }
-        states[i].spd = (signed char) read[0];
-        states[i].horizontal = (signed char) read[1];
-        states[i].turn = (signed char) read[2];
-        states[i].sht = (signed char) read[3];
-        states[i].lift = (signed char) read[4];
-        printf("Load State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
-        delay(10);
+    int numStates = (image != NULL) ? openCachedAutonReader(&reader, image, imageSize) : openAutonReader(&reader, autonFile);
+    autonBatteryLevel = reader.header.batteryLevel;
+    autonEventMode = reader.header.version == AUTON_FILE_VERSION_EVENTS;
+    if (numStates >= 0 && autonEventMode) {
+        numStates = numEvents = decodeAutonEvents(&reader, events, AUTON_MAX_EVENTS);
+    } else if (numStates >= 0) {
+        numStates = decodeAutonStates(&reader, states, AUTON_NUM_STATES);
     }
-    fclose(autonFile);
-    printf("Completed loading autonomous from file %s.\n", filename);
-    lcdSetText(LCD_PORT, 1, "Loaded auton!");
-    if(autonSlot != MAX_AUTON_SLOTS + 1){
-        printf("Not doing programming skills, loaded from slot %d.\n", autonSlot);
-        lcdPrint(LCD_PORT, 2, "Slot: %d", autonSlot);
-    } else {
-        printf("Doing programming skills, loaded from section %d.\n", progSkills);
-        lcdSetText(LCD_PORT, 2, "Skills Section: 1");
+    if (autonFile != NULL) {
+        fclose(autonFile);
+    }
+    if (numStates < 0) {
+        numEvents = 0;
+        LOG_ERROR("Autonomous file for slot %d is corrupt!\n", autonSlot);
+        lcdWriteLine(1, "Corrupt auton!");
+#ifdef AUTON_CACHE
+        invalidateCachedAuton(autonSlot);
+#endif
+        autonLoaded = 0;
+        return;
     }
+#ifdef AUTON_SENSORS
+    sensorTraceLoaded = false;
+    if (!autonEventMode) {
+        loadSensorTrace(autonSlot);
+    }
+#endif
+    transformLoadedAuton();
+    LOG_INFO("Completed loading autonomous from slot %d.\n", autonSlot);
+    lcdWriteLine(1, "Loaded auton!");
+    lcdPrintLine(2, "Slot: %d", autonSlot);
     autonLoaded = autonSlot;
+    rememberBootChoice(autonSlot);
+}
+
+#ifdef AUTON_BATTERY_COMPENSATION
+/**
+ * Battery voltage in millivolts during playback, averaged over about AUTON_BATTERY_FILTER ticks and scaled by AUTON_BATTERY_FILTER.
+ */
+static int playbackBatteryFiltered;
+
+/**
+ * Starts averaging the battery voltage for a new playback.
+ */
+static void resetBatteryCompensation() {
+    playbackBatteryFiltered = powerLevelMain() * AUTON_BATTERY_FILTER;
+}
+
+/**
+ * Scales the motor outputs of the current tick by the ratio of the recorded to the current battery voltage.
+ * Compensation is skipped if either voltage is unknown or below AUTON_BATTERY_MIN_LEVEL.
+ *
+ * @param recordedLevel the average battery voltage in millivolts at which the playing routine was recorded, or 0 if it is not known
+ */
+static void compensateBattery(int recordedLevel) {
+    playbackBatteryFiltered += (int) powerLevelMain() - playbackBatteryFiltered / AUTON_BATTERY_FILTER;
+    int currentLevel = playbackBatteryFiltered / AUTON_BATTERY_FILTER;
+    if (recordedLevel < AUTON_BATTERY_MIN_LEVEL || currentLevel < AUTON_BATTERY_MIN_LEVEL) {
+        motorOutputSetScale(MOTOR_OUTPUT_SCALE_ONE);
+        return;
+    }
+    int scale = recordedLevel * MOTOR_OUTPUT_SCALE_ONE / currentLevel;
+    motorOutputSetScale(CLAMP(scale, AUTON_BATTERY_MIN_GAIN * MOTOR_OUTPUT_SCALE_ONE / 100, AUTON_BATTERY_MAX_GAIN * MOTOR_OUTPUT_SCALE_ONE / 100));
+}
+#endif
+
+/**
+ * Raises the drive and pincer power of a state for playback faster than it was recorded.
+ *
+ * @param state the state to speed up
+ * @param speed the playback speed in percent of the recorded speed
+ *
+ * @return the state to play back
+ */
+static joyState speedUpState(joyState state, int speed) {
+    state.spd = CLAMP(state.spd * speed / 100, -127, 127);
+    state.horizontal = CLAMP(state.horizontal * speed / 100, -127, 127);
+    state.turn = CLAMP(state.turn * speed / 100, -127, 127);
+    state.sht = CLAMP(state.sht * speed / 100, -127, 127);
+    return state;
+}
+
+/**
+ * Limits a playback speed to what the peak command of a stretch of states leaves room for.
+ * speedUpState() can only clip a command that would need more than full power, and the mixed wheel power of a
+ * clipped drive command is scaled down, so a faster playback of it would fall behind the recorded path.
+ *
+ * @param buf the states
+ * @param numStates the number of states in buf
+ * @param speed the requested playback speed in percent of the recorded speed
+ *
+ * @return the speed to play back at, from 100 to speed
+ */
+static int limitPlaybackSpeed(const joyState* buf, int numStates, int speed) {
+    int peak = 0;
+    for (int i = 0; i < numStates; i++) {
+        peak = MAX(peak, abs(buf[i].spd) + abs(buf[i].horizontal) + abs(buf[i].turn));
+        peak = MAX(peak, abs(buf[i].sht));
+    }
+    return (peak == 0) ? speed : CLAMP(127 * 100 / peak, 100, speed);
+}
+
+/**
+ * Gets the state at a position between two recorded states for playback.
+ * The drive axes are interpolated linearly between the neighbouring states; the pincer and lift hold the earlier state,
+ * since they only take a few fixed values.
+ *
+ * @param buf the recorded states (AUTON_NUM_STATES long)
+ * @param position the position in buf in 1/AUTON_POSITION_ONE of a state
+ * @param speed the playback speed in percent of the recorded speed
+ *
+ * @return the state to play back
+ */
+static joyState interpolateState(const joyState* buf, int position, int speed) {
+    int index = position / AUTON_POSITION_ONE;
+    int fraction = position % AUTON_POSITION_ONE;
+    const joyState* from = &buf[index];
+    const joyState* to = &buf[MIN(index + 1, AUTON_NUM_STATES - 1)];
+    joyState state = *from;
+    state.spd += (to->spd - from->spd) * fraction / AUTON_POSITION_ONE;
+    state.horizontal += (to->horizontal - from->horizontal) * fraction / AUTON_POSITION_ONE;
+    state.turn += (to->turn - from->turn) * fraction / AUTON_POSITION_ONE;
+    return speedUpState(state, speed);
+}
+
+/**
+ * Publishes the command of a playback tick, and the driver's command too when the arbitration policy lets the driver
+ * take part. Must be called after driverInputPoll().
+ *
+ * @param state the command to play back this tick
+ */
+static void publishPlaybackCommand(const joyState* state) {
+    commandPublish(COMMAND_SOURCE_PLAYBACK, state);
+    // The joysticks belong to the field during a match's autonomous period
+    if (commandGetPolicy() != COMMAND_POLICY_PLAYBACK && !isOnline()) {
+        recordJoyInfo();
+    }
 }
 
 /**
- * Replays autonomous based on loaded values in states array.
+ * Replays an event recording from the events array at AUTON_EVENT_PLAYBACK_FREQ.
+ * Each tick applies the most recent event whose time has passed, so the command stream is reconstructed at the playback rate regardless of the rate it was sampled at.
  *
- * @param flipped -1 if the autonomous should be flipped over the y axis (for the opposite starting tile), 1 otherwise
+ * @param speed the playback speed in percent of the recorded speed
+ */
+static void playbackAutonEvents(int speed) {
+    int next = 0;
+    int limit = speed;
+    for (int i = 0; i < numEvents; i++) {
+        limit = MIN(limit, limitPlaybackSpeed(&events[i].state, 1, speed));
+    }
+    if (limit != speed) {
+        LOG_INFO("Playing back at %d%%, the most the routine leaves room for.\n", limit);
+        speed = limit;
+    }
+    bool cancelled = false;
+    unsigned long start = micros();
+    unsigned long end = events[numEvents - 1].time;
+    // Time into the recording, which runs ahead of the playback time when playing back faster
+    unsigned long elapsed = 0;
+#ifdef AUTON_BATTERY_COMPENSATION
+    resetBatteryCompensation();
+#endif
+    deadlineMonitor monitor;
+    deadlineStart(&monitor, "Event playback", 1000 / AUTON_EVENT_PLAYBACK_FREQ, true);
+    joyState state = {0, 0, 0, 0, 0};
+    while (elapsed < end && !cancelled) {
+        unsigned long tickStart = profileBegin();
+        while (next < numEvents && events[next].time <= elapsed) {
+            state = speedUpState(events[next].state, speed);
+            LOG_DEBUG("Playback Event at %d ms, Speed: %d %d %d %d %d\n", events[next].time, state.spd, state.horizontal, state.turn, state.sht, state.lift);
+            next++;
+        }
+        driverInputPoll();
+        if (driverHeld(DRIVER_CANCEL) && !isOnline()) {
+            LOG_WARN("Playback manually cancelled.\n");
+            lcdWriteLine(1, "Cancelled playback.");
+            lcdWriteLine(2, "");
+            cancelled = true;
+        }
+        publishPlaybackCommand(&state);
+#ifdef AUTON_BATTERY_COMPENSATION
+        compensateBattery(autonBatteryLevel);
+#endif
+        moveRobot(monitor.timer.period);
+        profileEnd(PROFILE_PLAYBACK, tickStart);
+        deadlineWait(&monitor);
+        elapsed = (micros() - start) / 1000 * speed / 100;
+    }
+    commandWithdraw(COMMAND_SOURCE_PLAYBACK);
+    motorOutputStopAll();
+    deadlineReport(&monitor);
+    LOG_INFO("Completed playback.\n");
+    lcdWriteLine(1, "Played back!");
+    lcdWriteLine(2, "");
+    delay(1000);
+}
+
+/**
+ * Replays autonomous based on loaded values in states array at autonPlaybackSpeed.
+ * Mirroring and the playback transform have already been applied by loadAuton().
+ * Faster playback runs the control loop at AUTON_FAST_PLAYBACK_FREQ and interpolates between the recorded states.
  */
-void playbackAuton(int flipped) { //must load autonomous first!
+void playbackAuton() { //must load autonomous first!
     if(autonLoaded == 0) {
-        printf("autonLoaded = 0, doing nothing.\n");
+        LOG_INFO("autonLoaded = 0, doing nothing.\n");
         return;
     }
-    printf("Beginning playback...\n");
-    lcdSetText(LCD_PORT, 1, "Playing back...");
-    lcdSetText(LCD_PORT, 2, "");
+    LOG_INFO("Beginning playback...\n");
+    lcdWriteLine(1, "Playing back...");
+    lcdWriteLine(2, "");
     lcdSetBacklight(LCD_PORT, true);
-    int file = 0;
-    do{
-        FILE* nextFile = NULL;
-        lcdPrint(LCD_PORT, 2, "File: %d", file+1);
-        char filename[AUTON_FILENAME_MAX_LENGTH];
-        if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
-            printf("Next section: %d\n", file+1);
-            snprintf(filename, sizeof(filename)/sizeof(char), "p%d", file+1);
-            nextFile = fopen(filename, "r");
-        }
-        for(int i = 0; i < AUTON_TIME * JOY_POLL_FREQ; i++) {
-            spd = states[i].spd;
-            horizontal = states[i].horizontal;
-            turn = states[i].turn;
-            sht = states[i].sht;
-            lift = states[i].lift;
-            printf("Playback State: %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
-            if (joystickGetDigital(1, 7, JOY_UP) && !isOnline()) {
-                printf("Playback manually cancelled.\n");
-                lcdSetText(LCD_PORT, 1, "Cancelled playback.");
-                lcdSetText(LCD_PORT, 2, "");
-                i = AUTON_TIME * JOY_POLL_FREQ;
-                file = PROGSKILL_TIME/AUTON_TIME;
+    int speed = CLAMP(autonPlaybackSpeed, 100, AUTON_MAX_PLAYBACK_SPEED);
+    if (speed != 100) {
+        LOG_INFO("Playing back at %d%% of the recorded speed.\n", speed);
+    }
+    if (autonEventMode) {
+        playbackAutonEvents(speed);
+        return;
+    }
+
+    bool isProgSkills = autonLoaded == MAX_AUTON_SLOTS + 1;
+    int totalStates = isProgSkills ? skillsStates : AUTON_NUM_STATES;
+    int numChunks = (totalStates + AUTON_CHUNK_STATES - 1) / AUTON_CHUNK_STATES;
+    int startState = CLAMP(autonPlaybackStart * JOY_POLL_FREQ / 1000, 0, totalStates - 1);
+    int chunk = startState / AUTON_CHUNK_STATES;
+    joyState* current = states;
+    joyState* next = chunkStates;
+    int statesChunk = 0;
+    bool loadPending = false;
+    if (startState != 0) {
+        LOG_INFO("Starting playback %d ms into the routine.\n", startState * 1000 / JOY_POLL_FREQ);
+    }
+    if (chunk != 0) {
+        // Seeking only needs the chunk holding the start, which the index locates without reading the ones before it
+        requestChunk(next, chunk);
+        semaphoreTake(chunkReady, -1);
+        current = chunkStates;
+        next = states;
+    }
+    if (chunk + 1 < numChunks) {
+        requestChunk(next, chunk + 1);
+        loadPending = true;
+        if (next == states) {
+            statesChunk = chunk + 1;
+        }
+    }
+
+#ifdef AUTON_SENSORS
+    bool closedLoop = sensorTraceLoaded && !isProgSkills && startState == 0 && driveSensorsPresent();
+    if (closedLoop) {
+        LOG_INFO("Correcting playback with the recorded sensor trace.\n");
+        resetDriveSensors();
+    }
+#endif
+
+    // Recorded speed keeps the recorded rate, so playback reproduces the recording tick for tick
+    int frequency = (speed == 100) ? JOY_POLL_FREQ : AUTON_FAST_PLAYBACK_FREQ;
+
+    bool cancelled = false;
+#ifdef AUTON_BATTERY_COMPENSATION
+    resetBatteryCompensation();
+#endif
+    // Late ticks are caught up, so playback stays in step with the recording
+    deadlineMonitor monitor;
+    deadlineStart(&monitor, "Playback", 1000 / frequency, true);
+    int position = (startState % AUTON_CHUNK_STATES) * AUTON_POSITION_ONE;
+    for (; chunk < numChunks && !cancelled; chunk++) {
+        if (isProgSkills) {
+            lcdPrintLine(2, "Part: %d", chunk + 1);
+        }
+        int chunkLength = MIN(AUTON_CHUNK_STATES, totalStates - chunk * AUTON_CHUNK_STATES);
+        int chunkSpeed = limitPlaybackSpeed(current, chunkLength, speed);
+        if (chunkSpeed != speed) {
+            LOG_INFO("Playing chunk %d back at %d%%, the most it leaves room for.\n", chunk + 1, chunkSpeed);
+        }
+        int step = chunkSpeed * JOY_POLL_FREQ * AUTON_POSITION_ONE / (100 * frequency);
+        for (; position < chunkLength * AUTON_POSITION_ONE && !cancelled; position += step) {
+            unsigned long tickStart = profileBegin();
+            joyState state = interpolateState(current, position, chunkSpeed);
+#ifdef AUTON_SENSORS
+            // No command is clipped at this speed, so the faster drive follows the recorded path and the trace of the
+            // recorded state still applies
+            if (closedLoop) {
+                applySensorCorrection(&state, position / AUTON_POSITION_ONE);
             }
-            moveRobot();
-            if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
-                printf("Loading state %d from file %s...\n", i, filename);
-
-                char read[5] = {0, 0, 0, 0, 0};
-                for (int j = 0; j < 5; j++) {
-                    fseek(nextFile, 5 * i + j, SEEK_SET);
-                    fread(read + j, sizeof(char), sizeof(char), nextFile);
-                }
-                states[i].spd = (signed char) read[0];
-                states[i].horizontal = (signed char) read[1];
-                states[i].turn = (signed char) read[2];
-                states[i].sht = (signed char) read[3];
-                states[i].lift = (signed char) read[4];
-                printf("Load State %d, Speed: %d %d %d %d %d\n", i, states[i].spd, states[i].horizontal, states[i].turn, states[i].sht, states[i].lift);
+#endif
+            LOG_DEBUG("Playback State: %d, Speed: %d %d %d %d %d\n", chunk * AUTON_CHUNK_STATES + position / AUTON_POSITION_ONE, state.spd, state.horizontal, state.turn, state.sht, state.lift);
+            driverInputPoll();
+            if (driverHeld(DRIVER_CANCEL) && !isOnline()) {
+                LOG_WARN("Playback manually cancelled.\n");
+                lcdWriteLine(1, "Cancelled playback.");
+                lcdWriteLine(2, "");
+                cancelled = true;
+            }
+            publishPlaybackCommand(&state);
+#ifdef AUTON_BATTERY_COMPENSATION
+            compensateBattery(autonBatteryLevel);
+#endif
+            moveRobot(monitor.timer.period);
+            profileEnd(PROFILE_PLAYBACK, tickStart);
+            deadlineWait(&monitor);
+        }
+        // The step overshot the end of the chunk by a fraction of a state, which the next chunk starts from
+        position -= chunkLength * AUTON_POSITION_ONE;
+        if (cancelled || chunk == numChunks - 1) {
+            break;
+        }
+
+        // The next chunk was loaded while this one played, so this normally returns immediately
+        LOG_INFO("Finished with chunk %d, swapping to chunk %d.\n", chunk + 1, chunk + 2);
+        semaphoreTake(chunkReady, -1);
+        loadPending = false;
+        joyState* played = current;
+        current = next;
+        next = played;
+        if (next == states) {
+            statesChunk = chunk;
+        }
+
+        // Load the chunk after the next one into the buffer that just finished playing
+        if (chunk + 2 < numChunks) {
+            requestChunk(next, chunk + 2);
+            loadPending = true;
+            if (next == states) {
+                statesChunk = chunk + 2;
             }
-            delay(1000 / JOY_POLL_FREQ);
-        }
-        if(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME - 1){
-            printf("Finished with section %d, closing file.\n", file+1);
-            fclose(nextFile);
-        }
-        file++;
-    } while(autonLoaded == MAX_AUTON_SLOTS + 1 && file < PROGSKILL_TIME/AUTON_TIME);
-    motorStopAll();
-    printf("Completed playback.\n");
-    lcdSetText(LCD_PORT, 1, "Played back!");
-    lcdSetText(LCD_PORT, 2, "");
+        }
+    }
+    commandWithdraw(COMMAND_SOURCE_PLAYBACK);
+    motorOutputStopAll();
+
+    if (loadPending) {
+        semaphoreTake(chunkReady, -1);
+    }
+    // Put the first chunk back into states so the routine plays from the start the next time
+    if (statesChunk != 0) {
+        requestChunk(states, 0);
+        semaphoreTake(chunkReady, -1);
+    }
+    deadlineReport(&monitor);
+    LOG_INFO("Completed playback.\n");
+    lcdWriteLine(1, "Played back!");
+    lcdWriteLine(2, "");
     delay(1000);
 }
@@ -0,0 +1,174 @@
+/** @file deadline.c
+ * @brief File for the control loop deadline watchdog
+ *
+ * The watched loops all run on the task that drives the robot, one at a time, so the shed level and the event log
+ * have a single writer. Other tasks only read the level, and read the event log to print it, where a half written
+ * entry only affects the printed text.
+ */
+
+#include "main.h"
+
+/**
+ * The names printed for each shed level
+ */
+static const char* const shedNames[DEADLINE_NUM_LEVELS] = { "nothing", "LCD", "logging", "telemetry" };
+
+/**
+ * The names printed for each kind of event
+ */
+static const char* const eventNames[] = { "overrun", "shed", "restored" };
+
+/**
+ * What is shed, as of the last watched tick
+ */
+static volatile int shedLevel = DEADLINE_SHED_NONE;
+
+/**
+ * The time in milliseconds of the last watched tick
+ */
+static volatile unsigned long lastTick = 0;
+
+/**
+ * The event log
+ */
+static deadlineEvent eventLog[DEADLINE_NUM_EVENTS];
+
+/**
+ * The number of events that have been logged, including those that were overwritten
+ */
+static volatile unsigned int numLogged = 0;
+
+/**
+ * Adds an entry to the event log
+ *
+ * @param monitor the monitor of the loop whose tick caused the event
+ * @param type the DEADLINE_EVENT_* kind of the event
+ * @param work the time in microseconds that the work of the tick took
+ */
+static void logEvent(const deadlineMonitor* monitor, deadlineEventType type, unsigned long work) {
+	deadlineEvent* event = &eventLog[numLogged % DEADLINE_NUM_EVENTS];
+	event->time = millis();
+	event->loop = monitor->name;
+	event->work = work;
+	event->type = type;
+	event->level = shedLevel;
+	__sync_synchronize();
+	numLogged++;
+}
+
+/**
+ * Starts watching a fixed-period loop, releasing the first tick immediately
+ *
+ * @param monitor the monitor to start
+ * @param name the name of the loop, which must stay valid while the event log is kept
+ * @param period the period of the loop in milliseconds
+ * @param catchUp true to release missed ticks late, false to skip them
+ */
+void deadlineStart(deadlineMonitor* monitor, const char* name, unsigned long period, bool catchUp) {
+	loopTimerStart(&monitor->timer, period);
+	monitor->name = name;
+	monitor->catchUp = catchUp;
+	monitor->released = micros();
+	monitor->maxWork = 0;
+	monitor->nearTicks = 0;
+	monitor->quietTicks = 0;
+	monitor->overran = false;
+}
+
+/**
+ * Ends the work of the current tick, updating what is shed from how long it took and sending its telemetry, and
+ * waits for the next tick
+ *
+ * @param monitor the monitor of the loop
+ */
+void deadlineWait(deadlineMonitor* monitor) {
+	unsigned long work = micros() - monitor->released;
+	unsigned long budget = monitor->timer.period * 1000;
+	monitor->maxWork = MAX(monitor->maxWork, work);
+	if (millis() - lastTick >= DEADLINE_STALE_TIME && shedLevel != DEADLINE_SHED_NONE) {
+		// Whatever was shed belonged to a loop that has since stopped
+		shedLevel = DEADLINE_SHED_NONE;
+		logEvent(monitor, DEADLINE_EVENT_RESTORE, work);
+	}
+	lastTick = millis();
+
+	if (work * 100 >= budget * DEADLINE_NEAR_PERCENT) {
+		monitor->quietTicks = 0;
+		if (++monitor->nearTicks >= DEADLINE_SHED_TICKS && shedLevel < DEADLINE_NUM_LEVELS - 1) {
+			monitor->nearTicks = 0;
+			shedLevel++;
+			LOG_WARN("Deadline: %d us of work in a %d ms tick, shedding level %d.\n", (int) work,
+					(int) monitor->timer.period, shedLevel);
+			logEvent(monitor, DEADLINE_EVENT_SHED, work);
+		}
+	} else if (work * 100 < budget * DEADLINE_QUIET_PERCENT) {
+		monitor->nearTicks = 0;
+		if (++monitor->quietTicks >= DEADLINE_RESTORE_TICKS && shedLevel > DEADLINE_SHED_NONE) {
+			monitor->quietTicks = 0;
+			shedLevel--;
+			logEvent(monitor, DEADLINE_EVENT_RESTORE, work);
+			LOG_INFO("Deadline: back within budget, shedding level %d.\n", shedLevel);
+		}
+	}
+
+	telemetryRecord(monitor, work);
+
+	if (!monitor->catchUp) {
+		loopTimerSkipMissed(&monitor->timer);
+	}
+	unsigned int overruns = monitor->timer.overruns;
+	loopTimerWait(&monitor->timer);
+	bool overran = monitor->timer.overruns != overruns;
+	// Only the first of a run of late ticks is logged, so a long stall does not push everything else out of the log
+	if (overran && !monitor->overran) {
+		LOG_WARN("Deadline: tick of %d ms overran with %d us of work.\n", (int) monitor->timer.period, (int) work);
+		logEvent(monitor, DEADLINE_EVENT_OVERRUN, work);
+	}
+	monitor->overran = overran;
+	monitor->released = micros();
+}
+
+/**
+ * Gets whether a kind of work is being shed
+ *
+ * @param item the DEADLINE_SHED_* kind of work
+ *
+ * @return true if the work should be skipped
+ */
+bool deadlineShedding(deadlineShed item) {
+	return shedLevel >= (int) item && millis() - lastTick < DEADLINE_STALE_TIME;
+}
+
+/**
+ * Gets what is being shed
+ *
+ * @return the DEADLINE_SHED_* level, below which everything is shed as well
+ */
+deadlineShed deadlineShedLevel() {
+	return deadlineShedding(DEADLINE_SHED_LCD) ? shedLevel : DEADLINE_SHED_NONE;
+}
+
+/**
+ * Prints the timing and deadline statistics of a watched loop over the debug terminal
+ *
+ * @param monitor the monitor of the loop
+ */
+void deadlineReport(const deadlineMonitor* monitor) {
+	loopTimerReport(&monitor->timer, monitor->name);
+	printf("%s: %u deadlines missed, %u ticks skipped, work max %lu us of %lu us\n", monitor->name,
+			monitor->timer.overruns, monitor->timer.skipped, monitor->maxWork, monitor->timer.period * 1000);
+}
+
+/**
+ * Prints the event log over the debug terminal, oldest event first
+ */
+void deadlineReportEvents() {
+	unsigned int count = numLogged;
+	unsigned int first = (count > DEADLINE_NUM_EVENTS) ? count - DEADLINE_NUM_EVENTS : 0;
+	printf("Deadline events: %u, shedding %s\n", count, shedNames[deadlineShedLevel()]);
+	for (unsigned int i = first; i < count; i++) {
+		const deadlineEvent* event = &eventLog[i % DEADLINE_NUM_EVENTS];
+		printf("[%lu] %s: %s after %lu us of work, shedding %s\n", event->time, event->loop, eventNames[event->type],
+				event->work, shedNames[event->level]);
+	}
+}
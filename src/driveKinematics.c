@@ -0,0 +1,144 @@
+/** @file driveKinematics.c
+ * @brief File for the holonomic drive mixer
+ *
+ * Each wheel of an X-drive is the sum of the three axes, so full forward with full turn asks the outside wheels for
+ * twice full power. Scaling every wheel by the same factor keeps the ratio between the wheels, which is what sets the
+ * direction the robot moves in, and still gives the fastest wheel full power.
+ */
+
+#include "main.h"
+
+/**
+ * Sine of 0 to 90 degrees with DRIVE_TRIG_ONE as 1
+ */
+static const short sineTable[91] = {
+	0, 18, 36, 54, 71, 89, 107, 125, 143, 160, 178, 195, 213,
+	230, 248, 265, 282, 299, 316, 333, 350, 367, 384, 400, 416, 433,
+	449, 465, 481, 496, 512, 527, 543, 558, 573, 587, 602, 616, 630,
+	644, 658, 672, 685, 698, 711, 724, 737, 749, 761, 773, 784, 796,
+	807, 818, 828, 839, 849, 859, 868, 878, 887, 896, 904, 912, 920,
+	928, 935, 943, 949, 956, 962, 968, 974, 979, 984, 989, 994, 998,
+	1002, 1005, 1008, 1011, 1014, 1016, 1018, 1020, 1022, 1023, 1023, 1024, 1024
+};
+
+/**
+ * Whether the driver is driving field centric
+ */
+static bool fieldCentric = false;
+
+/**
+ * The gyro heading that counts as the field's forward direction
+ */
+static int headingOrigin = 0;
+
+/**
+ * Computes the sine of an angle
+ *
+ * @param degrees the angle in degrees, of any size
+ *
+ * @return the sine with DRIVE_TRIG_ONE as 1
+ */
+static int fixedSine(int degrees) {
+	degrees %= 360;
+	if (degrees < 0) {
+		degrees += 360;
+	}
+	if (degrees <= 90) {
+		return sineTable[degrees];
+	} else if (degrees <= 180) {
+		return sineTable[180 - degrees];
+	} else if (degrees <= 270) {
+		return -sineTable[degrees - 180];
+	}
+	return -sineTable[360 - degrees];
+}
+
+/**
+ * Scales a set of powers together so that none is beyond full power
+ *
+ * @param powers the powers to scale
+ * @param count the number of powers
+ */
+static void desaturate(int* powers, int count) {
+	int largest = 0;
+	for (int i = 0; i < count; i++) {
+		largest = MAX(largest, ABS(powers[i]));
+	}
+	if (largest > MOTOR_SPEED) {
+		for (int i = 0; i < count; i++) {
+			powers[i] = powers[i] * MOTOR_SPEED / largest;
+		}
+	}
+}
+
+/**
+ * Sets the drive motors for the X-drive, scaling all four wheels together if any would need more than full power
+ *
+ * @param forward the forward power
+ * @param horizontal the power to the right
+ * @param turn the clockwise turning power
+ */
+void setDriveMotors(int forward, int horizontal, int turn) {
+	int wheels[4] = {
+		-(forward + horizontal + turn),
+		-(-forward + horizontal + turn),
+		forward - horizontal + turn,
+		-forward - horizontal + turn
+	};
+	desaturate(wheels, 4);
+	motorOutputSet(FRONT_LEFT_MOTOR, wheels[0]);
+	motorOutputSet(FRONT_RIGHT_MOTOR, wheels[1]);
+	motorOutputSet(BACK_LEFT_MOTOR, wheels[2]);
+	motorOutputSet(BACK_RIGHT_MOTOR, wheels[3]);
+}
+
+/**
+ * Rotates a stick direction given relative to the field into the direction relative to the robot, using the gyro
+ * heading since resetDriveHeading(). The result is scaled down if either axis would need more than full power.
+ *
+ * @param forward the forward stick axis; replaced with the forward power relative to the robot
+ * @param horizontal the horizontal stick axis; replaced with the horizontal power relative to the robot
+ */
+void driveFieldToRobot(int* forward, int* horizontal) {
+	sensorSnapshot snapshot;
+	readSensors(&snapshot);
+	// The gyro heading is clockwise, so the stick direction is turned counterclockwise by it
+	int heading = snapshot.gyro - headingOrigin;
+	int sine = fixedSine(heading);
+	int cosine = fixedSine(heading + 90);
+	int axes[2] = {
+		(*forward * cosine + *horizontal * sine) / DRIVE_TRIG_ONE,
+		(*horizontal * cosine - *forward * sine) / DRIVE_TRIG_ONE
+	};
+	desaturate(axes, 2);
+	*forward = axes[0];
+	*horizontal = axes[1];
+}
+
+/**
+ * Makes the current heading of the robot the field's forward direction; until this is called, it is the heading the
+ * robot had when the sensors were initialized
+ */
+void resetDriveHeading() {
+	sensorSnapshot snapshot;
+	readSensors(&snapshot);
+	headingOrigin = snapshot.gyro;
+}
+
+/**
+ * Turns field centric driving on or off; it stays off if there is no gyro
+ *
+ * @param enabled true to drive field centric, false to drive relative to the robot
+ */
+void driveSetFieldCentric(bool enabled) {
+	fieldCentric = enabled && sensorGyroPresent();
+}
+
+/**
+ * Gets whether the driver is driving field centric
+ *
+ * @return true if the sticks are relative to the field
+ */
+bool driveIsFieldCentric() {
+	return fieldCentric;
+}
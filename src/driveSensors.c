@@ -0,0 +1,69 @@
+/** @file driveSensors.c
+ * @brief File for drive sensor functions
+ *
+ * Converts the four drive wheel encoders into forward, horizontal and turning positions by inverting the mixing done
+ * in setDriveMotors(). This assumes that each IME counts up when its motor is given positive power. The counts come
+ * from the snapshots of the sensor task, and positions are measured from the snapshot taken at the last reset instead
+ * of resetting the IMEs, so that the drive sensors are never read or written outside the sensor task.
+ */
+
+#include "main.h"
+
+/**
+ * Whether all four drive IMEs were found
+ */
+static bool imesPresent = false;
+
+/**
+ * The snapshot taken when the drive position was last reset, which positions are measured from
+ */
+static sensorSnapshot origin;
+
+/**
+ * Initializes the drive IMEs and gyro. Must be called from initialize() after initSensors().
+ */
+void initDriveSensors() {
+	imesPresent = sensorImeCount() >= 4;
+	resetDriveSensors();
+}
+
+/**
+ * Gets whether all four drive IMEs were found when the sensors were initialized
+ *
+ * @return true if the drive position can be measured, false otherwise
+ */
+bool driveSensorsPresent() {
+	return imesPresent;
+}
+
+/**
+ * Resets the drive position to zero
+ */
+void resetDriveSensors() {
+	readSensors(&origin);
+}
+
+/**
+ * Reads the position of the drive since it was last reset
+ *
+ * @param pose filled in with the position of the drive
+ */
+void readDriveSensors(drivePose* pose) {
+	sensorSnapshot snapshot;
+	readSensors(&snapshot);
+	int frontLeft = 0, frontRight = 0, backLeft = 0, backRight = 0;
+	if (imesPresent) {
+		frontLeft = snapshot.imes[FRONT_LEFT_IME] - origin.imes[FRONT_LEFT_IME];
+		frontRight = snapshot.imes[FRONT_RIGHT_IME] - origin.imes[FRONT_RIGHT_IME];
+		backLeft = snapshot.imes[BACK_LEFT_IME] - origin.imes[BACK_LEFT_IME];
+		backRight = snapshot.imes[BACK_RIGHT_IME] - origin.imes[BACK_RIGHT_IME];
+	}
+
+	// Inverse of the mixing in setDriveMotors()
+	pose->forward = (-frontLeft + frontRight + backLeft - backRight) / 4;
+	pose->horizontal = (-frontLeft - frontRight - backLeft - backRight) / 4;
+	pose->turn = (-frontLeft - frontRight + backLeft + backRight) / 4;
+	if (sensorGyroPresent()) {
+		pose->turn = snapshot.gyro - origin.gyro;
+	}
+}
@@ -0,0 +1,170 @@
+/** @file driverInput.c
+ * @brief File for the once per tick snapshot of the joysticks
+ *
+ * Only the control task polls the joysticks and reads the snapshot, so neither needs locking.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * The buttons of each action in the default layout
+ */
+#define DEFAULT_BINDINGS { \
+	[DRIVER_PINCER_FORWARD] = DRIVER_BOTH(5, JOY_UP), \
+	[DRIVER_PINCER_BACK] = DRIVER_BOTH(5, JOY_DOWN), \
+	[DRIVER_PINCER_FORWARD_SLOW] = DRIVER_BOTH(8, JOY_UP), \
+	[DRIVER_PINCER_BACK_SLOW] = DRIVER_BOTH(8, JOY_DOWN), \
+	[DRIVER_LIFT_UP] = DRIVER_BOTH(6, JOY_UP), \
+	[DRIVER_LIFT_DOWN] = DRIVER_BOTH(6, JOY_DOWN), \
+	[DRIVER_LIFT_PRESET_UP] = DRIVER_BOTH(8, JOY_RIGHT), \
+	[DRIVER_LIFT_PRESET_DOWN] = DRIVER_BOTH(8, JOY_LEFT), \
+	[DRIVER_RECORD] = DRIVER_BUTTON(1, 7, JOY_RIGHT), \
+	[DRIVER_PLAYBACK] = DRIVER_BUTTON(1, 7, JOY_LEFT), \
+	[DRIVER_CANCEL] = DRIVER_BUTTON(1, 7, JOY_UP) \
+}
+
+/**
+ * The default layout, kept to go back to after the bindings are changed
+ */
+static const unsigned long defaultBindings[DRIVER_NUM_ACTIONS] = DEFAULT_BINDINGS;
+
+/**
+ * The buttons each action is bound to; recording and playback are only bound on the main driver's joystick
+ */
+static unsigned long bindings[DRIVER_NUM_ACTIONS] = DEFAULT_BINDINGS;
+
+/**
+ * The buttons that some action is bound to, which are the only ones read
+ */
+static unsigned long boundButtons = 0;
+
+/**
+ * The latest snapshot
+ */
+static driverInput snapshot;
+
+/**
+ * Works out which buttons need to be read after the bindings change
+ */
+static void updateBoundButtons() {
+	boundButtons = 0;
+	for (int i = 0; i < DRIVER_NUM_ACTIONS; i++) {
+		boundButtons |= bindings[i];
+	}
+}
+
+/**
+ * Sets every action back to the buttons of the default layout
+ */
+void driverResetBindings() {
+	memcpy(bindings, defaultBindings, sizeof(bindings));
+	updateBoundButtons();
+}
+
+/**
+ * Binds an action to a new set of buttons, replacing the buttons it was bound to
+ *
+ * @param action the action to bind
+ * @param buttons the DRIVER_BUTTON() bits of the buttons, or 0 to leave the action unbound
+ */
+void driverBind(driverAction action, unsigned long buttons) {
+	if (action < DRIVER_NUM_ACTIONS) {
+		bindings[action] = buttons;
+		updateBoundButtons();
+	}
+}
+
+/**
+ * Gets the buttons an action is bound to
+ *
+ * @param action the action
+ *
+ * @return the DRIVER_BUTTON() bits of the buttons
+ */
+unsigned long driverBinding(driverAction action) {
+	return (action < DRIVER_NUM_ACTIONS) ? bindings[action] : 0;
+}
+
+/**
+ * Reads both joysticks into the snapshot, moving the last snapshot's buttons to previous
+ */
+void driverInputPoll() {
+	if (boundButtons == 0) {
+		updateBoundButtons();
+	}
+	unsigned long held = 0;
+	// Visit the bound buttons only, lowest bit first
+	for (unsigned long remaining = boundButtons; remaining != 0; remaining &= remaining - 1) {
+		int index = __builtin_ctzl(remaining);
+		if (joystickGetDigital(index / 16 + 1, (index % 16) / 4 + 5, 1 << (index % 4))) {
+			held |= 1UL << index;
+		}
+	}
+	for (unsigned char joystick = 1; joystick <= 2; joystick++) {
+		for (unsigned char axis = 1; axis <= 4; axis++) {
+			snapshot.analog[joystick - 1][axis - 1] = CLAMP(joystickGetAnalog(joystick, axis), -128, 127);
+		}
+	}
+	snapshot.previous = snapshot.held;
+	snapshot.held = held;
+}
+
+/**
+ * Gets the snapshot taken by the last driverInputPoll()
+ *
+ * @return the snapshot
+ */
+const driverInput* driverInputSnapshot() {
+	return &snapshot;
+}
+
+/**
+ * Gets a stick axis from the snapshot
+ *
+ * @param joystick the joystick (1 or 2)
+ * @param axis the axis (1 to 4)
+ *
+ * @return the value of the axis from -128 to 127
+ */
+int driverAnalog(unsigned char joystick, unsigned char axis) {
+	if (joystick < 1 || joystick > 2 || axis < 1 || axis > 4) {
+		return 0;
+	}
+	return snapshot.analog[joystick - 1][axis - 1];
+}
+
+/**
+ * Gets whether an action is held in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if any of its buttons is held
+ */
+bool driverHeld(driverAction action) {
+	return (snapshot.held & driverBinding(action)) != 0;
+}
+
+/**
+ * Gets whether an action started in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if any of its buttons is held now and none was held in the previous snapshot
+ */
+bool driverPressed(driverAction action) {
+	unsigned long buttons = driverBinding(action);
+	return (snapshot.held & buttons) != 0 && (snapshot.previous & buttons) == 0;
+}
+
+/**
+ * Gets whether an action ended in the snapshot
+ *
+ * @param action the action
+ *
+ * @return true if none of its buttons is held now and one was held in the previous snapshot
+ */
+bool driverReleased(driverAction action) {
+	unsigned long buttons = driverBinding(action);
+	return (snapshot.held & buttons) == 0 && (snapshot.previous & buttons) != 0;
+}
@@ -21,6 +21,7 @@
  * configure a UART port (usartOpen()) but cannot set up an LCD (lcdInit()).
  */
 void initializeIO() {
+	serialLinkInit();
 }
 
 /*
@@ -37,12 +38,23 @@ void initializeIO() {
  * can be implemented in this task if desired.
  */
 void initialize() {
-	lcdInit(LCD_PORT);
-	lcdClear(LCD_PORT);
+	logInit();
+	motorOutputInit();
+	lcdCacheInit();
 	lcdSetBacklight(LCD_PORT, true);
 	initLCDMenu();
-	lcdSetText(LCD_PORT, 1, "Load from?");
+	initSensors();
+	initDriveSensors();
+	initLiftControl();
 	initAutonRecorder();
+	initTelemetry();
+#ifdef AUTON_FAST_BOOT
+	// autonomous() and the LCD menu wait for the preload, so initialize() does not have to
+	startAutonPreload(getBootAutonSlot());
+#else
+	lcdWriteLine(1, "Load from?");
 	loadAuton(selectAuton(false));
 	delay(500);
+#endif
+	startLCDMenuTask();
 }
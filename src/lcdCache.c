@@ -0,0 +1,84 @@
+/** @file lcdCache.c
+ * @brief File for the cached LCD output and button input layer
+ *
+ * Every LCD write in the program goes through this file so that the shadow copy always matches what is displayed.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * Provided by the PROS library alongside snprintf() but not declared in API.h
+ */
+int vsnprintf(char* buffer, size_t limit, const char* formatString, va_list args);
+
+/**
+ * The text currently displayed on each line of the LCD, padded with spaces
+ */
+static char lcdShadow[2][LCD_MESSAGE_MAX_LENGTH + 1];
+
+/**
+ * Initializes the LCD and clears the shadow copy of its lines
+ */
+void lcdCacheInit() {
+	lcdInit(LCD_PORT);
+	lcdClearLines();
+}
+
+/**
+ * Reads the LCD buttons once and moves the last snapshot to previous
+ *
+ * @param buttons the snapshot to update
+ */
+void lcdPollButtons(lcdButtons* buttons) {
+	buttons->previous = buttons->held;
+	buttons->held = lcdReadButtons(LCD_PORT);
+}
+
+/**
+ * Sets a line of the LCD, only sending it over the UART if it differs from what is already displayed
+ *
+ * @param line the line to set (1 or 2)
+ * @param text the text to display, truncated to LCD_MESSAGE_MAX_LENGTH characters
+ */
+void lcdWriteLine(unsigned char line, const char* text) {
+	if (line < 1 || line > 2) {
+		return;
+	}
+	char padded[LCD_MESSAGE_MAX_LENGTH + 1];
+	int length = strlen(text);
+	length = MIN(length, LCD_MESSAGE_MAX_LENGTH);
+	memcpy(padded, text, length);
+	memset(padded + length, ' ', LCD_MESSAGE_MAX_LENGTH - length);
+	padded[LCD_MESSAGE_MAX_LENGTH] = 0;
+
+	if (memcmp(padded, lcdShadow[line - 1], LCD_MESSAGE_MAX_LENGTH) != 0) {
+		memcpy(lcdShadow[line - 1], padded, LCD_MESSAGE_MAX_LENGTH + 1);
+		lcdSetText(LCD_PORT, line, padded);
+	}
+}
+
+/**
+ * Formats and sets a line of the LCD, only sending it over the UART if it differs from what is already displayed
+ *
+ * @param line the line to set (1 or 2)
+ * @param formatString the printf() format string of the text
+ */
+void lcdPrintLine(unsigned char line, const char* formatString, ...) {
+	char text[LCD_MESSAGE_MAX_LENGTH + 1];
+	va_list args;
+	va_start(args, formatString);
+	vsnprintf(text, sizeof(text), formatString, args);
+	va_end(args);
+	lcdWriteLine(line, text);
+}
+
+/**
+ * Clears both lines of the LCD
+ */
+void lcdClearLines() {
+	lcdClear(LCD_PORT);
+	memset(lcdShadow, ' ', sizeof(lcdShadow));
+	lcdShadow[0][LCD_MESSAGE_MAX_LENGTH] = 0;
+	lcdShadow[1][LCD_MESSAGE_MAX_LENGTH] = 0;
+}
@@ -8,11 +8,6 @@
 #include "main.h"
 #include <string.h>
 
-/**
- * The first level of menu items that show up on the LCD after the splash screen
- */
-menu_item* initialMenuItems;
-
 /**
  * The amount of milliseconds that the menu has been inactive (after 5000 ms it goes to splash screen)
  */
@@ -21,7 +16,7 @@ int menuTimeout = 0;
 /**
  * The a pointer to the first menu in the layer of menus currently displaying on the LCD screen
  */
-menu_item* currentMenus;
+const menu_item* currentMenus;
 
 /**
  * The index of the current menu in the currentMenus array
@@ -34,19 +29,52 @@ int currentMenuIndex = 0;
 int numMenuItems;
 
 /**
- * The previous value for the Left LCD button
+ * The LCD buttons as read by the last call to updateLCDMenu()
+ */
+static lcdButtons menuButtons;
+
+/**
+ * Whether another task has stopped the LCD task from drawing with lockLCDMenu()
  */
-int prevLCDLeft = 0;
+static volatile bool lcdMenuLocked = false;
 
 /**
- * The previous value for the Right LCD button
+ * Whether the LCD task is currently updating the menu (and so using the LCD)
  */
-int prevLCDRight = 0;
+static volatile bool lcdMenuDrawing = false;
 
 /**
- * The previous value for the Center LCD button
+ * Given by the operator control task once it has finished running a menu action
  */
-int prevLCDCenter = 0;
+static Semaphore lcdActionDone;
+
+/**
+ * No menu action is waiting for the operator control task
+ */
+#define LCD_ACTION_IDLE 0
+/**
+ * A menu action has been handed to the operator control task but has not started yet
+ */
+#define LCD_ACTION_REQUESTED 1
+/**
+ * The operator control task is running a menu action
+ */
+#define LCD_ACTION_RUNNING 2
+
+/**
+ * The state of the menu action handed to the operator control task (one of the LCD_ACTION_* values)
+ */
+static volatile int lcdActionState = LCD_ACTION_IDLE;
+
+/**
+ * The menu action handed to the operator control task
+ */
+static void (*volatile lcdAction)(int);
+
+/**
+ * The index of the menu item that triggered the menu action handed to the operator control task
+ */
+static volatile int lcdActionIndex;
 
 
 /**
@@ -60,23 +88,208 @@ void showBatteryInfo(int index) {
 	while (lcdReadButtons(LCD_PORT) == 0) {
 		double primaryBatt = powerLevelMain() / 1000.0;
 		//double secondaryBatt = powerLevelExpander() / 1000.0;
-		lcdPrint(LCD_PORT, 1, "Main: %f", primaryBatt);
-		lcdSetText(LCD_PORT, 2, "");
-		//lcdPrint(LCD_PORT, 2, "Expander: %f", secondaryBatt);
+		lcdPrintLine(1, "Main: %f", primaryBatt);
+		lcdWriteLine(2, "");
+		//lcdPrintLine(2, "Expander: %f", secondaryBatt);
 		delay(20);
 	}
 }
 
 /**
- * Wrapper for the recordAuton function that has an int parameter
+ * Wrapper for the recordAndSaveAuton function that has an int parameter
  *
  * @param index Dummy parameter for the lcdDisplay menu
  */
 void recordAutonWrapper(int index) {
-	recordAuton();
+	recordAndSaveAuton();
+}
+
+/**
+ * Wrapper for the recordAutonEvents function that has an int parameter
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void recordAutonEventsWrapper(int index) {
+	recordAutonEvents();
 	saveAuton();
 }
 
+/**
+ * Lets the driver choose a joystick response profile with the LCD buttons
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void selectStickProfile(int index) {
+	int profile = stickGetProfile() - stickProfiles;
+
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	lcdWriteLine(1, "Driver profile");
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT)) {
+			profile = (profile + 1) % STICK_NUM_PROFILES;
+		} else if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
+			profile = (profile + STICK_NUM_PROFILES - 1) % STICK_NUM_PROFILES;
+		}
+		lcdWriteLine(2, stickProfiles[profile].name);
+
+		delay(20);
+		lcdPollButtons(&buttons);
+	}
+
+	stickSetProfile(profile);
+}
+
+/**
+ * Lets the driver choose whether the sticks drive relative to the robot or to the field with the LCD buttons
+ * Choosing to face forward now also makes the robot's current heading the field's forward direction.
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void selectDriveMode(int index) {
+	if (!sensorGyroPresent()) {
+		lcdWriteLine(1, "Field centric");
+		lcdWriteLine(2, "needs a gyro!");
+		delay(1000);
+		return;
+	}
+	static const char* const modeNames[] = { "Robot centric", "Field centric", "Field, face now" };
+	int mode = driveIsFieldCentric() ? 1 : 0;
+
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	lcdWriteLine(1, "Drive mode");
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT)) {
+			mode = (mode + 1) % 3;
+		} else if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
+			mode = (mode + 2) % 3;
+		}
+		lcdWriteLine(2, modeNames[mode]);
+
+		delay(20);
+		lcdPollButtons(&buttons);
+	}
+
+	if (mode == 2) {
+		resetDriveHeading();
+	}
+	driveSetFieldCentric(mode != 0);
+}
+
+/**
+ * Lets the driver choose with the LCD buttons whether they can take over from a routine while it plays back
+ * The joysticks belong to the field during a match's autonomous period, so this only applies to playback started from
+ * the joystick or the LCD.
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void selectCommandPolicy(int index) {
+	static const char* const policyNames[COMMAND_NUM_POLICIES] = { "Playback only", "Driver override",
+			"Driver blends in" };
+	int policy = commandGetPolicy();
+
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	lcdWriteLine(1, "Driver takeover");
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT)) {
+			policy = (policy + 1) % COMMAND_NUM_POLICIES;
+		} else if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
+			policy = (policy + COMMAND_NUM_POLICIES - 1) % COMMAND_NUM_POLICIES;
+		}
+		lcdWriteLine(2, policyNames[policy]);
+
+		delay(20);
+		lcdPollButtons(&buttons);
+	}
+
+	commandSetPolicy(policy);
+}
+
+/**
+ * Lets the driver choose the starting tile with the LCD buttons, mirroring the loaded autonomous routine for the opposite tile
+ * The routine is reloaded with the new mirroring, so autonomous plays it back without any work per tick.
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void selectStartTile(int index) {
+	int flipped = autonFlipped;
+
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	lcdWriteLine(1, "Start tile");
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT) || LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
+			flipped = -flipped;
+		}
+		lcdWriteLine(2, (flipped == 1) ? "As recorded" : "Mirrored");
+
+		delay(20);
+		lcdPollButtons(&buttons);
+	}
+
+	if (flipped != autonFlipped) {
+		autonFlipped = flipped;
+		loadAuton(autonLoaded);
+	}
+}
+
+/**
+ * Lets the driver choose how much faster than recorded the autonomous routine is played back
+ * Left and right step the speed by 25%, and center confirms it.
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void selectPlaybackSpeed(int index) {
+	int speed = autonPlaybackSpeed;
+
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	lcdWriteLine(1, "Auton speed");
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_RIGHT)) {
+			speed = MIN(speed + 25, AUTON_MAX_PLAYBACK_SPEED);
+		} else if (LCD_BUTTON_PRESSED(buttons, LCD_BTN_LEFT)) {
+			speed = MAX(speed - 25, 100);
+		}
+		lcdPrintLine(2, "%d%%", speed);
+
+		delay(20);
+		lcdPollButtons(&buttons);
+	}
+
+	autonPlaybackSpeed = speed;
+}
+
+/**
+ * Shows the control loop stage profile, cycling through the stages with the left and right buttons
+ * The full profile is also printed to the serial port when the screen is opened, and holding the left and right
+ * buttons together clears it.
+ *
+ * @param index Dummy parameter for the lcdDisplay menu
+ */
+void showProfiler(int index) {
+	profileReport();
+	deadlineReportEvents();
+
+	int stage = 0;
+	profileStats stats;
+	lcdButtons buttons = {LCD_BTN_CENTER, LCD_BTN_CENTER};
+	while (!LCD_BUTTON_PRESSED(buttons, LCD_BTN_CENTER)) {
+		if (LCD_BUTTON_HELD(buttons, LCD_BTN_LEFT) && LCD_BUTTON_HELD(buttons, LCD_BTN_RIGHT)) {
+			profileReset();
+		} else if (LCD_BUTTON_RELEASED(buttons, LCD_BTN_RIGHT) && !LCD_BUTTON_HELD(buttons, LCD_BTN_LEFT)) {
+			stage = (stage + 1) % PROFILE_NUM_STAGES;
+		} else if (LCD_BUTTON_RELEASED(buttons, LCD_BTN_LEFT) && !LCD_BUTTON_HELD(buttons, LCD_BTN_RIGHT)) {
+			stage = (stage + PROFILE_NUM_STAGES - 1) % PROFILE_NUM_STAGES;
+		}
+
+		profileGetStats(stage, &stats);
+		unsigned long mean = (stats.count == 0) ? 0 : stats.total / stats.count;
+		lcdPrintLine(1, "%-8s x%lu", profileStageName(stage), stats.misses);
+		lcdPrintLine(2, "%lu/%lu/%lu", mean, profileP99(&stats), stats.max);
+
+		delay(100);
+		lcdPollButtons(&buttons);
+	}
+}
+
 /**
  * Runs a motor until an LCD button is pressed
  *
@@ -85,18 +298,17 @@ void recordAutonWrapper(int index) {
 void runMotorUntilPress(int index) {
 	delay(500);
 
-	char lineOne[16];
-	snprintf(lineOne, 16, "Running port %d", index + 1);
-	lcdSetText(LCD_PORT, 1, lineOne);
-	lcdSetText(LCD_PORT, 2, "Speed: 127");
+	lcdPrintLine(1, "Running port %d", index + 1);
+	lcdWriteLine(2, "Speed: 127");
 
-	motorSet(index + 1, 127);
+	motorOutputSet(index + 1, 127);
 
 	while (lcdReadButtons(LCD_PORT) == 0) {
-		delay(20);
+		motorOutputCommit(MOTOR_OUTPUT_TICK);
+		delay(MOTOR_OUTPUT_TICK);
 	}
 
-	motorSet(index, 0);
+	motorOutputStopAll();
 }
 
 /**
@@ -107,7 +319,7 @@ void runMotorUntilPress(int index) {
 void lcdPlaybackAuton(int index) {
 	delay(500);
 
-	lcdSetText(LCD_PORT, 1, "Load from?");
+	lcdWriteLine(1, "Load from?");
 	loadAuton(selectAuton(false));
 	playbackAuton();
 }
@@ -129,38 +341,159 @@ void uploadAutonToComputerWrapper() {
 }
 
 /**
- * Initializes the menus used in this program
+ * Hands a menu action to the operator control task and waits for it to finish.
+ * The LCD task keeps holding the LCD while it waits, so the action has the LCD to itself.
+ * If the robot is not in operator control, the action is withdrawn instead of waiting for a task that is not running.
+ *
+ * @param action the menu action to run
+ * @param index the index of the menu item that triggered the action
  */
-void initLCDMenu() {
-	initialMenuItems = (menu_item*) malloc(6 * sizeof(menu_item));
+static void runOnControlTask(void (*action)(int), int index) {
+	lcdAction = action;
+	lcdActionIndex = index;
+	lcdActionState = LCD_ACTION_REQUESTED;
+
+	// The operator control task may lock the LCD before it gets to the action, so do not hold it while waiting
+	lcdMenuDrawing = false;
+	while (!semaphoreTake(lcdActionDone, 100)) {
+		// The operator control task is not running outside of operator control, so the action will never finish
+		if (!isEnabled() || isAutonomous()) {
+			LOG_WARN("Menu action %d withdrawn, robot is not in operator control.\n", index);
+			lcdActionState = LCD_ACTION_IDLE;
+			break;
+		}
+	}
+	lcdMenuDrawing = true;
+}
+
+/**
+ * Runs the menu action that the LCD task handed to the operator control task, if there is one
+ */
+void runLCDMenuActions() {
+	if (!__sync_bool_compare_and_swap(&lcdActionState, LCD_ACTION_REQUESTED, LCD_ACTION_RUNNING)) {
+		return;
+	}
+	lcdAction(lcdActionIndex);
+	lcdActionState = LCD_ACTION_IDLE;
+	semaphoreGive(lcdActionDone);
+}
 
-	menu_item* motorTestMenus;
-	motorTestMenus = malloc(10 * sizeof(menu_item));
+/**
+ * Updates the LCD menu every LCD_MENU_PERIOD milliseconds
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void lcdMenuTask(void* ignore) {
+	// The boot preload shows its progress on the LCD, so only start drawing once it is done
+	waitAutonPreload();
+	unsigned long wakeTime = millis();
+	while (true) {
+		lcdMenuDrawing = true;
+		__sync_synchronize();
+		// The menu is only redrawn when the control loop has time to spare, which leaves its buttons unread until then
+		if (!lcdMenuLocked && !deadlineShedding(DEADLINE_SHED_LCD)) {
+			unsigned long start = profileBegin();
+			updateLCDMenu(LCD_MENU_PERIOD);
+			profileEnd(PROFILE_LCD_MENU, start);
+		}
+		lcdMenuDrawing = false;
+		taskDelayUntil(&wakeTime, LCD_MENU_PERIOD);
+	}
+}
 
-	menu_item batteryMenu = { .isFunction = true, .name = "Battery Info", .description = "", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &showBatteryInfo };
-	menu_item motorTest = { .isFunction = false, .name = "Motor Testing", .description = "Run chosen motor(s)", .numChildren = 10, .children = motorTestMenus, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = 0 };
-	menu_item recordAuton = { .isFunction = true, .name = "Record Auton", .description = "", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &recordAutonWrapper };
-	menu_item loadAuton = { .isFunction = true, .name = "Playback Auton", .description = "", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &lcdPlaybackAuton };
-	menu_item downloadAuton = { .isFunction = true, .name = "Download Auton", .description = "Load from computer", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &downloadAutonFromComputerWrapper };
-	menu_item uploadAuton = { .isFunction = true, .name = "Upload Auton", .description = "Save to computer", .numChildren = 0, .children = 0, .numParents = 0, .parentIndex = 0, .parent = 0, .runFunction = &uploadAutonToComputerWrapper };
-	
-	for (int i = 0; i < 10; i++) {
-		char* name = malloc((LCD_MESSAGE_MAX_LENGTH - 2 + 1) * sizeof(char));
-		snprintf(name, LCD_MESSAGE_MAX_LENGTH - 2 + 1, "Port %d", i + 1);
+/**
+ * Starts the low priority task that updates the LCD menu
+ */
+void startLCDMenuTask() {
+	taskCreate(lcdMenuTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_LOWEST + 1);
+}
 
-		menu_item curMotorTestMenu = { .isFunction = true, .name = name, .description = "", .numChildren = 0, .children = 0, .numParents = 4, .parentIndex = 1, .parent = initialMenuItems, .runFunction = &runMotorUntilPress };
-		motorTestMenus[i] = curMotorTestMenu;
+/**
+ * Stops the LCD task from drawing so that the calling task can use the LCD and its buttons
+ */
+void lockLCDMenu() {
+	lcdMenuLocked = true;
+	__sync_synchronize();
+	while (lcdMenuDrawing) {
+		delay(1);
 	}
+}
+
+/**
+ * Lets the LCD task draw the menu again after a call to lockLCDMenu()
+ */
+void unlockLCDMenu() {
+	lcdMenuLocked = false;
+}
+
+/**
+ * Indices of the items in the first level of the menu
+ */
+enum {
+	MENU_BATTERY,
+	MENU_MOTOR_TEST,
+	MENU_RECORD_AUTON,
+	MENU_RECORD_EVENTS,
+	MENU_PLAYBACK_AUTON,
+	MENU_START_TILE,
+	MENU_PLAYBACK_SPEED,
+	MENU_DOWNLOAD_AUTON,
+	MENU_UPLOAD_AUTON,
+	MENU_DRIVER_PROFILE,
+	MENU_DRIVE_MODE,
+	MENU_COMMAND_POLICY,
+	MENU_PROFILER,
+	MENU_NUM_ITEMS
+};
+
+/**
+ * The first level of menu items that show up on the LCD after the splash screen
+ * Declared ahead of its definition so that the submenus can point back to it.
+ */
+static const menu_item initialMenuItems[MENU_NUM_ITEMS];
+
+/**
+ * Defines the item of the motor testing submenu that runs a motor port
+ *
+ * @param port the motor port (1 - 10)
+ */
+#define MOTOR_TEST_MENU(port) { .isFunction = true, .name = "Port " #port, .description = "", .numParents = MENU_NUM_ITEMS, .parentIndex = MENU_MOTOR_TEST, .parent = initialMenuItems, .isControlAction = true, .runFunction = &runMotorUntilPress }
 
-	initialMenuItems[0] = batteryMenu;
-	initialMenuItems[1] = motorTest;
-	initialMenuItems[2] = recordAuton;
-	initialMenuItems[3] = loadAuton;
-	initialMenuItems[4] = downloadAuton;
-	initialMenuItems[5] = uploadAuton;
+/**
+ * The motor testing submenu, with one item per motor port in port order
+ */
+static const menu_item motorTestMenus[] = {
+	MOTOR_TEST_MENU(1), MOTOR_TEST_MENU(2), MOTOR_TEST_MENU(3), MOTOR_TEST_MENU(4), MOTOR_TEST_MENU(5),
+	MOTOR_TEST_MENU(6), MOTOR_TEST_MENU(7), MOTOR_TEST_MENU(8), MOTOR_TEST_MENU(9), MOTOR_TEST_MENU(10)
+};
+
+static const menu_item initialMenuItems[MENU_NUM_ITEMS] = {
+	[MENU_BATTERY] = { .isFunction = true, .name = "Battery Info", .description = "", .runFunction = &showBatteryInfo },
+	[MENU_MOTOR_TEST] = { .isFunction = false, .name = "Motor Testing", .description = "Run chosen motor(s)", .numChildren = MENU_COUNT(motorTestMenus), .children = motorTestMenus },
+	[MENU_RECORD_AUTON] = { .isFunction = true, .name = "Record Auton", .description = "", .isControlAction = true, .runFunction = &recordAutonWrapper },
+	[MENU_RECORD_EVENTS] = { .isFunction = true, .name = "Record Events", .description = "200 Hz recording", .isControlAction = true, .runFunction = &recordAutonEventsWrapper },
+	[MENU_PLAYBACK_AUTON] = { .isFunction = true, .name = "Playback Auton", .description = "", .isControlAction = true, .runFunction = &lcdPlaybackAuton },
+	[MENU_START_TILE] = { .isFunction = true, .name = "Start Tile", .description = "Mirror auton", .isControlAction = true, .runFunction = &selectStartTile },
+	[MENU_PLAYBACK_SPEED] = { .isFunction = true, .name = "Auton Speed", .description = "Faster playback", .runFunction = &selectPlaybackSpeed },
+	[MENU_DOWNLOAD_AUTON] = { .isFunction = true, .name = "Download Auton", .description = "Load from computer", .isControlAction = true, .runFunction = &downloadAutonFromComputerWrapper },
+	[MENU_UPLOAD_AUTON] = { .isFunction = true, .name = "Upload Auton", .description = "Save to computer", .runFunction = &uploadAutonToComputerWrapper },
+	[MENU_DRIVER_PROFILE] = { .isFunction = true, .name = "Driver Profile", .description = "Stick curves", .runFunction = &selectStickProfile },
+	[MENU_DRIVE_MODE] = { .isFunction = true, .name = "Drive Mode", .description = "Field centric", .runFunction = &selectDriveMode },
+	[MENU_COMMAND_POLICY] = { .isFunction = true, .name = "Driver Takeover", .description = "During playback", .runFunction = &selectCommandPolicy },
+	[MENU_PROFILER] = { .isFunction = true, .name = "Profiler", .description = "Mean/p99/max us", .runFunction = &showProfiler }
+};
+
+/**
+ * Initializes the menus used in this program
+ * The menu tree itself is constant, so this only resets the position in it.
+ */
+void initLCDMenu() {
+	lcdActionDone = semaphoreCreate();
+	semaphoreTake(lcdActionDone, 0);
 
 	currentMenus = initialMenuItems;
-	numMenuItems = 6;
+	currentMenuIndex = 0;
+	numMenuItems = MENU_NUM_ITEMS;
 }
 
 /**
@@ -169,15 +502,19 @@ void initLCDMenu() {
  * @param dt The amount of time that has passed since the function was last called
  */
 void updateLCDMenu(int dt) {
-	if (((lcdReadButtons(LCD_PORT) & LCD_BTN_CENTER) != 0) && prevLCDCenter == 0) {
-		if (currentMenus[currentMenuIndex].isFunction) {
+	lcdPollButtons(&menuButtons);
+
+	if (LCD_BUTTON_PRESSED(menuButtons, LCD_BTN_CENTER)) {
+		if (currentMenus[currentMenuIndex].isFunction && currentMenus[currentMenuIndex].isControlAction) {
+			runOnControlTask(currentMenus[currentMenuIndex].runFunction, currentMenuIndex);
+		} else if (currentMenus[currentMenuIndex].isFunction) {
 			currentMenus[currentMenuIndex].runFunction(currentMenuIndex);
 		} else {
 			numMenuItems = currentMenus[currentMenuIndex].numChildren;
 			currentMenus = currentMenus[currentMenuIndex].children;
 			currentMenuIndex = 0;
 		}
-	} else if (((lcdReadButtons(LCD_PORT) & LCD_BTN_RIGHT) != 0) && prevLCDRight == 0) {
+	} else if (LCD_BUTTON_PRESSED(menuButtons, LCD_BTN_RIGHT)) {
 		if (currentMenuIndex == numMenuItems - 1) {
 			if (currentMenus[currentMenuIndex].parent != 0) {
 				numMenuItems = currentMenus[currentMenuIndex].numParents;
@@ -190,7 +527,7 @@ void updateLCDMenu(int dt) {
 		} else {
 			currentMenuIndex++;
 		}
-	} else if (((lcdReadButtons(LCD_PORT) & LCD_BTN_LEFT) != 0) && prevLCDLeft == 0) {
+	} else if (LCD_BUTTON_PRESSED(menuButtons, LCD_BTN_LEFT)) {
 		if (currentMenuIndex == 0) {
 			if (currentMenus[currentMenuIndex].parent != 0) {
 				numMenuItems = currentMenus[currentMenuIndex].numParents;
@@ -205,22 +542,22 @@ void updateLCDMenu(int dt) {
 		}
 	}
 
-	menu_item curMenu = currentMenus[currentMenuIndex];
+	const menu_item* curMenu = &currentMenus[currentMenuIndex];
 
 	int firstChar = 247; // Left arrow
 	int secondChar = 246; // Right arrow
-	if ((currentMenuIndex == 0) && (curMenu.parent != 0)) {
+	if ((currentMenuIndex == 0) && (curMenu->parent != 0)) {
 		firstChar = 197; // Up arrow
-	} else if ((currentMenuIndex == 0) && curMenu.parent == 0) {
+	} else if ((currentMenuIndex == 0) && curMenu->parent == 0) {
 		firstChar = ' ';
 	}
-	if ((currentMenuIndex == numMenuItems - 1) && (curMenu.parent != 0)) {
+	if ((currentMenuIndex == numMenuItems - 1) && (curMenu->parent != 0)) {
 		secondChar = 197; // Up arrow
-	} else if ((currentMenuIndex == numMenuItems - 1) && (curMenu.parent == 0)) {
+	} else if ((currentMenuIndex == numMenuItems - 1) && (curMenu->parent == 0)) {
 		secondChar = ' ';
 	}
 
-	int totalNumSpaces = LCD_MESSAGE_MAX_LENGTH - 2 - strlen(curMenu.name);
+	int totalNumSpaces = LCD_MESSAGE_MAX_LENGTH - 2 - strlen(curMenu->name);
 	int line1Padding1 = totalNumSpaces / 2 + (totalNumSpaces % 2 != 0);
 
 	char output[LCD_MESSAGE_MAX_LENGTH + 1];
@@ -229,16 +566,12 @@ void updateLCDMenu(int dt) {
 	output[0] = firstChar;
 	output[LCD_MESSAGE_MAX_LENGTH - 1] = secondChar;
 
-	for (int i = 0; i < strlen(curMenu.name); i++) {
-		output[1 + line1Padding1 + i] = curMenu.name[i];
+	for (int i = 0; i < strlen(curMenu->name); i++) {
+		output[1 + line1Padding1 + i] = curMenu->name[i];
 	}
 
-	lcdSetText(LCD_PORT, 1, output);
-	lcdSetText(LCD_PORT, 2, curMenu.description);
-
-	prevLCDCenter = lcdReadButtons(LCD_PORT) & LCD_BTN_CENTER;
-	prevLCDRight = lcdReadButtons(LCD_PORT) & LCD_BTN_RIGHT;
-	prevLCDLeft = lcdReadButtons(LCD_PORT) & LCD_BTN_LEFT;
+	lcdWriteLine(1, output);
+	lcdWriteLine(2, curMenu->description);
 
 	// Finish when splash screen is implemented
 	//menuTimeout += dt;
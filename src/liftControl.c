@@ -0,0 +1,277 @@
+/** @file liftControl.c
+ * @brief File for the lift position controller
+ *
+ * The controller task only computes a power; the task that drives the robot sends it with the other motors in
+ * moveRobot(), so the motor output table keeps a single writer. Commands and the power are single words written by
+ * one task each, so they need no locking. Heights are in lift encoder ticks with up as positive, and the profile is
+ * kept in thousandths of a tick so that slow speeds still advance it every tick.
+ */
+
+#include "main.h"
+
+/**
+ * Milliseconds between controller ticks
+ */
+#define LIFT_CONTROL_PERIOD (1000 / LIFT_CONTROL_FREQ)
+
+/**
+ * Heights of the presets in encoder ticks: the ground, then one more cone each
+ */
+static const int liftPresets[LIFT_NUM_PRESETS] = { 0, 150, 300, 450, 600, 750 };
+
+/**
+ * Whether there is a lift encoder and the controller task is running
+ */
+static bool closedLoop = false;
+
+/**
+ * The command most recently given with liftCommand()
+ */
+static volatile int command = 0;
+
+/**
+ * The preset being gone to or held, or -1 while the lift is driven by hand
+ */
+static volatile int preset = -1;
+
+/**
+ * The power computed by the controller task, in the direction setLiftMotors() uses
+ */
+static volatile int power = 0;
+
+/**
+ * The height the lift is going to or holding, as of the last controller tick
+ */
+static volatile int goalHeight = 0;
+
+/**
+ * A struct that holds the state of the lift motion profile and PID loop
+ */
+typedef struct liftState {
+	/**
+	 * The height the profile is moving to
+	 */
+	int goal;
+
+	/**
+	 * The planned height in thousandths of a tick
+	 */
+	int position;
+
+	/**
+	 * The planned speed in ticks per second
+	 */
+	int velocity;
+
+	/**
+	 * The sum of the error over time in thousandths of a tick second
+	 */
+	int integral;
+
+	/**
+	 * The measured height on the previous tick
+	 */
+	int lastHeight;
+} liftState;
+
+/**
+ * Computes the integer square root
+ *
+ * @param value the number to take the square root of, at least 0
+ *
+ * @return the largest integer whose square is at most value
+ */
+static int squareRoot(int value) {
+	int root = 0;
+	for (int bit = 1 << 14; bit > 0; bit >>= 1) {
+		int trial = root | bit;
+		if (trial * trial <= value) {
+			root = trial;
+		}
+	}
+	return root;
+}
+
+/**
+ * Moves the motion profile one tick toward its goal, accelerating to LIFT_MAX_VELOCITY and braking at LIFT_MAX_ACCEL
+ * so that it stops on the goal
+ *
+ * @param state the profile to advance
+ */
+static void advanceProfile(liftState* state) {
+	const int accelStep = LIFT_MAX_ACCEL * LIFT_CONTROL_PERIOD / 1000;
+	int remaining = state->goal * 1000 - state->position;
+	int direction = (remaining > 0) ? 1 : -1;
+	// The fastest speed that can still brake to a stop on the goal, which makes the profile trapezoidal
+	int stoppable = MIN(squareRoot(2 * LIFT_MAX_ACCEL / 1000 * ABS(remaining)), LIFT_MAX_VELOCITY);
+	int velocity = CLAMP(direction * stoppable, state->velocity - accelStep, state->velocity + accelStep);
+	if (ABS(remaining) <= ABS(velocity) * LIFT_CONTROL_PERIOD || remaining == 0) {
+		// The goal is reached within this tick
+		state->position = state->goal * 1000;
+		state->velocity = 0;
+		return;
+	}
+	state->velocity = velocity;
+	state->position += velocity * LIFT_CONTROL_PERIOD;
+}
+
+/**
+ * Runs one tick of the controller
+ *
+ * @param state the profile and PID state
+ * @param height the measured height of the lift
+ * @param manual the hand command from -1 to 1 if the lift is driven by hand, or 0 if it follows the profile
+ *
+ * @return the power that raises the lift, from -127 to 127
+ */
+static int controlLift(liftState* state, int height, int manual) {
+	int measuredVelocity = (height - state->lastHeight) * LIFT_CONTROL_FREQ;
+	state->lastHeight = height;
+	if (manual != 0) {
+		// Track the lift while the driver moves it, so holding it afterwards starts from where it is
+		state->goal = height;
+		state->position = height * 1000;
+		state->velocity = 0;
+		state->integral = 0;
+		return -manual * MOTOR_SPEED;
+	}
+	advanceProfile(state);
+	int target = state->position / 1000;
+	if (state->goal <= LIFT_REST_HEIGHT && target <= LIFT_REST_HEIGHT && height <= LIFT_REST_HEIGHT) {
+		// Resting on the hard stop needs no power
+		state->integral = 0;
+		return 0;
+	}
+	int error = target - height;
+	const int maxIntegral = LIFT_MAX_INTEGRAL_POWER * LIFT_GAIN_ONE / LIFT_KI * 1000;
+	if (state->velocity == 0) {
+		// Only integrate while holding, since the lag behind a moving profile would wind it up into an overshoot
+		state->integral = CLAMP(state->integral + error * LIFT_CONTROL_PERIOD, -maxIntegral, maxIntegral);
+	}
+	// The derivative acts on the speed error, so following the planned speed is not damped
+	int output = (LIFT_KP * error + LIFT_KI * (state->integral / 1000) + LIFT_KD * (state->velocity - measuredVelocity)
+			+ LIFT_KV * state->velocity) / LIFT_GAIN_ONE + LIFT_GRAVITY_POWER;
+	return CLAMP(output, -127, 127);
+}
+
+/**
+ * Runs the controller at LIFT_CONTROL_FREQ
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void liftControlTask(void* ignore) {
+	sensorSnapshot snapshot;
+	readSensors(&snapshot);
+	liftState state = { .goal = snapshot.encoder, .position = snapshot.encoder * 1000, .lastHeight = snapshot.encoder };
+	int lastPreset = -1;
+	loopTimer timer;
+	loopTimerStart(&timer, LIFT_CONTROL_PERIOD);
+	while (true) {
+		readSensors(&snapshot);
+		int current = command;
+		int manual = 0;
+		if (liftIsPresetCommand(current)) {
+			preset = current - LIFT_COMMAND_PRESET;
+		} else if (current != 0) {
+			manual = CLAMP(current, -1, 1);
+			preset = -1;
+		}
+		int goingTo = preset;
+		if (goingTo != lastPreset && goingTo >= 0) {
+			// The profile carries on from its planned height and speed, so changing preset mid-move is smooth
+			state.goal = liftPresets[goingTo];
+		}
+		lastPreset = goingTo;
+		// setLiftMotors() raises the lift with negative power
+		power = -controlLift(&state, snapshot.encoder, manual);
+		goalHeight = state.goal;
+		loopTimerWait(&timer);
+	}
+}
+
+/**
+ * Initializes the lift controller and starts its task if there is a lift encoder. Must be called from initialize()
+ * after initSensors().
+ */
+void initLiftControl() {
+	closedLoop = SENSOR_ENCODER_TOP_PORT != 0;
+	if (closedLoop) {
+		LOG_INFO("Lift control: closed loop with the encoder on port %d\n", SENSOR_ENCODER_TOP_PORT);
+		// Below the sensor task, so the snapshot it reads is always complete, and above the driving task
+		taskCreate(liftControlTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_DEFAULT + 1);
+	} else {
+		LOG_INFO("Lift control: open loop, no lift encoder\n");
+	}
+}
+
+/**
+ * Gets whether a lift command sends the lift to a preset
+ *
+ * @param command the lift command
+ *
+ * @return true for LIFT_PRESET_COMMAND() values, false for commands that drive the lift by hand
+ */
+bool liftIsPresetCommand(int command) {
+	return command >= LIFT_COMMAND_PRESET && command < LIFT_COMMAND_PRESET + LIFT_NUM_PRESETS;
+}
+
+/**
+ * Gets the preset that the lift is going to or holding
+ *
+ * @return the number of the preset, or -1 if the lift was last driven by hand
+ */
+int liftGetPreset() {
+	return preset;
+}
+
+/**
+ * Finds the next preset above or below the lift, for stepping through the presets one button press at a time
+ *
+ * @param direction 1 for the next preset up or -1 for the next preset down
+ *
+ * @return the number of the preset
+ */
+int liftNextPreset(int direction) {
+	int current = preset;
+	if (current >= 0) {
+		return CLAMP(current + direction, 0, LIFT_NUM_PRESETS - 1);
+	}
+	// Driven by hand, so step from wherever the lift was left
+	int height = goalHeight;
+	if (direction > 0) {
+		for (int i = 0; i < LIFT_NUM_PRESETS; i++) {
+			if (liftPresets[i] > height) {
+				return i;
+			}
+		}
+		return LIFT_NUM_PRESETS - 1;
+	}
+	for (int i = LIFT_NUM_PRESETS - 1; i >= 0; i--) {
+		if (liftPresets[i] < height) {
+			return i;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Commands the lift; called by the task that drives the robot every control tick
+ *
+ * @param newCommand -1 or 1 to drive the lift by hand, 0 to hold it, or LIFT_PRESET_COMMAND(n) to send it to preset n
+ */
+void liftCommand(int newCommand) {
+	command = newCommand;
+	if (!closedLoop) {
+		// Open loop: presets cannot be reached, so they stop the lift like letting go of the buttons
+		power = liftIsPresetCommand(newCommand) ? 0 : CLAMP(newCommand * MOTOR_SPEED, -127, 127);
+	}
+}
+
+/**
+ * Gets the power the lift motors should be given, in the direction setLiftMotors() uses
+ *
+ * @return the motor power from -127 to 127
+ */
+int liftControlPower() {
+	return power;
+}
@@ -0,0 +1,149 @@
+/** @file linkProtocol.c
+ * @brief File for the framed binary serial link protocol
+ *
+ * Encodes and decodes the frames described in linkProtocol.h. This file does not use the PROS API, so the host tools
+ * compile it as well.
+ */
+
+#include "linkProtocol.h"
+#include <string.h>
+
+/**
+ * Computes the CRC-16/CCITT of a block of data
+ *
+ * @param crc the CRC of the data before this block, or 0xFFFF to start a new CRC
+ * @param data the data to add to the CRC
+ * @param size the size of data in bytes
+ *
+ * @return the CRC including the block
+ */
+uint16_t linkCrc16(uint16_t crc, const void* data, int size) {
+	const uint8_t* bytes = (const uint8_t*) data;
+	for (int i = 0; i < size; i++) {
+		crc ^= (uint16_t) bytes[i] << 8;
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+		}
+	}
+	return crc;
+}
+
+/**
+ * Encodes a frame into a buffer ready to be written to the serial port
+ *
+ * @param buffer the buffer to encode into, at least LINK_MAX_FRAME bytes long
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ *
+ * @return the size of the encoded frame in bytes
+ */
+int linkEncode(uint8_t* buffer, uint8_t type, uint8_t seq, const void* payload, int length) {
+	buffer[0] = LINK_SOF;
+	buffer[1] = type;
+	buffer[2] = seq;
+	buffer[3] = (uint8_t) length;
+	if (length > 0) {
+		memcpy(buffer + 4, payload, length);
+	}
+	linkPut16(buffer + 4 + length, linkCrc16(0xFFFF, buffer + 1, length + 3));
+	return length + LINK_FRAME_OVERHEAD;
+}
+
+/**
+ * Resets a decoder to wait for the start of a frame
+ *
+ * @param decoder the decoder to reset
+ */
+void linkDecoderReset(linkDecoder* decoder) {
+	decoder->received = 0;
+}
+
+/**
+ * Feeds one received byte to a decoder
+ *
+ * @param decoder the decoder
+ * @param byte the byte received
+ *
+ * @return LINK_DECODE_FRAME when decoder->frame holds a new valid frame, LINK_DECODE_CORRUPT when a corrupt frame was
+ * dropped, or LINK_DECODE_PENDING otherwise
+ */
+int linkDecode(linkDecoder* decoder, uint8_t byte) {
+	linkFrame* frame = &decoder->frame;
+	int index = decoder->received++;
+	if (index == 0) {
+		if (byte != LINK_SOF) {
+			decoder->received = 0;
+		}
+	} else if (index == 1) {
+		frame->type = byte;
+	} else if (index == 2) {
+		frame->seq = byte;
+	} else if (index == 3) {
+		frame->length = byte;
+		if (byte > LINK_MAX_PAYLOAD) {
+			decoder->received = 0;
+			decoder->errors++;
+			return LINK_DECODE_CORRUPT;
+		}
+	} else if (index < 4 + frame->length) {
+		frame->payload[index - 4] = byte;
+	} else if (index == 4 + frame->length) {
+		decoder->crc = byte;
+	} else {
+		decoder->crc |= (uint16_t) byte << 8;
+		decoder->received = 0;
+		uint16_t crc = linkCrc16(0xFFFF, &frame->type, 3);
+		if (decoder->crc != linkCrc16(crc, frame->payload, frame->length)) {
+			decoder->errors++;
+			return LINK_DECODE_CORRUPT;
+		}
+		return LINK_DECODE_FRAME;
+	}
+	return LINK_DECODE_PENDING;
+}
+
+/**
+ * Stores a 16-bit integer in a payload
+ *
+ * @param payload where to store the integer
+ * @param value the integer
+ */
+void linkPut16(uint8_t* payload, uint16_t value) {
+	payload[0] = (uint8_t) value;
+	payload[1] = (uint8_t) (value >> 8);
+}
+
+/**
+ * Stores a 32-bit integer in a payload
+ *
+ * @param payload where to store the integer
+ * @param value the integer
+ */
+void linkPut32(uint8_t* payload, uint32_t value) {
+	linkPut16(payload, (uint16_t) value);
+	linkPut16(payload + 2, (uint16_t) (value >> 16));
+}
+
+/**
+ * Reads a 16-bit integer from a payload
+ *
+ * @param payload where the integer is stored
+ *
+ * @return the integer
+ */
+uint16_t linkGet16(const uint8_t* payload) {
+	return (uint16_t) (payload[0] | (payload[1] << 8));
+}
+
+/**
+ * Reads a 32-bit integer from a payload
+ *
+ * @param payload where the integer is stored
+ *
+ * @return the integer
+ */
+uint32_t linkGet32(const uint8_t* payload) {
+	return linkGet16(payload) | ((uint32_t) linkGet16(payload + 2) << 16);
+}
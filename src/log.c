@@ -0,0 +1,182 @@
+/** @file log.c
+ * @brief File for the asynchronous logging subsystem
+ *
+ * The ring buffer uses a sequence number per record so that producers in different tasks can claim records with a
+ * single compare-and-swap and never block. Only the drain task consumes records.
+ */
+
+#include "main.h"
+
+/**
+ * A fixed-size binary log record
+ */
+typedef struct logRecord {
+	/**
+	 * Sequence number used to hand the record between producers and the drain task
+	 */
+	volatile unsigned int sequence;
+
+	/**
+	 * The time in milliseconds at which the record was pushed
+	 */
+	unsigned long time;
+
+	/**
+	 * The printf() format string of the message
+	 */
+	const char* format;
+
+	/**
+	 * The integer arguments of the message
+	 */
+	int args[LOG_MAX_ARGS];
+
+	/**
+	 * The level of the message
+	 */
+	unsigned char level;
+} logRecord;
+
+/**
+ * The ring buffer of log records
+ */
+static logRecord logBuffer[LOG_BUFFER_SIZE];
+
+/**
+ * The position that the next producer will claim
+ */
+static volatile unsigned int logHead;
+
+/**
+ * The position that the drain task will read next
+ */
+static unsigned int logTail;
+
+/**
+ * The number of records dropped because the ring buffer was full
+ */
+static volatile unsigned int logDropped;
+
+/**
+ * The number of records below LOG_LEVEL_WARN skipped because the control loop was shedding logging
+ */
+static volatile unsigned int logShed;
+
+/**
+ * Whether the drain task should hold off printing
+ */
+static volatile bool logPaused;
+
+/**
+ * The names printed for each log level
+ */
+static const char* const logLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+/**
+ * Pushes a record into the ring buffer without blocking
+ *
+ * @param level the level of the message
+ * @param format the printf() format string of the message
+ */
+void logPush(unsigned char level, const char* format, int arg0, int arg1, int arg2, int arg3, int arg4, int arg5) {
+	if (level < LOG_LEVEL_WARN && deadlineShedding(DEADLINE_SHED_LOG)) {
+		__sync_fetch_and_add(&logShed, 1);
+		return;
+	}
+	unsigned int pos = logHead;
+	logRecord* record;
+	while (true) {
+		record = &logBuffer[pos & (LOG_BUFFER_SIZE - 1)];
+		int diff = (int) (record->sequence - pos);
+		if (diff == 0) {
+			if (__sync_bool_compare_and_swap(&logHead, pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			__sync_fetch_and_add(&logDropped, 1);
+			return;
+		}
+		pos = logHead;
+	}
+
+	record->time = millis();
+	record->format = format;
+	record->level = level;
+	record->args[0] = arg0;
+	record->args[1] = arg1;
+	record->args[2] = arg2;
+	record->args[3] = arg3;
+	record->args[4] = arg4;
+	record->args[5] = arg5;
+	__sync_synchronize();
+	record->sequence = pos + 1;
+}
+
+/**
+ * Takes the oldest record out of the ring buffer
+ *
+ * @param out filled in with the record
+ *
+ * @return true if a record was available, false if the ring buffer is empty
+ */
+static bool logPop(logRecord* out) {
+	logRecord* record = &logBuffer[logTail & (LOG_BUFFER_SIZE - 1)];
+	if (record->sequence != logTail + 1) {
+		return false;
+	}
+	__sync_synchronize();
+	*out = *record;
+	__sync_synchronize();
+	record->sequence = logTail + LOG_BUFFER_SIZE;
+	logTail++;
+	return true;
+}
+
+/**
+ * Formats and prints log records as they arrive
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void logTask(void* ignore) {
+	logRecord record;
+	while (true) {
+		while (!logPaused && logPop(&record)) {
+			printf("[%lu] %s: ", record.time, logLevelNames[record.level]);
+			printf(record.format, record.args[0], record.args[1], record.args[2], record.args[3], record.args[4],
+					record.args[5]);
+		}
+		if (!logPaused && logDropped != 0) {
+			unsigned int dropped = __sync_fetch_and_and(&logDropped, 0);
+			printf("[%lu] WARN: %u log messages dropped\n", millis(), dropped);
+		}
+		if (!logPaused && logShed != 0 && !deadlineShedding(DEADLINE_SHED_LOG)) {
+			unsigned int shed = __sync_fetch_and_and(&logShed, 0);
+			printf("[%lu] WARN: %u log messages shed while the control loop was behind\n", millis(), shed);
+		}
+		delay(LOG_DRAIN_PERIOD);
+	}
+}
+
+/**
+ * Initializes the ring buffer and starts the drain task
+ */
+void logInit() {
+	for (unsigned int i = 0; i < LOG_BUFFER_SIZE; i++) {
+		logBuffer[i].sequence = i;
+	}
+	logHead = 0;
+	logTail = 0;
+	logDropped = 0;
+	logShed = 0;
+	logPaused = false;
+	taskCreate(logTask, TASK_DEFAULT_STACK_SIZE, NULL, TASK_PRIORITY_LOWEST + 1);
+}
+
+/**
+ * Stops or resumes printing of log records
+ *
+ * @param paused true to stop printing, false to resume
+ */
+void logSetPaused(bool paused) {
+	logPaused = paused;
+}
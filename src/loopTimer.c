@@ -0,0 +1,79 @@
+/** @file loopTimer.c
+ * @brief File for the fixed-period loop scheduler
+ *
+ * Releases loop ticks on absolute deadlines using taskDelayUntil() and keeps track of how late each tick was released
+ * and how far each tick body ran past its deadline.
+ */
+
+#include "main.h"
+
+/**
+ * Starts a loop timer, releasing the first tick immediately
+ *
+ * @param timer the timer to start
+ * @param period the period of the loop in milliseconds
+ */
+void loopTimerStart(loopTimer* timer, unsigned long period) {
+	timer->period = period;
+	timer->wakeTime = millis();
+	timer->startMicros = micros();
+	timer->ticks = 0;
+	timer->skipped = 0;
+	timer->overruns = 0;
+	timer->maxOverrun = 0;
+	timer->maxJitter = 0;
+	timer->totalJitter = 0;
+}
+
+/**
+ * Waits until the deadline of the next tick, recording overrun and jitter statistics for the current tick
+ *
+ * @param timer the timer to wait on
+ */
+void loopTimerWait(loopTimer* timer) {
+	timer->ticks++;
+	unsigned long deadline = timer->startMicros + (timer->ticks + timer->skipped) * timer->period * 1000;
+	long late = (long) (micros() - deadline);
+	if (late > 0) {
+		timer->overruns++;
+		timer->maxOverrun = MAX(timer->maxOverrun, (unsigned long) late);
+	}
+
+	taskDelayUntil(&timer->wakeTime, timer->period);
+
+	unsigned long jitter = micros() - deadline;
+	if ((long) jitter < 0) {
+		jitter = 0;
+	}
+	timer->maxJitter = MAX(timer->maxJitter, jitter);
+	timer->totalJitter += jitter;
+}
+
+/**
+ * Drops the ticks whose deadlines have already passed while the current tick ran
+ *
+ * @param timer the timer whose missed ticks to drop
+ */
+void loopTimerSkipMissed(loopTimer* timer) {
+	unsigned long periodMicros = timer->period * 1000;
+	unsigned long deadline = timer->startMicros + (timer->ticks + timer->skipped + 1) * periodMicros;
+	long late = (long) (micros() - deadline);
+	if (late >= (long) periodMicros) {
+		unsigned int missed = late / periodMicros;
+		timer->skipped += missed;
+		timer->wakeTime += missed * timer->period;
+	}
+}
+
+/**
+ * Prints the timing statistics of a loop timer over the debug terminal
+ *
+ * @param timer the timer to report on
+ * @param name the name of the loop to print alongside the statistics
+ */
+void loopTimerReport(const loopTimer* timer, const char* name) {
+	unsigned long elapsed = micros() - timer->startMicros;
+	unsigned long meanJitter = (timer->ticks == 0) ? 0 : timer->totalJitter / timer->ticks;
+	printf("%s: %u ticks in %lu ms, %u overruns (max %lu us), jitter mean %lu us max %lu us\n", name, timer->ticks,
+			elapsed / 1000, timer->overruns, timer->maxOverrun, meanJitter, timer->maxJitter);
+}
@@ -0,0 +1,160 @@
+/** @file motorOutput.c
+ * @brief File for the batched motor output layer
+ *
+ * The table is only touched by the task that is driving the robot (operator control or autonomous), so it needs no
+ * locking. Slew steps are scaled by the period of the loop that commits so that loops running faster than
+ * MOTOR_OUTPUT_TICK, such as event playback, ramp at the same rate in real time. The period is passed in rather than
+ * measured, so a tick that runs late ramps exactly as far as it did when it was recorded.
+ */
+
+#include "main.h"
+
+/**
+ * The power each port has been asked to reach
+ */
+static signed char motorTarget[MOTOR_OUTPUT_PORTS];
+
+/**
+ * The slewed power of each port as of the last commit
+ */
+static signed char motorOutput[MOTOR_OUTPUT_PORTS];
+
+/**
+ * The power last sent to each port with motorSet()
+ */
+static signed char motorSent[MOTOR_OUTPUT_PORTS];
+
+/**
+ * The largest change in power per MOTOR_OUTPUT_TICK of each port
+ */
+static unsigned char motorSlew[MOTOR_OUTPUT_PORTS];
+
+/**
+ * The scale applied to new targets, where MOTOR_OUTPUT_SCALE_ONE leaves them unchanged
+ */
+static int outputScale = MOTOR_OUTPUT_SCALE_ONE;
+
+/**
+ * The number of commits since every port was last sent
+ */
+static unsigned int commitsSinceRefresh = 0;
+
+/**
+ * Sets the default slew rate of every port and stops all motors
+ */
+void motorOutputInit() {
+	for (int i = 0; i < MOTOR_OUTPUT_PORTS; i++) {
+		motorSlew[i] = MOTOR_SLEW_NONE;
+	}
+
+	motorOutputSetSlew(FRONT_LEFT_MOTOR, MOTOR_SLEW_DRIVE);
+	motorOutputSetSlew(FRONT_RIGHT_MOTOR, MOTOR_SLEW_DRIVE);
+	motorOutputSetSlew(BACK_LEFT_MOTOR, MOTOR_SLEW_DRIVE);
+	motorOutputSetSlew(BACK_RIGHT_MOTOR, MOTOR_SLEW_DRIVE);
+
+	motorOutputSetSlew(LIFT_TOP_Y_MOTOR, MOTOR_SLEW_LIFT);
+	motorOutputSetSlew(LIFT_MIDDLE_LEFT_MOTOR, MOTOR_SLEW_LIFT);
+	motorOutputSetSlew(LIFT_MIDDLE_RIGHT_MOTOR, MOTOR_SLEW_LIFT);
+	motorOutputSetSlew(LIFT_BOTTOM_LEFT_MOTOR, MOTOR_SLEW_LIFT);
+	motorOutputSetSlew(LIFT_BOTTOM_RIGHT_MOTOR, MOTOR_SLEW_LIFT);
+
+	motorOutputSetSlew(PINCER_Y_MOTOR, MOTOR_SLEW_PINCER);
+
+	motorOutputStopAll();
+}
+
+/**
+ * Sets the target power of a motor port, to be applied by the next motorOutputCommit()
+ *
+ * @param port the motor port (1 - 10)
+ * @param value the target power from -127 to 127; values outside this range are clamped
+ */
+void motorOutputSet(unsigned char port, int value) {
+	if (port < 1 || port > MOTOR_OUTPUT_PORTS) {
+		return;
+	}
+	motorTarget[port - 1] = CLAMP(value * outputScale / MOTOR_OUTPUT_SCALE_ONE, -127, 127);
+}
+
+/**
+ * Sets the scale applied to every target passed to motorOutputSet() from now on, such as a battery voltage compensation
+ *
+ * @param scale the scale, where MOTOR_OUTPUT_SCALE_ONE leaves targets unchanged
+ */
+void motorOutputSetScale(int scale) {
+	outputScale = scale;
+}
+
+/**
+ * Sets how quickly the output of a motor port can move toward its target
+ *
+ * @param port the motor port (1 - 10)
+ * @param rate the largest change in power per MOTOR_OUTPUT_TICK, or MOTOR_SLEW_NONE to apply targets instantly
+ */
+void motorOutputSetSlew(unsigned char port, unsigned char rate) {
+	if (port < 1 || port > MOTOR_OUTPUT_PORTS) {
+		return;
+	}
+	motorSlew[port - 1] = rate;
+}
+
+/**
+ * Ramps every port toward its target and sends the ports whose output changed
+ * This should be called once per control tick by the task that sets the targets.
+ *
+ * @param period the period in milliseconds of the calling loop, which sets how far each port ramps
+ */
+void motorOutputCommit(unsigned long period) {
+	unsigned long dt = CLAMP(period, 1, MOTOR_OUTPUT_TICK);
+
+	bool refresh = ++commitsSinceRefresh >= MOTOR_OUTPUT_REFRESH_COMMITS;
+	if (refresh) {
+		commitsSinceRefresh = 0;
+	}
+
+	for (int i = 0; i < MOTOR_OUTPUT_PORTS; i++) {
+		int output = motorOutput[i];
+		int error = motorTarget[i] - output;
+		if (motorSlew[i] == MOTOR_SLEW_NONE) {
+			output = motorTarget[i];
+		} else {
+			// Always allow a step of at least 1 so that short ticks still make progress
+			int step = MAX(motorSlew[i] * (int) dt / MOTOR_OUTPUT_TICK, 1);
+			output += CLAMP(error, -step, step);
+		}
+		motorOutput[i] = output;
+
+		if (output != motorSent[i] || refresh) {
+			motorSet(i + 1, output);
+			motorSent[i] = output;
+		}
+	}
+}
+
+/**
+ * Gets the power that the last commit gave a port, after scaling and slewing
+ *
+ * @param port the motor port (1 - 10)
+ *
+ * @return the power from -127 to 127, or 0 for a port out of range
+ */
+int motorOutputGet(unsigned char port) {
+	if (port < 1 || port > MOTOR_OUTPUT_PORTS) {
+		return 0;
+	}
+	return motorOutput[port - 1];
+}
+
+/**
+ * Stops every motor immediately, bypassing the slew rates, sets every target to zero and resets the output scale
+ */
+void motorOutputStopAll() {
+	motorStopAll();
+	outputScale = MOTOR_OUTPUT_SCALE_ONE;
+	for (int i = 0; i < MOTOR_OUTPUT_PORTS; i++) {
+		motorTarget[i] = 0;
+		motorOutput[i] = 0;
+		motorSent[i] = 0;
+	}
+	commitsSinceRefresh = 0;
+}
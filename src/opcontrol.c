@@ -29,87 +29,112 @@
  * This task should never exit; it should end with some kind of infinite loop, even if empty.
  */
 
+bool isLocked = false;
+
 /**
- * Forward motion
- */
-int spd;
-/**
- * Horizontal motion
- */
- int horizontal;
-/**
- * CW rotational motion
- */
-int turn;
-/**
- * Motion of the pincer
- */
-int sht;
-/**
- * lift motion
+ * The lift preset chosen with the preset buttons, or -1 while the lift is driven by hand
  */
-int lift;
-
-bool isLocked = false;
+static int liftPreset = -1;
 
 /**
- * Records joystick information into global variables for auton recorder and for robot motion
+ * Works out the driver's command from the snapshot taken by driverInputPoll() and publishes it as
+ * COMMAND_SOURCE_DRIVER, for the auton recorder and for robot motion
  */
 void recordJoyInfo() {
-	spd = joystickGetAnalog(1, 3);
-	horizontal = pow(joystickGetAnalog(1, 4) / 127.0, 4) * 127 * joystickGetAnalog(1, 4) / abs(joystickGetAnalog(1, 4));
-	turn = joystickGetAnalog(1, 1);
-
-  spd = IGNORE_LOW_VAL(spd);
-  horizontal = IGNORE_LOW_VAL(horizontal);
-  turn = IGNORE_LOW_VAL(turn);
+	unsigned long start = profileBegin();
+	const stickProfile* profile = stickGetProfile();
+	int spd = stickRead(1, 3, profile->forward);
+	int horizontal = stickRead(1, 4, profile->horizontal);
+	int turn = stickRead(1, 1, profile->turn);
+	// Recorded states stay relative to the robot, so routines play back the same whichever mode they were driven in
+	if (driveIsFieldCentric()) {
+		driveFieldToRobot(&spd, &horizontal);
+	}
 
-	if (joystickGetDigital(1, 5, JOY_UP) == true || joystickGetDigital(2, 5, JOY_UP) == true) {
+	int sht;
+	if (driverHeld(DRIVER_PINCER_FORWARD)) {
 		sht = 127;
-	} else if (joystickGetDigital(1, 5, JOY_DOWN) == true || joystickGetDigital(2, 5, JOY_DOWN) == true) {
+	} else if (driverHeld(DRIVER_PINCER_BACK)) {
 		sht = -127;
-	} else if(joystickGetDigital(1, 8, JOY_DOWN) == true ||joystickGetDigital(2, 8, JOY_DOWN) == true) {
+	} else if (driverHeld(DRIVER_PINCER_BACK_SLOW)) {
 		sht = -40;
-  	} else if(joystickGetDigital(1, 8, JOY_UP) == true || joystickGetDigital(2, 8, JOY_UP) == true) {
-    	sht = 40;
-  	} else {
+	} else if (driverHeld(DRIVER_PINCER_FORWARD_SLOW)) {
+		sht = 40;
+	} else {
 		sht = 0;
 	}
 
-	if (joystickGetDigital(1, 6, JOY_UP) == true || joystickGetDigital(2, 6, JOY_UP) == true) {
+	if (driverPressed(DRIVER_LIFT_PRESET_UP)) {
+		liftPreset = liftNextPreset(1);
+	} else if (driverPressed(DRIVER_LIFT_PRESET_DOWN)) {
+		liftPreset = liftNextPreset(-1);
+	}
+
+	int lift;
+	if (driverHeld(DRIVER_LIFT_UP)) {
 		lift = -1;
-	} else if (joystickGetDigital(1, 6, JOY_DOWN) == true || joystickGetDigital(2, 6, JOY_DOWN) == true) {
+		liftPreset = -1;
+	} else if (driverHeld(DRIVER_LIFT_DOWN)) {
 		lift = 1;
+		liftPreset = -1;
+	} else if (liftPreset >= 0) {
+		lift = LIFT_PRESET_COMMAND(liftPreset);
 	} else {
 		lift = 0;
 	}
+
+	joyState command = { .spd = spd, .turn = turn, .horizontal = horizontal, .sht = sht, .lift = lift };
+	commandPublish(COMMAND_SOURCE_DRIVER, &command);
+	profileEnd(PROFILE_JOY_INFO, start);
 }
 
 /**
- * Move robot based on collected joystick information or based on replayed information from auton recorder
+ * Move robot based on collected joystick information or based on replayed information from auton recorder, as chosen
+ * by commandArbitrate()
+ *
+ * @param period the period in milliseconds of the calling loop, which sets how far the motors ramp this tick
  */
-void moveRobot() {
-	setLiftMotors(lift);
-	setPincerMotors(sht);
-	setDriveMotors(spd, horizontal, turn);
+void moveRobot(unsigned long period) {
+	unsigned long start = profileBegin();
+	joyState command;
+	commandArbitrate(&command);
+	liftCommand(command.lift);
+	setLiftMotors(liftControlPower());
+	setPincerMotors(command.sht);
+	setDriveMotors(command.spd, command.horizontal, command.turn);
+	motorOutputCommit(period);
+	profileEnd(PROFILE_MOVE_ROBOT, start);
 }
 
 /**
  * Runs the operator control loop
  */
 void operatorControl() {
+	// The driver can load a routine from the joystick, which must not race the boot preload
+	waitAutonPreload();
+	// A mode switch kills the task that was using the LCD without giving it a chance to unlock it
+	unlockLCDMenu();
+	// The kernel stops the motors when the robot is disabled, so forget what the command table last sent
+	motorOutputStopAll();
+	// A late tick only needs the latest sticks, so the ticks it missed are skipped rather than run back to back
+	deadlineMonitor monitor;
+	deadlineStart(&monitor, "Driver", 20, false);
 	while (1) {
-		if (joystickGetDigital(1, 7, JOY_RIGHT) && !isOnline()) {
-			recordAuton();
-			saveAuton();
+		driverInputPoll();
+		if (driverHeld(DRIVER_RECORD) && !isOnline()) {
+			lockLCDMenu();
+			recordAndSaveAuton();
+			unlockLCDMenu();
 		}
-		if (joystickGetDigital(1, 7, JOY_LEFT)) {
+		if (driverHeld(DRIVER_PLAYBACK)) {
+			lockLCDMenu();
 			loadAuton(selectAuton(false));
 			playbackAuton();
+			unlockLCDMenu();
 		}
-		updateLCDMenu(20);
+		runLCDMenuActions();
 		recordJoyInfo();
-		moveRobot();
-		delay(20);
+		moveRobot(monitor.timer.period);
+		deadlineWait(&monitor);
 	}
 }
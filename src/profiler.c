@@ -0,0 +1,147 @@
+/** @file profiler.c
+ * @brief File for the control loop stage profiler
+ *
+ * Keeps a profileStats struct per stage. A reset is requested with a flag per stage and carried out by the task that
+ * records the stage, so that a reset from the LCD task never races a sample being added on the control task.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * The statistics of every stage
+ */
+static profileStats stageStats[PROFILE_NUM_STAGES];
+
+/**
+ * Set for each stage whose statistics should be cleared before its next sample
+ */
+static volatile bool resetRequested[PROFILE_NUM_STAGES];
+
+/**
+ * The display names of the stages, at most 8 characters so that they fit on the LCD with a miss count
+ */
+static const char* const stageNames[PROFILE_NUM_STAGES] = { "Joy info", "Move", "LCD menu", "Playback" };
+
+/**
+ * The time budget of each stage in microseconds; samples over the budget are counted as deadline misses
+ * The playback budget is the shortest playback period, the event playback tick.
+ */
+static const unsigned long stageBudgets[PROFILE_NUM_STAGES] = {
+	1000, 1000, LCD_MENU_PERIOD * 1000UL, 1000000UL / AUTON_EVENT_PLAYBACK_FREQ
+};
+
+/**
+ * Clears the statistics of a stage
+ *
+ * @param stats the statistics to clear
+ */
+static void clearStats(profileStats* stats) {
+	memset(stats, 0, sizeof(profileStats));
+}
+
+#ifdef PROFILER_ENABLED
+/**
+ * Finishes timing a stage and records the sample
+ *
+ * @param stage the stage that was timed
+ * @param start the value returned by profileBegin()
+ */
+void profileEnd(profileStage stage, unsigned long start) {
+	unsigned long duration = micros() - start;
+	profileStats* stats = &stageStats[stage];
+	if (resetRequested[stage]) {
+		clearStats(stats);
+		resetRequested[stage] = false;
+	}
+
+	stats->count++;
+	stats->total += duration;
+	stats->min = (stats->count == 1) ? duration : MIN(stats->min, duration);
+	stats->max = MAX(stats->max, duration);
+	if (duration > stageBudgets[stage]) {
+		stats->misses++;
+	}
+	stats->buckets[MIN(duration / PROFILE_BUCKET_WIDTH, PROFILE_NUM_BUCKETS - 1)]++;
+}
+#endif
+
+/**
+ * Copies the statistics of a stage
+ *
+ * @param stage the stage to copy
+ * @param stats receives the statistics
+ */
+void profileGetStats(profileStage stage, profileStats* stats) {
+	if (resetRequested[stage]) {
+		clearStats(stats);
+		return;
+	}
+	memcpy(stats, &stageStats[stage], sizeof(profileStats));
+}
+
+/**
+ * Estimates the 99th percentile duration of a stage from its histogram
+ *
+ * @param stats the statistics of the stage
+ *
+ * @return the upper edge of the bucket holding the 99th percentile, in microseconds, capped at the longest sample
+ */
+unsigned long profileP99(const profileStats* stats) {
+	if (stats->count == 0) {
+		return 0;
+	}
+	// The number of samples that may lie above the 99th percentile, rounded down
+	unsigned long above = stats->count / 100;
+	unsigned long seen = 0;
+	for (int i = PROFILE_NUM_BUCKETS - 1; i > 0; i--) {
+		seen += stats->buckets[i];
+		if (seen > above) {
+			return MIN((unsigned long) (i + 1) * PROFILE_BUCKET_WIDTH, stats->max);
+		}
+	}
+	return MIN((unsigned long) PROFILE_BUCKET_WIDTH, stats->max);
+}
+
+/**
+ * Gets the display name of a stage
+ *
+ * @param stage the stage
+ *
+ * @return the name of the stage
+ */
+const char* profileStageName(profileStage stage) {
+	return stageNames[stage];
+}
+
+/**
+ * Clears the statistics of every stage
+ * Each stage is cleared by the task that records it at its next sample, so this is safe to call from any task.
+ */
+void profileReset() {
+	for (int i = 0; i < PROFILE_NUM_STAGES; i++) {
+		resetRequested[i] = true;
+	}
+}
+
+/**
+ * Prints the statistics and histogram of every stage to the serial port
+ */
+void profileReport() {
+	profileStats stats;
+	printf("Stage profile (us, %d us buckets):\n", PROFILE_BUCKET_WIDTH);
+	for (int i = 0; i < PROFILE_NUM_STAGES; i++) {
+		profileGetStats(i, &stats);
+		if (stats.count == 0) {
+			printf("%s: no samples\n", stageNames[i]);
+			continue;
+		}
+		printf("%s: %lu samples, min %lu mean %lu p99 %lu max %lu, %lu over %lu us\n", stageNames[i], stats.count,
+				stats.min, stats.total / stats.count, profileP99(&stats), stats.max, stats.misses, stageBudgets[i]);
+		printf("  ");
+		for (int j = 0; j < PROFILE_NUM_BUCKETS; j++) {
+			printf("%lu ", stats.buckets[j]);
+		}
+		printf("\n");
+	}
+}
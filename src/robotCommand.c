@@ -0,0 +1,195 @@
+/** @file robotCommand.c
+ * @brief File for the command shared between the sources that drive the robot and the code that moves it
+ *
+ * A reader can only be made to copy again by a writer that finished publishing while it was copying, so unlike the
+ * sensor snapshot, which readers retry while a write is in progress, a reader never spins on a writer it has
+ * interrupted and commands can be read from a task of any priority.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * A published command
+ */
+typedef struct commandEntry {
+	/**
+	 * The command
+	 */
+	joyState command;
+
+	/**
+	 * The time in milliseconds at which the command was published
+	 */
+	unsigned long time;
+
+	/**
+	 * False once the source has withdrawn its command
+	 */
+	bool active;
+} commandEntry;
+
+/**
+ * The double buffered command of a source
+ */
+typedef struct commandSlot {
+	/**
+	 * The latest command is in entries[sequence % 2], and the writer fills in the other one
+	 */
+	commandEntry entries[2];
+
+	/**
+	 * The number of commands published, incremented after each entry is filled in
+	 */
+	unsigned long sequence;
+} commandSlot;
+
+/**
+ * The slot of every source; none has been published until its sequence number is counted up from 0
+ */
+static volatile commandSlot slots[COMMAND_NUM_SOURCES];
+
+/**
+ * How the driver's and the playback's commands are combined
+ */
+static volatile commandPolicy policy = COMMAND_POLICY_PLAYBACK;
+
+/**
+ * Fills in the unpublished entry of a slot and publishes it
+ *
+ * @param source the slot to publish in
+ * @param entry the entry to publish
+ */
+static void publishEntry(commandSource source, const commandEntry* entry) {
+	volatile commandSlot* slot = &slots[source];
+	unsigned long sequence = slot->sequence;
+	memcpy((void*) &slot->entries[(sequence + 1) % 2], entry, sizeof(commandEntry));
+	__sync_synchronize();
+	slot->sequence = sequence + 1;
+}
+
+/**
+ * Publishes a new command from a source; only the one task that owns the source may call this
+ *
+ * @param source the COMMAND_SOURCE_* slot to publish in
+ * @param command the command
+ */
+void commandPublish(commandSource source, const joyState* command) {
+	if (source < COMMAND_NUM_SOURCES) {
+		commandEntry entry = { .command = *command, .time = millis(), .active = true };
+		publishEntry(source, &entry);
+	}
+}
+
+/**
+ * Withdraws the command of a source, so that it is ignored until it is published again
+ *
+ * @param source the COMMAND_SOURCE_* slot to withdraw
+ */
+void commandWithdraw(commandSource source) {
+	if (source < COMMAND_NUM_SOURCES) {
+		commandEntry entry = { .time = millis(), .active = false };
+		publishEntry(source, &entry);
+	}
+}
+
+/**
+ * Copies the latest command of a source without blocking
+ *
+ * @param source the slot to read
+ * @param now the time in milliseconds to judge whether the command is stale by
+ * @param command filled in with the command, or with a stopped command if the source is withdrawn or stale
+ *
+ * @return true if the source has a fresh command
+ */
+static bool readEntry(commandSource source, unsigned long now, joyState* command) {
+	memset(command, 0, sizeof(joyState));
+	if (source >= COMMAND_NUM_SOURCES) {
+		return false;
+	}
+	volatile commandSlot* slot = &slots[source];
+	commandEntry entry;
+	unsigned long sequence;
+	do {
+		sequence = slot->sequence;
+		__sync_synchronize();
+		memcpy(&entry, (const void*) &slot->entries[sequence % 2], sizeof(commandEntry));
+		__sync_synchronize();
+	} while (sequence != slot->sequence);
+	if (sequence == 0 || !entry.active || now - entry.time > COMMAND_STALE_TIME) {
+		return false;
+	}
+	*command = entry.command;
+	return true;
+}
+
+/**
+ * Copies the latest command of a source without blocking
+ *
+ * @param source the COMMAND_SOURCE_* slot to read
+ * @param command filled in with the command, or with a stopped command if the source is withdrawn or stale
+ *
+ * @return true if the source has a fresh command
+ */
+bool commandRead(commandSource source, joyState* command) {
+	return readEntry(source, millis(), command);
+}
+
+/**
+ * Gets whether a command moves anything, which is how the driver shows that they want to take over
+ *
+ * @param command the command
+ *
+ * @return true if any of the drive axes, the pincer or the lift is commanded
+ */
+static bool commandMoves(const joyState* command) {
+	return command->spd != 0 || command->horizontal != 0 || command->turn != 0 || command->sht != 0
+			|| command->lift != 0;
+}
+
+/**
+ * Combines the fresh commands of the driver and the playback by the arbitration policy and publishes the result
+ *
+ * @param command filled in with the command to move the robot with, which is stopped if neither source is fresh
+ */
+void commandArbitrate(joyState* command) {
+	unsigned long now = millis();
+	joyState driver, playback;
+	bool driverFresh = readEntry(COMMAND_SOURCE_DRIVER, now, &driver);
+	bool playbackFresh = readEntry(COMMAND_SOURCE_PLAYBACK, now, &playback);
+	if (!playbackFresh) {
+		*command = driver;
+	} else if (!driverFresh || policy == COMMAND_POLICY_PLAYBACK) {
+		*command = playback;
+	} else if (policy == COMMAND_POLICY_OVERRIDE) {
+		*command = commandMoves(&driver) ? driver : playback;
+	} else {
+		command->spd = CLAMP(playback.spd + driver.spd, -127, 127);
+		command->horizontal = CLAMP(playback.horizontal + driver.horizontal, -127, 127);
+		command->turn = CLAMP(playback.turn + driver.turn, -127, 127);
+		command->sht = (driver.sht != 0) ? driver.sht : playback.sht;
+		command->lift = (driver.lift != 0) ? driver.lift : playback.lift;
+	}
+	commandEntry output = { .command = *command, .time = now, .active = true };
+	publishEntry(COMMAND_SOURCE_OUTPUT, &output);
+}
+
+/**
+ * Sets how the driver's and the playback's commands are combined
+ *
+ * @param newPolicy the COMMAND_POLICY_* policy
+ */
+void commandSetPolicy(commandPolicy newPolicy) {
+	if (newPolicy < COMMAND_NUM_POLICIES) {
+		policy = newPolicy;
+	}
+}
+
+/**
+ * Gets how the driver's and the playback's commands are combined
+ *
+ * @return the COMMAND_POLICY_* policy
+ */
+commandPolicy commandGetPolicy() {
+	return policy;
+}
@@ -0,0 +1,164 @@
+/** @file sensors.c
+ * @brief File for the high-rate sensor acquisition task
+ *
+ * The PROS drivers already count encoder edges and time ultrasonic echoes in interrupts and poll the IMEs in the
+ * background, so sampling is a matter of copying their latest values into a snapshot at a steady rate. The sampling
+ * task runs at TASK_PRIORITY_HIGHEST so that every reader runs below it; a reader that is interrupted part way
+ * through copying a snapshot therefore always finds the sequence number changed and copies again, while the sampler
+ * itself never waits for a reader.
+ */
+
+#include "main.h"
+#include <string.h>
+
+/**
+ * Milliseconds between samples
+ */
+#define SENSOR_SAMPLE_PERIOD (1000 / SENSOR_SAMPLE_FREQ)
+
+/**
+ * Stack size in words of the sampling task, which only calls the sensor functions and never prints
+ */
+#define SENSOR_TASK_STACK_SIZE 256
+
+/**
+ * The number of IMEs found
+ */
+static unsigned int numImes = 0;
+
+/**
+ * The drive gyro, or NULL if there is no gyro
+ */
+static Gyro gyro = NULL;
+
+/**
+ * The lift quadrature encoder, or NULL if there is no encoder
+ */
+static Encoder encoder = NULL;
+
+/**
+ * The ultrasonic sensor, or NULL if there is no ultrasonic sensor
+ */
+static Ultrasonic ultrasonic = NULL;
+
+/**
+ * The latest snapshot, only valid while snapshotSequence is even
+ */
+static volatile sensorSnapshot latest;
+
+/**
+ * Incremented before and after latest is written, so it is odd while a write is in progress
+ */
+static volatile unsigned long snapshotSequence = 0;
+
+/**
+ * Publishes a sample as the latest snapshot
+ *
+ * @param sample the sample to publish
+ */
+static void publishSnapshot(const sensorSnapshot* sample) {
+	snapshotSequence++;
+	__sync_synchronize();
+	memcpy((void*) &latest, sample, sizeof(sensorSnapshot));
+	__sync_synchronize();
+	snapshotSequence++;
+}
+
+/**
+ * Samples every sensor that was found
+ *
+ * @param sample filled in with the values of the sensors
+ */
+static void sampleSensors(sensorSnapshot* sample) {
+	sample->time = micros();
+	for (unsigned int i = 0; i < SENSOR_NUM_IMES; i++) {
+		if (i >= numImes || !imeGet(i, &sample->imes[i])) {
+			sample->imes[i] = 0;
+		}
+	}
+	sample->gyro = (gyro != NULL) ? gyroGet(gyro) : 0;
+	sample->encoder = (encoder != NULL) ? encoderGet(encoder) : 0;
+	sample->ultrasonic = (ultrasonic != NULL) ? ultrasonicGet(ultrasonic) : 0;
+}
+
+/**
+ * Samples the sensors every SENSOR_SAMPLE_PERIOD and publishes each sample
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void sensorTask(void* ignore) {
+	sensorSnapshot sample;
+	// initSensors() published the first sample
+	sample.sample = 1;
+	unsigned long wakeTime = millis();
+	while (true) {
+		sampleSensors(&sample);
+		publishSnapshot(&sample);
+		sample.sample++;
+		// Only the latest sample matters, so a late sample skips the ones it missed instead of catching up on them
+		if (millis() - wakeTime > SENSOR_SAMPLE_PERIOD) {
+			wakeTime = millis();
+		}
+		taskDelayUntil(&wakeTime, SENSOR_SAMPLE_PERIOD);
+	}
+}
+
+/**
+ * Initializes the sensors and starts the sampling task. Must be called from initialize() before anything reads the
+ * sensors.
+ */
+void initSensors() {
+	numImes = imeInitializeAll();
+	if (DRIVE_GYRO_PORT != 0) {
+		gyro = gyroInit(DRIVE_GYRO_PORT, 0);
+	}
+	if (SENSOR_ENCODER_TOP_PORT != 0) {
+		encoder = encoderInit(SENSOR_ENCODER_TOP_PORT, SENSOR_ENCODER_BOTTOM_PORT, false);
+	}
+	if (SENSOR_ULTRASONIC_ECHO_PORT != 0) {
+		ultrasonic = ultrasonicInit(SENSOR_ULTRASONIC_ECHO_PORT, SENSOR_ULTRASONIC_PING_PORT);
+	}
+	LOG_INFO("Sensors: %d IMEs found, gyro on port %d, encoder on port %d, ultrasonic on port %d\n", (int) numImes,
+			DRIVE_GYRO_PORT, SENSOR_ENCODER_TOP_PORT, SENSOR_ULTRASONIC_ECHO_PORT);
+
+	// Publish a first snapshot so readers never see an empty one
+	sensorSnapshot sample;
+	sample.sample = 0;
+	sampleSensors(&sample);
+	publishSnapshot(&sample);
+	taskCreate(sensorTask, SENSOR_TASK_STACK_SIZE, NULL, TASK_PRIORITY_HIGHEST);
+}
+
+/**
+ * Gets the number of IMEs that were found when the sensors were initialized
+ *
+ * @return the number of IMEs chained to the Cortex
+ */
+unsigned int sensorImeCount() {
+	return numImes;
+}
+
+/**
+ * Gets whether the drive gyro was initialized
+ *
+ * @return true if the gyro heading is sampled, false otherwise
+ */
+bool sensorGyroPresent() {
+	return gyro != NULL;
+}
+
+/**
+ * Copies the latest snapshot without blocking. Must not be called from a task with a higher priority than the
+ * sampling task, which runs at TASK_PRIORITY_HIGHEST.
+ *
+ * @param snapshot filled in with the latest sample of every sensor
+ */
+void readSensors(sensorSnapshot* snapshot) {
+	unsigned long sequence;
+	do {
+		sequence = snapshotSequence;
+		__sync_synchronize();
+		memcpy(snapshot, (const void*) &latest, sizeof(sensorSnapshot));
+		__sync_synchronize();
+	} while ((sequence & 1) != 0 || sequence != snapshotSequence);
+}
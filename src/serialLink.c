@@ -0,0 +1,120 @@
+/** @file serialLink.c
+ * @brief File for the robot end of the framed serial link
+ *
+ * Received bytes are read from the UART in blocks and fed through a linkDecoder. Waiting polls the UART once per
+ * millisecond, so other tasks keep running while a transfer is in progress.
+ */
+
+#include "main.h"
+
+/**
+ * Decodes the frames received over the link
+ */
+static linkDecoder decoder;
+
+/**
+ * Bytes read from the UART that have not been decoded yet
+ */
+static uint8_t receiveBuffer[64];
+
+/**
+ * Index of the next byte to decode in receiveBuffer and the number of valid bytes in it
+ */
+static int receiveIndex, receiveLength;
+
+/**
+ * Opens the link UART; called from initializeIO()
+ */
+void serialLinkInit() {
+	usartInit(SERIAL_LINK_PORT, SERIAL_LINK_BAUD, SERIAL_8N1);
+	linkDecoderReset(&decoder);
+}
+
+/**
+ * Discards any bytes that have been received but not read, such as the remains of an abandoned transfer
+ */
+void serialLinkFlush() {
+	int available;
+	while ((available = fcount(SERIAL_LINK_PORT)) > 0) {
+		fread(receiveBuffer, 1, MIN(available, (int) sizeof(receiveBuffer)), SERIAL_LINK_PORT);
+	}
+	receiveIndex = receiveLength = 0;
+	linkDecoderReset(&decoder);
+}
+
+/**
+ * Sends a frame
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ */
+void serialLinkSend(uint8_t type, uint8_t seq, const void* payload, int length) {
+	uint8_t buffer[LINK_MAX_FRAME];
+	int size = linkEncode(buffer, type, seq, payload, length);
+	fwrite(buffer, 1, size, SERIAL_LINK_PORT);
+}
+
+/**
+ * Waits for the next frame
+ *
+ * @param frame receives the frame
+ * @param timeout the longest time to wait in milliseconds
+ *
+ * @return LINK_DECODE_FRAME if a frame was received, LINK_DECODE_CORRUPT if a corrupt frame was received, or
+ * LINK_DECODE_PENDING if nothing arrived before the timeout
+ */
+int serialLinkReceive(linkFrame* frame, unsigned long timeout) {
+	unsigned long start = millis();
+	while (true) {
+		while (receiveIndex < receiveLength) {
+			int result = linkDecode(&decoder, receiveBuffer[receiveIndex++]);
+			if (result == LINK_DECODE_FRAME) {
+				*frame = decoder.frame;
+			}
+			if (result != LINK_DECODE_PENDING) {
+				return result;
+			}
+		}
+		int available = fcount(SERIAL_LINK_PORT);
+		if (available > 0) {
+			receiveIndex = 0;
+			receiveLength = fread(receiveBuffer, 1, MIN(available, (int) sizeof(receiveBuffer)), SERIAL_LINK_PORT);
+		} else if (millis() - start >= timeout) {
+			return LINK_DECODE_PENDING;
+		} else {
+			delay(1);
+		}
+	}
+}
+
+/**
+ * Sends a frame and waits for it to be acknowledged, sending it again after a NAK, a corrupt reply or LINK_TIMEOUT
+ * without a reply, up to LINK_MAX_RETRIES times
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ *
+ * @return the LINK_STATUS_* byte of the acknowledgement, or -1 if the frame was never acknowledged
+ */
+int serialLinkRequest(uint8_t type, uint8_t seq, const void* payload, int length) {
+	linkFrame reply;
+	for (int attempt = 0; attempt < LINK_MAX_RETRIES; attempt++) {
+		serialLinkSend(type, seq, payload, length);
+		unsigned long sent = millis();
+		unsigned long waited;
+		// Acknowledgements of earlier frames can arrive late after a retry, so skip them within the timeout
+		while ((waited = millis() - sent) < LINK_TIMEOUT) {
+			if (serialLinkReceive(&reply, LINK_TIMEOUT - waited) != LINK_DECODE_FRAME || reply.type == LINK_FRAME_NAK) {
+				break;
+			}
+			if (reply.type == LINK_FRAME_ACK && reply.seq == seq && reply.length >= 1) {
+				return reply.payload[0];
+			}
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,98 @@
+/** @file stickShaping.c
+ * @brief File for the joystick response curve lookup tables
+ *
+ * The tables are expanded from the curve macros in stickShaping.h by STICK_TABLE(), one entry per joystick value from
+ * -128 to 127. The joystick never reports -128, so that entry is clamped to the value for -127.
+ */
+
+#include "main.h"
+
+/**
+ * A single table entry: the curve applied to the clamped joystick value, followed by the deadband
+ */
+#define STICK_ENTRY(CURVE, X) IGNORE_LOW_VAL(CURVE(CLAMP((X), -127, 127)))
+
+/**
+ * Eight consecutive table entries starting at joystick value B
+ */
+#define STICK_ROW8(CURVE, B) \
+	STICK_ENTRY(CURVE, (B) + 0), STICK_ENTRY(CURVE, (B) + 1), STICK_ENTRY(CURVE, (B) + 2), STICK_ENTRY(CURVE, (B) + 3), \
+	STICK_ENTRY(CURVE, (B) + 4), STICK_ENTRY(CURVE, (B) + 5), STICK_ENTRY(CURVE, (B) + 6), STICK_ENTRY(CURVE, (B) + 7)
+
+/**
+ * Sixty-four consecutive table entries starting at joystick value B
+ */
+#define STICK_ROW64(CURVE, B) \
+	STICK_ROW8(CURVE, (B) + 0), STICK_ROW8(CURVE, (B) + 8), STICK_ROW8(CURVE, (B) + 16), STICK_ROW8(CURVE, (B) + 24), \
+	STICK_ROW8(CURVE, (B) + 32), STICK_ROW8(CURVE, (B) + 40), STICK_ROW8(CURVE, (B) + 48), STICK_ROW8(CURVE, (B) + 56)
+
+/**
+ * A full table initializer covering joystick values -128 to 127
+ */
+#define STICK_TABLE(CURVE) { \
+	STICK_ROW64(CURVE, -128), STICK_ROW64(CURVE, -64), STICK_ROW64(CURVE, 0), STICK_ROW64(CURVE, 64) \
+}
+
+/**
+ * Linear response curve with deadband
+ */
+const signed char stickCurveLinear[STICK_CURVE_SIZE] = STICK_TABLE(STICK_LINEAR);
+
+/**
+ * Cubic response curve with deadband
+ */
+const signed char stickCurveCubic[STICK_CURVE_SIZE] = STICK_TABLE(STICK_CUBIC);
+
+/**
+ * Quartic response curve with deadband
+ */
+const signed char stickCurveQuartic[STICK_CURVE_SIZE] = STICK_TABLE(STICK_QUARTIC);
+
+/**
+ * The driver profiles, starting with the default profile
+ */
+const stickProfile stickProfiles[STICK_NUM_PROFILES] = {
+	{ "Default", stickCurveLinear, stickCurveQuartic, stickCurveLinear },
+	{ "Smooth", stickCurveCubic, stickCurveQuartic, stickCurveCubic },
+	{ "Linear", stickCurveLinear, stickCurveLinear, stickCurveLinear }
+};
+
+/**
+ * The driver profile in use
+ */
+static const stickProfile* activeProfile = &stickProfiles[0];
+
+/**
+ * Shapes a joystick axis from the snapshot taken by driverInputPoll() with a response curve
+ *
+ * @param joystick the joystick to read (1 or 2)
+ * @param axis the axis to read (1 - 4)
+ * @param curve the response curve to shape the value with
+ *
+ * @return the shaped value of the axis from -127 to 127
+ */
+int stickRead(unsigned char joystick, unsigned char axis, const signed char* curve) {
+	return curve[driverAnalog(joystick, axis) + 128];
+}
+
+/**
+ * Gets the driver profile in use
+ *
+ * @return the active driver profile
+ */
+const stickProfile* stickGetProfile() {
+	return activeProfile;
+}
+
+/**
+ * Selects the driver profile to use
+ *
+ * @param index the index of the profile in stickProfiles; out of range values are ignored
+ */
+void stickSetProfile(int index) {
+	if (index < 0 || index >= STICK_NUM_PROFILES) {
+		return;
+	}
+	activeProfile = &stickProfiles[index];
+	LOG_INFO("Stick profile %d selected\n", index);
+}
@@ -0,0 +1,161 @@
+/** @file telemetry.c
+ * @brief File for the binary telemetry stream
+ *
+ * The ring buffer has one producer, the task running the watched loop, and one consumer, the writing task, so the
+ * two positions are each written by one task and need no locking. Frames are copied in whole, so the writer never
+ * sends part of a frame that has not been finished.
+ */
+
+#include "main.h"
+
+#ifdef TELEMETRY_ENABLED
+
+/**
+ * Stack size in words of the writing task, which only hands the UART bytes that are already encoded
+ */
+#define TELEMETRY_TASK_STACK_SIZE 256
+
+/**
+ * The encoded frames waiting to be written
+ */
+static uint8_t ring[TELEMETRY_BUFFER_SIZE];
+
+/**
+ * The position that the next frame will be copied to, only advanced by telemetryRecord()
+ */
+static volatile unsigned int ringHead = 0;
+
+/**
+ * The position of the next byte to write, only advanced by the writing task
+ */
+static volatile unsigned int ringTail = 0;
+
+/**
+ * Whether the stream is stopped for a file transfer
+ */
+static volatile bool paused = false;
+
+/**
+ * Whether the writing task may be in the middle of writing to the UART
+ */
+static volatile bool writing = false;
+
+/**
+ * The number of frames dropped because the ring buffer was full
+ */
+static volatile unsigned long dropped = 0;
+
+/**
+ * The sequence number of the next frame
+ */
+static uint8_t frameSeq = 0;
+
+/**
+ * Writes the ring buffer to the UART
+ *
+ * @param ignore Dummy parameter for taskCreate
+ */
+static void telemetryTask(void* ignore) {
+	while (true) {
+		writing = true;
+		__sync_synchronize();
+		while (!paused && ringTail != ringHead) {
+			unsigned int start = ringTail & (TELEMETRY_BUFFER_SIZE - 1);
+			unsigned int length = MIN(ringHead - ringTail, TELEMETRY_BUFFER_SIZE - start);
+			length = MIN(length, TELEMETRY_WRITE_SIZE);
+			fwrite(ring + start, 1, length, TELEMETRY_PORT);
+			__sync_synchronize();
+			ringTail += length;
+		}
+		writing = false;
+		delay(TELEMETRY_DRAIN_PERIOD);
+	}
+}
+
+/**
+ * Starts the task that writes the telemetry to the UART
+ */
+void initTelemetry() {
+	taskCreate(telemetryTask, TELEMETRY_TASK_STACK_SIZE, NULL, TASK_PRIORITY_LOWEST + 1);
+}
+
+/**
+ * Queues the telemetry frame of a tick, or drops it if the ring buffer is full
+ *
+ * @param monitor the monitor of the loop the tick belongs to
+ * @param work the time in microseconds that the work of the tick took
+ */
+void telemetryRecord(const deadlineMonitor* monitor, unsigned long work) {
+	// The sequence number counts shed and dropped ticks too, so the computer sees them as gaps
+	uint8_t seq = frameSeq++;
+	if (paused || deadlineShedding(DEADLINE_SHED_TELEMETRY)) {
+		return;
+	}
+
+	uint8_t payload[TELEMETRY_PAYLOAD];
+	linkPut32(payload + TELEMETRY_TIME, millis());
+	joyState command;
+	commandRead(COMMAND_SOURCE_OUTPUT, &command);
+	payload[TELEMETRY_STATE] = command.spd;
+	payload[TELEMETRY_STATE + 1] = command.horizontal;
+	payload[TELEMETRY_STATE + 2] = command.turn;
+	payload[TELEMETRY_STATE + 3] = command.sht;
+	payload[TELEMETRY_STATE + 4] = command.lift;
+	for (int i = 0; i < TELEMETRY_NUM_MOTORS; i++) {
+		payload[TELEMETRY_MOTORS + i] = (uint8_t) motorOutputGet(i + 1);
+	}
+	linkPut16(payload + TELEMETRY_BATTERY, powerLevelMain());
+	sensorSnapshot snapshot;
+	readSensors(&snapshot);
+	linkPut16(payload + TELEMETRY_GYRO, (uint16_t) snapshot.gyro);
+	linkPut32(payload + TELEMETRY_ENCODER, (uint32_t) snapshot.encoder);
+	linkPut16(payload + TELEMETRY_ULTRASONIC, (uint16_t) snapshot.ultrasonic);
+	for (int i = 0; i < TELEMETRY_NUM_IMES; i++) {
+		linkPut32(payload + TELEMETRY_IMES + 4 * i, (uint32_t) snapshot.imes[i]);
+	}
+	linkPut16(payload + TELEMETRY_WORK, MIN(work, 0xFFFFUL));
+	payload[TELEMETRY_PERIOD] = MIN(monitor->timer.period, 0xFFUL);
+	payload[TELEMETRY_SHED] = deadlineShedLevel();
+	linkPut16(payload + TELEMETRY_OVERRUNS, monitor->timer.overruns);
+
+	uint8_t frame[TELEMETRY_PAYLOAD + LINK_FRAME_OVERHEAD];
+	int size = linkEncode(frame, LINK_FRAME_TELEMETRY, seq, payload, TELEMETRY_PAYLOAD);
+	unsigned int head = ringHead;
+	if (TELEMETRY_BUFFER_SIZE - (head - ringTail) < (unsigned int) size) {
+		dropped++;
+		return;
+	}
+	for (int i = 0; i < size; i++) {
+		ring[(head + i) & (TELEMETRY_BUFFER_SIZE - 1)] = frame[i];
+	}
+	__sync_synchronize();
+	ringHead = head + size;
+}
+
+/**
+ * Stops or resumes the stream, waiting for the writing task to finish a write in progress before stopping
+ *
+ * @param stop true to stop sending, false to resume
+ */
+void telemetrySetPaused(bool stop) {
+	paused = stop;
+	__sync_synchronize();
+	if (stop) {
+		while (writing) {
+			delay(1);
+		}
+		// Nothing is being written, so the queued frames can be thrown away from this side
+		ringTail = ringHead;
+	}
+}
+
+/**
+ * Gets the number of frames dropped because the ring buffer was full
+ *
+ * @return the number of frames dropped since the robot started
+ */
+unsigned long telemetryDropped() {
+	return dropped;
+}
+
+#endif
@@ -0,0 +1,603 @@
+/** @file autonlink.c
+ * @brief File for the computer end of the autonomous file transfer link
+ *
+ * Moves autonomous files between a computer and the robot over the framed serial link in include/linkProtocol.h.
+ * Connect a USB serial adapter to the robot's SERIAL_LINK_PORT, choose Download Auton or Upload Auton on the robot's
+ * LCD, then run one of
+ *
+ *     autonlink [-p port] [-b baud] put <file>     send a file to the slot chosen on the robot
+ *     autonlink [-p port] [-b baud] get <file>     save the slot chosen on the robot to a file
+ *
+ * Files are transferred exactly as the robot stores them in flash, so a file fetched with get can be put back on any
+ * robot. A headerless file holding 750 packed states, as written by the old serial monitor upload, is also accepted.
+ * Exits with status 0 only if the robot confirmed the transfer.
+ *
+ * The robot also streams a telemetry frame for every tick of its control loop over the same port, which is saved as
+ * CSV, one row per tick, with one of
+ *
+ *     autonlink [-p port] [-b baud] telemetry <csv>    save the stream until interrupted with Ctrl-C
+ *     autonlink decode <capture> <csv>                 convert a raw capture of the port, such as from a logger
+ *
+ * Ticks that the robot skipped or that were lost on the way are counted from the gaps in the sequence numbers and
+ * reported when the stream ends.
+ */
+
+#include "linkProtocol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Serial port used when -p is not given
+ */
+#define DEFAULT_PORT "/dev/ttyUSB0"
+
+/**
+ * Baud rate used when -b is not given; must match SERIAL_LINK_BAUD on the robot
+ */
+#define DEFAULT_BAUD 460800
+
+/**
+ * Milliseconds to wait for the robot to start or answer a transfer, matching SERIAL_LINK_WAIT on the robot
+ */
+#define LINK_WAIT 30000
+
+/**
+ * Columns of the telemetry CSV, in the order that they are written
+ */
+#define TELEMETRY_COLUMNS "time_ms,seq,spd,horizontal,turn,sht,lift,m1,m2,m3,m4,m5,m6,m7,m8,m9,m10," \
+	"battery_mv,gyro,encoder,ultrasonic,ime1,ime2,ime3,ime4,work_us,period_ms,shed,overruns"
+
+/**
+ * The open serial port
+ */
+static int port = -1;
+
+/**
+ * Decodes the frames received from the robot
+ */
+static linkDecoder decoder;
+
+/**
+ * Bytes read from the serial port that have not been decoded yet
+ */
+static uint8_t receiveBuffer[512];
+
+/**
+ * Index of the next byte to decode in receiveBuffer and the number of valid bytes in it
+ */
+static int receiveIndex, receiveLength;
+
+/**
+ * Set by Ctrl-C to end the telemetry stream
+ */
+static volatile sig_atomic_t interrupted = 0;
+
+/**
+ * The number of telemetry frames saved
+ */
+static unsigned long telemetryFrames = 0;
+
+/**
+ * The number of ticks missing from the telemetry stream, from the gaps in the sequence numbers
+ */
+static unsigned long telemetryMissing = 0;
+
+/**
+ * The sequence number of the last telemetry frame, or -1 before the first frame
+ */
+static int telemetrySeq = -1;
+
+/**
+ * Gets the time from a monotonic clock
+ *
+ * @return the time in milliseconds
+ */
+static unsigned long millisNow() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000UL + now.tv_nsec / 1000000;
+}
+
+/**
+ * Converts a baud rate to its termios speed
+ *
+ * @param baud the baud rate
+ *
+ * @return the speed, or B0 if the rate is not supported
+ */
+static speed_t baudSpeed(int baud) {
+	switch (baud) {
+	case 9600: return B9600;
+	case 19200: return B19200;
+	case 38400: return B38400;
+	case 57600: return B57600;
+	case 115200: return B115200;
+	case 230400: return B230400;
+#ifdef B460800
+	case 460800: return B460800;
+#endif
+#ifdef B921600
+	case 921600: return B921600;
+#endif
+	default: return B0;
+	}
+}
+
+/**
+ * Opens the serial port in raw mode
+ *
+ * @param path the path of the serial port
+ * @param baud the baud rate
+ *
+ * @return true if the port was opened
+ */
+static bool openPort(const char* path, int baud) {
+	speed_t speed = baudSpeed(baud);
+	if (speed == B0) {
+		fprintf(stderr, "Unsupported baud rate %d\n", baud);
+		return false;
+	}
+	port = open(path, O_RDWR | O_NOCTTY);
+	if (port < 0) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	struct termios options;
+	if (tcgetattr(port, &options) == 0) {
+		cfmakeraw(&options);
+		cfsetispeed(&options, speed);
+		cfsetospeed(&options, speed);
+		options.c_cflag |= CLOCAL | CREAD;
+		options.c_cc[VMIN] = 0;
+		options.c_cc[VTIME] = 0;
+		tcsetattr(port, TCSANOW, &options);
+	}
+	tcflush(port, TCIOFLUSH);
+	linkDecoderReset(&decoder);
+	return true;
+}
+
+/**
+ * Sends a frame
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ */
+static void sendFrame(uint8_t type, uint8_t seq, const void* payload, int length) {
+	uint8_t buffer[LINK_MAX_FRAME];
+	int size = linkEncode(buffer, type, seq, payload, length);
+	for (int written = 0; written < size;) {
+		ssize_t count = write(port, buffer + written, size - written);
+		if (count < 0 && errno != EINTR && errno != EAGAIN) {
+			return;
+		}
+		written += (count > 0) ? count : 0;
+	}
+}
+
+/**
+ * Waits for the next frame
+ *
+ * @param frame receives the frame
+ * @param timeout the longest time to wait in milliseconds
+ *
+ * @return LINK_DECODE_FRAME if a frame was received, LINK_DECODE_CORRUPT if a corrupt frame was received, or
+ * LINK_DECODE_PENDING if nothing arrived before the timeout
+ */
+static int receiveFrame(linkFrame* frame, unsigned long timeout) {
+	unsigned long start = millisNow();
+	while (true) {
+		while (receiveIndex < receiveLength) {
+			int result = linkDecode(&decoder, receiveBuffer[receiveIndex++]);
+			if (result == LINK_DECODE_FRAME) {
+				*frame = decoder.frame;
+			}
+			if (result != LINK_DECODE_PENDING) {
+				return result;
+			}
+		}
+		unsigned long waited = millisNow() - start;
+		if (waited >= timeout) {
+			return LINK_DECODE_PENDING;
+		}
+		struct pollfd ready = { .fd = port, .events = POLLIN };
+		if (poll(&ready, 1, (int) (timeout - waited)) > 0) {
+			ssize_t count = read(port, receiveBuffer, sizeof(receiveBuffer));
+			receiveIndex = 0;
+			receiveLength = (count > 0) ? count : 0;
+		}
+	}
+}
+
+/**
+ * Sends a frame and waits for it to be acknowledged, sending it again after a NAK, a corrupt reply or LINK_TIMEOUT
+ * without a reply, until it has been sent attempts times
+ *
+ * @param type the LINK_FRAME_* type of the frame
+ * @param seq the sequence number of the frame
+ * @param payload the payload, which may be NULL if length is 0
+ * @param length the number of payload bytes, at most LINK_MAX_PAYLOAD
+ * @param attempts the most times to send the frame
+ *
+ * @return the LINK_STATUS_* byte of the acknowledgement, or -1 if the frame was never acknowledged
+ */
+static int request(uint8_t type, uint8_t seq, const void* payload, int length, int attempts) {
+	linkFrame reply;
+	for (int attempt = 0; attempt < attempts; attempt++) {
+		sendFrame(type, seq, payload, length);
+		unsigned long sent = millisNow();
+		unsigned long waited;
+		while ((waited = millisNow() - sent) < LINK_TIMEOUT) {
+			if (receiveFrame(&reply, LINK_TIMEOUT - waited) != LINK_DECODE_FRAME || reply.type == LINK_FRAME_NAK) {
+				break;
+			}
+			if (reply.type == LINK_FRAME_ACK && reply.seq == seq && reply.length >= 1) {
+				return reply.payload[0];
+			}
+		}
+	}
+	return -1;
+}
+
+/**
+ * Describes the result of a transfer
+ *
+ * @param status the LINK_STATUS_* byte the transfer ended with, or -1 if the robot stopped answering
+ *
+ * @return the description
+ */
+static const char* statusName(int status) {
+	switch (status) {
+	case LINK_STATUS_OK: return "ok";
+	case LINK_STATUS_REJECTED: return "rejected by the robot";
+	case LINK_STATUS_CORRUPT: return "corrupt, discarded by the robot";
+	default: return "no reply from the robot";
+	}
+}
+
+/**
+ * Sends a file to the robot
+ *
+ * @param path the file to send
+ *
+ * @return the process exit status
+ */
+static int putFile(const char* path) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+	static uint8_t data[LINK_MAX_FILE_SIZE];
+	size_t size = fread(data, 1, sizeof(data), file);
+	// A file that fills the buffer may go on past it, which the robot would not notice, so look for more
+	bool tooLarge = size == sizeof(data) && fgetc(file) != EOF;
+	bool failed = ferror(file);
+	fclose(file);
+	if (failed) {
+		fprintf(stderr, "Cannot read %s\n", path);
+		return 1;
+	}
+	if (tooLarge) {
+		fprintf(stderr, "%s is larger than the %d bytes that can be transferred\n", path, LINK_MAX_FILE_SIZE);
+		return 1;
+	}
+
+	printf("Waiting for the robot...\n");
+	uint8_t payload[4];
+	linkPut32(payload, size);
+	int status = request(LINK_FRAME_BEGIN, 0, payload, 4, LINK_WAIT / LINK_TIMEOUT);
+	unsigned long start = millisNow();
+	uint8_t seq = 1;
+	for (size_t sent = 0; status == LINK_STATUS_OK && sent < size; seq++) {
+		int length = (size - sent < LINK_MAX_PAYLOAD) ? (int) (size - sent) : LINK_MAX_PAYLOAD;
+		status = request(LINK_FRAME_DATA, seq, data + sent, length, LINK_MAX_RETRIES);
+		sent += length;
+	}
+	if (status == LINK_STATUS_OK) {
+		linkPut16(payload, linkCrc16(0xFFFF, data, size));
+		// The robot checks the whole file before answering, so allow it longer than a block
+		status = request(LINK_FRAME_END, seq, payload, 2, LINK_MAX_RETRIES * 4);
+	}
+	printf("Sent %zu bytes in %lu ms: %s\n", size, millisNow() - start, statusName(status));
+	return status == LINK_STATUS_OK ? 0 : 1;
+}
+
+/**
+ * Receives a file from the robot
+ *
+ * @param path the file to save to
+ *
+ * @return the process exit status
+ */
+static int getFile(const char* path) {
+	linkFrame frame;
+	int result;
+	printf("Waiting for the robot...\n");
+	unsigned long wait = millisNow();
+	while ((result = receiveFrame(&frame, LINK_TIMEOUT)) != LINK_DECODE_FRAME || frame.type != LINK_FRAME_BEGIN) {
+		if (millisNow() - wait >= LINK_WAIT) {
+			printf("%s\n", statusName(-1));
+			return 1;
+		}
+	}
+	uint32_t size = (frame.length >= 4) ? linkGet32(frame.payload) : LINK_MAX_FILE_SIZE + 1;
+	uint8_t status = (size <= LINK_MAX_FILE_SIZE) ? LINK_STATUS_OK : LINK_STATUS_REJECTED;
+	sendFrame(LINK_FRAME_ACK, 0, &status, 1);
+	if (status != LINK_STATUS_OK) {
+		fprintf(stderr, "The robot offered a %u byte file, which is too large\n", size);
+		return 1;
+	}
+
+	static uint8_t data[LINK_MAX_FILE_SIZE];
+	unsigned long start = millisNow();
+	uint32_t received = 0;
+	uint8_t expected = 1;
+	int failures = 0;
+	bool ended = false;
+	while (!ended && failures < LINK_MAX_RETRIES) {
+		result = receiveFrame(&frame, LINK_TIMEOUT);
+		if (result != LINK_DECODE_FRAME) {
+			if (result == LINK_DECODE_CORRUPT) {
+				sendFrame(LINK_FRAME_NAK, expected, NULL, 0);
+			}
+			failures++;
+			continue;
+		}
+		failures = 0;
+		if (frame.type == LINK_FRAME_DATA && frame.seq == expected) {
+			if (received + frame.length > size) {
+				status = LINK_STATUS_REJECTED;
+			} else {
+				memcpy(data + received, frame.payload, frame.length);
+				received += frame.length;
+			}
+			expected++;
+		} else if (frame.type == LINK_FRAME_END && frame.seq == expected) {
+			ended = true;
+			continue;
+		} else if (!((frame.type == LINK_FRAME_DATA && frame.seq == (uint8_t) (expected - 1)) || frame.type == LINK_FRAME_BEGIN)) {
+			sendFrame(LINK_FRAME_NAK, expected, NULL, 0);
+			continue;
+		}
+		sendFrame(LINK_FRAME_ACK, frame.seq, &status, 1);
+	}
+	if (!ended) {
+		printf("Received %u bytes in %lu ms: %s\n", received, millisNow() - start, statusName(-1));
+		return 1;
+	}
+
+	if (status == LINK_STATUS_OK && (received != size || frame.length < 2 || linkGet16(frame.payload) != linkCrc16(0xFFFF, data, size))) {
+		status = LINK_STATUS_CORRUPT;
+	}
+	if (status == LINK_STATUS_OK) {
+		FILE* file = fopen(path, "wb");
+		if (file == NULL || fwrite(data, 1, size, file) != size) {
+			fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+			status = LINK_STATUS_REJECTED;
+		}
+		if (file != NULL) {
+			fclose(file);
+		}
+	}
+	unsigned long elapsed = millisNow() - start;
+	uint8_t endSeq = frame.seq;
+	sendFrame(LINK_FRAME_ACK, endSeq, &status, 1);
+	// Answer repeats of the final frame in case the acknowledgement was lost
+	while (receiveFrame(&frame, 2 * LINK_TIMEOUT) != LINK_DECODE_PENDING) {
+		if (frame.type == LINK_FRAME_END && frame.seq == endSeq) {
+			sendFrame(LINK_FRAME_ACK, endSeq, &status, 1);
+		}
+	}
+	printf("Received %u bytes in %lu ms: %s\n", received, elapsed,
+		status == LINK_STATUS_CORRUPT ? "corrupt, discarded" : statusName(status));
+	return status == LINK_STATUS_OK ? 0 : 1;
+}
+
+/**
+ * Ends the telemetry stream on Ctrl-C
+ *
+ * @param signal the signal received
+ */
+static void interrupt(int signal) {
+	interrupted = 1;
+}
+
+/**
+ * Writes one telemetry frame as a row of the CSV, counting the ticks missing since the last frame
+ *
+ * @param csv the CSV file
+ * @param frame a LINK_FRAME_TELEMETRY frame
+ */
+static void writeTelemetry(FILE* csv, const linkFrame* frame) {
+	const uint8_t* payload = frame->payload;
+	if (telemetrySeq >= 0) {
+		telemetryMissing += (uint8_t) (frame->seq - telemetrySeq - 1);
+	}
+	telemetrySeq = frame->seq;
+	telemetryFrames++;
+	fprintf(csv, "%u,%u", linkGet32(payload + TELEMETRY_TIME), frame->seq);
+	for (int i = 0; i < TELEMETRY_STATE_FIELDS; i++) {
+		fprintf(csv, ",%d", (int8_t) payload[TELEMETRY_STATE + i]);
+	}
+	for (int i = 0; i < TELEMETRY_NUM_MOTORS; i++) {
+		fprintf(csv, ",%d", (int8_t) payload[TELEMETRY_MOTORS + i]);
+	}
+	fprintf(csv, ",%u,%d,%d,%u", linkGet16(payload + TELEMETRY_BATTERY), (int16_t) linkGet16(payload + TELEMETRY_GYRO),
+		(int32_t) linkGet32(payload + TELEMETRY_ENCODER), linkGet16(payload + TELEMETRY_ULTRASONIC));
+	for (int i = 0; i < TELEMETRY_NUM_IMES; i++) {
+		fprintf(csv, ",%d", (int32_t) linkGet32(payload + TELEMETRY_IMES + 4 * i));
+	}
+	fprintf(csv, ",%u,%u,%u,%u\n", linkGet16(payload + TELEMETRY_WORK), payload[TELEMETRY_PERIOD],
+		payload[TELEMETRY_SHED], linkGet16(payload + TELEMETRY_OVERRUNS));
+}
+
+/**
+ * Feeds one byte of the telemetry stream to the decoder, writing a row when it completes a telemetry frame
+ *
+ * @param csv the CSV file
+ * @param byte the byte received
+ */
+static void decodeTelemetry(FILE* csv, uint8_t byte) {
+	if (linkDecode(&decoder, byte) == LINK_DECODE_FRAME && decoder.frame.type == LINK_FRAME_TELEMETRY
+			&& decoder.frame.length >= TELEMETRY_PAYLOAD) {
+		writeTelemetry(csv, &decoder.frame);
+	}
+}
+
+/**
+ * Opens the telemetry CSV and writes its header
+ *
+ * @param path the file to save to
+ *
+ * @return the CSV file, or NULL if it could not be opened
+ */
+static FILE* openTelemetry(const char* path) {
+	FILE* csv = fopen(path, "w");
+	if (csv == NULL) {
+		fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+		return NULL;
+	}
+	fprintf(csv, "%s\n", TELEMETRY_COLUMNS);
+	return csv;
+}
+
+/**
+ * Closes the telemetry CSV and reports how much of the stream was saved
+ *
+ * @param csv the CSV file
+ *
+ * @return the process exit status, 0 if any frame was saved
+ */
+static int closeTelemetry(FILE* csv) {
+	fclose(csv);
+	fprintf(stderr, "Saved %lu telemetry frames, %lu ticks missing, %lu corrupt frames\n", telemetryFrames,
+		telemetryMissing, decoder.errors);
+	return telemetryFrames > 0 ? 0 : 1;
+}
+
+/**
+ * Saves the telemetry stream from the robot until interrupted
+ *
+ * @param path the CSV file to save to
+ *
+ * @return the process exit status
+ */
+static int saveTelemetry(const char* path) {
+	FILE* csv = openTelemetry(path);
+	if (csv == NULL) {
+		return 1;
+	}
+	signal(SIGINT, interrupt);
+	printf("Saving telemetry, press Ctrl-C to stop...\n");
+	while (!interrupted) {
+		struct pollfd ready = { .fd = port, .events = POLLIN };
+		if (poll(&ready, 1, LINK_TIMEOUT) <= 0) {
+			continue;
+		}
+		ssize_t count = read(port, receiveBuffer, sizeof(receiveBuffer));
+		for (ssize_t i = 0; i < count; i++) {
+			decodeTelemetry(csv, receiveBuffer[i]);
+		}
+	}
+	return closeTelemetry(csv);
+}
+
+/**
+ * Converts a raw capture of the telemetry stream to CSV
+ *
+ * @param capturePath the capture to read
+ * @param path the CSV file to save to
+ *
+ * @return the process exit status
+ */
+static int decodeCapture(const char* capturePath, const char* path) {
+	FILE* capture = fopen(capturePath, "rb");
+	if (capture == NULL) {
+		fprintf(stderr, "Cannot open %s: %s\n", capturePath, strerror(errno));
+		return 1;
+	}
+	FILE* csv = openTelemetry(path);
+	if (csv == NULL) {
+		fclose(capture);
+		return 1;
+	}
+	linkDecoderReset(&decoder);
+	size_t count;
+	while ((count = fread(receiveBuffer, 1, sizeof(receiveBuffer), capture)) > 0) {
+		for (size_t i = 0; i < count; i++) {
+			decodeTelemetry(csv, receiveBuffer[i]);
+		}
+	}
+	fclose(capture);
+	return closeTelemetry(csv);
+}
+
+/**
+ * Prints the usage of the tool
+ *
+ * @return the process exit status
+ */
+static int usage() {
+	fprintf(stderr, "usage: autonlink [-p port] [-b baud] put <file>\n"
+		"       autonlink [-p port] [-b baud] get <file>\n"
+		"       autonlink [-p port] [-b baud] telemetry <csv>\n"
+		"       autonlink decode <capture> <csv>\n");
+	return 2;
+}
+
+/**
+ * Parses the command line and runs the transfer or saves the telemetry
+ *
+ * @param argc the number of arguments
+ * @param argv the arguments
+ *
+ * @return the process exit status
+ */
+int main(int argc, char** argv) {
+	const char* path = DEFAULT_PORT;
+	int baud = DEFAULT_BAUD;
+	int option;
+	while ((option = getopt(argc, argv, "p:b:")) != -1) {
+		if (option == 'p') {
+			path = optarg;
+		} else if (option == 'b') {
+			baud = atoi(optarg);
+		} else {
+			return usage();
+		}
+	}
+	if (argc - optind == 3 && strcmp(argv[optind], "decode") == 0) {
+		return decodeCapture(argv[optind + 1], argv[optind + 2]);
+	}
+	if (argc - optind != 2) {
+		return usage();
+	}
+	if (!openPort(path, baud)) {
+		return 1;
+	}
+	setvbuf(stdout, NULL, _IONBF, 0);
+	int result;
+	if (strcmp(argv[optind], "put") == 0) {
+		result = putFile(argv[optind + 1]);
+	} else if (strcmp(argv[optind], "get") == 0) {
+		result = getFile(argv[optind + 1]);
+	} else if (strcmp(argv[optind], "telemetry") == 0) {
+		result = saveTelemetry(argv[optind + 1]);
+	} else {
+		result = usage();
+	}
+	close(port);
+	return result;
+}